@@ -0,0 +1,38 @@
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+// Pitido del sound timer generado en el callback de audio de SDL
+//
+// El hilo de emulación solo escribe una bandera atómica (suena / no suena);
+// el callback la lee al rellenar cada buffer, así que encender o apagar el
+// tono no cuesta ninguna llamada al sistema y surte efecto en el siguiente
+// buffer. La onda cuadrada lleva corrección polyBLEP en los flancos para no
+// generar aliasing y una rampa corta de volumen para no hacer clics
+
+#define AUDIO_SAMPLE_RATE 44100
+#define AUDIO_DEFAULT_SAMPLES 512   // Muestras por buffer (~11.6 ms a 44.1 kHz)
+#define AUDIO_TONE_FREQ 440.0       // Frecuencia del pitido (Hz)
+#define AUDIO_VOLUME 0.25           // Amplitud de la onda (1.0 = escala completa)
+#define AUDIO_RAMP_SAMPLES 64       // Muestras de subida/bajada del volumen
+
+typedef struct {
+    SDL_AudioDeviceID device;       // 0 si no se pudo abrir (sin sonido)
+    SDL_atomic_t playing;           // Tono activo (lo escribe el hilo de emulación)
+    double phase;                   // Fase del oscilador en [0, 1) (solo el callback)
+    double step;                    // Avance de fase por muestra
+    double gain;                    // Volumen actual de la rampa en [0, 1] (solo el callback)
+} Audio;
+
+// Abrir el dispositivo con buffers de samples muestras (potencia de 2). Si
+// falla se avisa y el emulador sigue sin sonido
+bool audioInit(Audio* audio, int samples);
+
+// Encender o apagar el tono (desde el hilo de emulación)
+void audioSetTone(Audio* audio, bool on);
+
+void audioCleanup(Audio* audio);
+
+#endif // AUDIO_H
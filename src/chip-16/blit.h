@@ -0,0 +1,23 @@
+#ifndef BLIT_H
+#define BLIT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Expansión de la pantalla monocromo a píxeles RGBA8888 para las texturas SDL
+//
+// Los píxeles apagados quedan a 0 (negro) y los encendidos toman el color
+// dado, sin ramas por píxel. La variante se elige al compilar: AVX2 (-mavx2),
+// SSE2 (cualquier x86-64) o escalar (otras arquitecturas o -DBLIT_SCALAR).
+
+// Construir la tabla byte → 8 máscaras de píxel. Llamar una vez antes de
+// usar blitBitsToRGBA (displayInit lo hace)
+void blitInit(void);
+
+// Un byte por píxel (1 = encendido, como gfx[]) → count píxeles RGBA
+void blitBytesToRGBA(uint32_t* dst, const uint8_t* src, size_t count, uint32_t color);
+
+// Filas empaquetadas de 64 píxeles (bit 63 = columna 0) → rowCount * 64 píxeles RGBA
+void blitBitsToRGBA(uint32_t* dst, const uint64_t* rows, size_t rowCount, uint32_t color);
+
+#endif // BLIT_H
@@ -12,6 +12,7 @@ void chip16Init(Chip16 *chip16)
     chip16->config.clockSpeed = DEFAULT_SPEED;
     chip16->config.enableSound = true;
     chip16->config.pixelColor = DEFAULT_PIXEL_COLOR;
+    chip16->config.cycleTimers = false;
     chip16->mode = MODE_8BIT;
     
     // Inicializar registros y memoria
@@ -21,6 +22,8 @@ void chip16Init(Chip16 *chip16)
     memset(chip16->key, 0, KEY_COUNT);
     memset(chip16->stack, 0, STACK_SIZE * sizeof(uint16_t));
     memset(chip16->gfx2Buffer, 0, DISPLAY_WIDTH * DISPLAY_HEIGHT);
+    memset(chip16->icache, 0, sizeof(chip16->icache));
+    memset(&chip16->cacheStats, 0, sizeof(chip16->cacheStats));
     
     chip16->opcode = 0;
     chip16->I = 0;
@@ -29,6 +32,12 @@ void chip16Init(Chip16 *chip16)
     chip16->delayTimer = 0;
     chip16->soundTimer = 0;
     chip16->drawFlag = false;
+    chip16->dirtyRows = UINT32_MAX; // El primer render dibuja la pantalla completa
+    chip16->waitingKey = false;
+    chip16->runEvent = CHIP16_RUN_BUDGET;
+    chip16->runCycles = 0;
+    chip16->timerCountdown = 0;
+    chip16->timerRemainder = 0;
     chip16->currentEffect = EFFECT_NONE;
     chip16->effectTimer = 0;
     chip16->colorIndex = 0;
@@ -37,7 +46,7 @@ void chip16Init(Chip16 *chip16)
     memcpy(chip16->memory, chip16_fontset, FONTSET_SIZE);
 
     // Inicializar semilla para números aleatorios
-    srand(time(NULL));
+    chip16Seed(chip16, (uint32_t)time(NULL));
 }
 
 // Cargar ROM desde archivo
@@ -73,11 +82,42 @@ bool chip16LoadROM(Chip16 *chip16, const char *filename)
         return false;
     }
 
+    // La memoria ha cambiado: descartar instrucciones predecodificadas
+    chip16FlushCache(chip16);
+
     return true;
 }
 
-// Actualizar temporizadores
-void chip16UpdateTimers(Chip16 *chip16)
+// Invalidar toda la caché de instrucciones
+void chip16FlushCache(Chip16 *chip16)
+{
+    memset(chip16->icache, 0, sizeof(chip16->icache));
+}
+
+// Sembrar el generador pseudoaleatorio (xorshift32, el estado nunca puede ser 0)
+void chip16Seed(Chip16 *chip16, uint32_t seed)
+{
+    chip16->rngState = seed * 2654435761u ^ 0x9E3779B9u;
+    if (chip16->rngState == 0)
+    {
+        chip16->rngState = 1;
+    }
+}
+
+// Siguiente número del generador. Es parte del estado del núcleo (a
+// diferencia de rand()), así que un estado restaurado saca los mismos números
+static uint32_t chip16Random(Chip16 *chip16)
+{
+    uint32_t x = chip16->rngState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    chip16->rngState = x;
+    return x;
+}
+
+// Un tick de 60 Hz de DT y ST
+static void chip16TickTimers(Chip16 *chip16)
 {
     if (chip16->delayTimer > 0)
     {
@@ -86,21 +126,68 @@ void chip16UpdateTimers(Chip16 *chip16)
 
     if (chip16->soundTimer > 0)
     {
-        if (chip16->config.enableSound && chip16->soundTimer == 1)
-        {
-            // Aquí se implementaría la reproducción de sonido
-            printf("BEEP!\n");
-        }
         chip16->soundTimer--;
     }
 }
 
+// Actualizar temporizadores
+void chip16UpdateTimers(Chip16 *chip16)
+{
+    // En modo por instrucciones los ticks los genera chip16Run
+    if (!chip16->config.cycleTimers)
+    {
+        chip16TickTimers(chip16);
+    }
+}
+
+// Instrucciones hasta el siguiente tick: clockSpeed / TIMER_FREQ, arrastrando
+// la fracción para que en clockSpeed instrucciones haya exactamente TIMER_FREQ.
+// Como mucho un tick por instrucción, así que el resultado nunca es 0
+static void chip16ScheduleTimerTick(Chip16 *chip16)
+{
+    uint32_t rate = chip16->config.clockSpeed > TIMER_FREQ ? (uint32_t)chip16->config.clockSpeed : TIMER_FREQ;
+    chip16->timerRemainder += rate;
+    chip16->timerCountdown = chip16->timerRemainder / TIMER_FREQ;
+    chip16->timerRemainder %= TIMER_FREQ;
+}
+
+void chip16SetCycleTimers(Chip16 *chip16, bool enable)
+{
+    chip16->config.cycleTimers = enable;
+    chip16->timerCountdown = 0;
+    chip16->timerRemainder = 0;
+    chip16ScheduleTimerTick(chip16);
+}
+
+// Avanzar el reloj emulado cycles instrucciones (como mucho timerCountdown)
+static void chip16AdvanceTimers(Chip16 *chip16, uint32_t cycles)
+{
+    // Sin planificar todavía (chip16Init deja timerCountdown a 0)
+    if (chip16->timerCountdown == 0)
+    {
+        chip16ScheduleTimerTick(chip16);
+    }
+
+    chip16->timerCountdown -= cycles;
+    while (chip16->timerCountdown == 0)
+    {
+        chip16TickTimers(chip16);
+        chip16ScheduleTimerTick(chip16);
+    }
+}
+
 // Establecer estado de una tecla
 void chip16SetKey(Chip16 *chip16, uint8_t key, uint8_t value)
 {
     if (key < KEY_COUNT)
     {
         chip16->key[key] = value;
+
+        // Una pulsación despierta a un programa detenido en FX0A
+        if (value != 0)
+        {
+            chip16->waitingKey = false;
+        }
     }
 }
 
@@ -114,10 +201,10 @@ void chip16SetEffect(Chip16* chip16, GraphicsEffects effect) {
     }
 }
 
-void chip16ProcessEffects(Chip16* chip16) {
-    // SIEMPRE copiamos el buffer primario al de efectos
-    memcpy(chip16->gfx2Buffer, chip16->gfx, 
-           DISPLAY_WIDTH * DISPLAY_HEIGHT);
+bool chip16ProcessEffects(Chip16* chip16) {
+    // El ciclo de color solo cambia la paleta: se aplica al expandir los
+    // píxeles a RGBA y no necesita copiar el framebuffer. Un efecto que
+    // modifique píxeles escribiría aquí en gfx2Buffer y devolvería true
     
     // Si hay un efecto activo, actualizar su estado
     if (chip16->currentEffect == EFFECT_COLOR_CYCLE) {
@@ -138,665 +225,1420 @@ void chip16ProcessEffects(Chip16* chip16) {
             }
         }
     }
+    
+    return false;
 }
 
-// Ejecutar un ciclo de emulación
-void chip16Cycle(Chip16 *chip16)
-{
-    // Extraer opcode (2 bytes)
-    chip16->opcode = (chip16->memory[chip16->PC] << 8) | chip16->memory[chip16->PC + 1];
-
-    // Incrementar PC antes de ejecutar
-    chip16->PC += 2;
+// ============================================================================
+// MANEJADORES DE INSTRUCCIONES
+// ============================================================================
 
-    // Variables para decodificación del opcode
-    uint8_t x = (chip16->opcode & 0x0F00) >> 8;
-    uint8_t y = (chip16->opcode & 0x00F0) >> 4;
-    uint8_t n = chip16->opcode & 0x000F;
-    uint8_t kk = chip16->opcode & 0x00FF;
-    uint16_t nnn = chip16->opcode & 0x0FFF;
-
-    // Variables para el uso en instrucciones
-    uint16_t xPos, yPos, height, length, pattern, value, src, dst, count;
-    uint8_t shift, nParams;
-    uint32_t result, product;
-    uint16_t returnValue, memValue;
-    bool found;
-    uint8_t range;
-    int basePos, pixelPos, pixelX, pixelY;
-    uint16_t spriteData, activePattern, mask;
+// Marcar como modificadas count filas de pantalla a partir de y (y < DISPLAY_HEIGHT),
+// con wrap vertical. Las filas que pasan de la última vuelven a empezar por arriba
+static inline void chip16MarkRows(Chip16 *chip16, unsigned int y, unsigned int count)
+{
+    uint64_t mask = (count >= DISPLAY_HEIGHT) ? 0xFFFFFFFFULL : ((1ULL << count) - 1);
+    mask <<= y;
+    chip16->dirtyRows |= (uint32_t)(mask | (mask >> DISPLAY_HEIGHT));
+}
 
-    // Depuración si está habilitada
-    if (chip16->config.debugLevel >= DEBUG_OPCODES)
+// Invalidar las entradas de la caché que cubren [addr, addr + len).
+// Solo se anula el manejador: el resto de campos sigue siendo válido para una
+// instrucción que se esté ejecutando desde la entrada que sobrescribe.
+static inline void chip16InvalidateCode(Chip16 *chip16, uint32_t addr, uint32_t len)
+{
+    uint32_t end = addr + len;
+    if (end > MEMORY_SIZE)
     {
-        printf("Ejecutando opcode: 0x%04X en PC=0x%04X\n", chip16->opcode, chip16->PC - 2);
+        end = MEMORY_SIZE;
     }
 
-    // Decodificar e implementar opcode
-    switch (chip16->opcode & 0xF000)
+    for (uint32_t a = addr & ~1u; a < end; a += 2)
     {
-    case 0x0000:
-        switch (kk)
+        Chip16Instr *entry = &chip16->icache[a >> 1];
+        if (entry->handler != NULL)
         {
-        case 0x00E0: // 00E0: Limpiar pantalla
-            memset(chip16->gfx, 0, DISPLAY_WIDTH * DISPLAY_HEIGHT);
-            chip16->drawFlag = true;
-            break;
-
-        case 0x00EE: // 00EE: Retornar de subrutina
-            chip16->SP--;
-            chip16->PC = chip16->stack[chip16->SP];
-            break;
-        default:
-            if (chip16->config.debugLevel >= DEBUG_OPCODES)
-            {
-                printf("Opcode desconocido: 0x%04X\n", chip16->opcode);
-            }
+            entry->handler = NULL;
+            chip16->cacheStats.invalidations++;
         }
-        break;
-
-    case 0x1000: // 1NNN: Saltar a dirección NNN
-        chip16->PC = nnn;
-        break;
+    }
+}
 
-    case 0x2000: // 2NNN: Llamar subrutina en NNN
-        chip16->stack[chip16->SP] = chip16->PC;
-        chip16->SP++;
-        chip16->PC = nnn;
-        break;
+// Opcodes sin efecto (variantes no definidas)
+static void opNop(Chip16 *chip16, const Chip16Instr *ins)
+{
+    (void)chip16;
+    (void)ins;
+}
 
-    case 0x3000: // 3XKK: Saltar siguiente instrucción si VX == KK
-        if ((chip16->V[x] & 0xFF) == kk)
-        {
-            chip16->PC += 2;
-        }
-        break;
+// 0NNN: Opcode desconocido
+static void opUnknown(Chip16 *chip16, const Chip16Instr *ins)
+{
+    (void)ins;
+    chip16->runEvent = CHIP16_RUN_UNKNOWN_OPCODE;
+    if (chip16->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("Opcode desconocido: 0x%04X\n", chip16->opcode);
+    }
+}
 
-    case 0x4000: // 4XKK: Saltar siguiente instrucción si VX != KK
-        if (chip16->V[x] != kk)
-        {
-            chip16->PC += 2;
-        }
-        break;
+// 00E0: Limpiar pantalla
+static void opCls(Chip16 *chip16, const Chip16Instr *ins)
+{
+    (void)ins;
+    memset(chip16->gfx, 0, DISPLAY_WIDTH * DISPLAY_HEIGHT);
+    chip16->dirtyRows = UINT32_MAX;
+    chip16->drawFlag = true;
+    chip16->runEvent = CHIP16_RUN_DRAW;
+}
 
-    case 0x5000:
-        if (n == 0) // 5XY0: Saltar siguiente instrucción si VX == VY
-        {
-            if (chip16->V[x] == chip16->V[y])
-            {
-                chip16->PC += 2;
-            }
-        }
+// 00EE: Retornar de subrutina
+static void opRet(Chip16 *chip16, const Chip16Instr *ins)
+{
+    (void)ins;
+    chip16->SP--;
+    chip16->PC = chip16->stack[chip16->SP];
+}
 
-        else if (n == 1) // 5XY1: Multiplicación
-        {
-            result = (uint32_t)chip16->V[x] * (uint32_t)chip16->V[y];
-            chip16->V[x] = result & 0xFFFF;
-        }
+// 1NNN: Saltar a dirección NNN
+static void opJp(Chip16 *chip16, const Chip16Instr *ins)
+{
+    chip16->PC = ins->nnn;
+}
 
-        else if (n == 2) // 5XY2 : División
-        {
-            if (chip16->V[y] != 0)
-            {
-                chip16->V[0xF] = chip16->V[x] % chip16->V[y]; // Resto
-                chip16->V[x] = chip16->V[x] / chip16->V[y];   // Cociente
-            }
-            else
-            {
-                chip16->V[x] = 0xFFFF; // División por cero - ERROR
-                chip16->V[0xF] = 0;
-            }
-        }
+// 2NNN: Llamar subrutina en NNN
+static void opCall(Chip16 *chip16, const Chip16Instr *ins)
+{
+    chip16->stack[chip16->SP] = chip16->PC;
+    chip16->SP++;
+    chip16->PC = ins->nnn;
+}
 
-        else if (n == 3) // 5XY3 : Suma vectorial
-        {
-            uint16_t nextX = (x + 1) % REGISTER_COUNT;
-            uint16_t nextY = (y + 1) % REGISTER_COUNT;
+// 3XKK: Saltar siguiente instrucción si VX == KK
+static void opSeVxByte(Chip16 *chip16, const Chip16Instr *ins)
+{
+    if ((chip16->V[ins->x] & 0xFF) == ins->kk)
+    {
+        chip16->PC += 2;
+    }
+}
 
-            chip16->V[x] += chip16->V[y];
-            chip16->V[nextX] += chip16->V[nextY];
-        }
+// 4XKK: Saltar siguiente instrucción si VX != KK
+static void opSneVxByte(Chip16 *chip16, const Chip16Instr *ins)
+{
+    if (chip16->V[ins->x] != ins->kk)
+    {
+        chip16->PC += 2;
+    }
+}
 
-        else if (n == 4) // 5XY4 : PRoducto escalar
-        {
-            uint16_t nextX = (x + 1) % REGISTER_COUNT;
-            uint16_t nextY = (y + 1) % REGISTER_COUNT;
+// 5XY0: Saltar siguiente instrucción si VX == VY
+static void opSeVxVy(Chip16 *chip16, const Chip16Instr *ins)
+{
+    if (chip16->V[ins->x] == chip16->V[ins->y])
+    {
+        chip16->PC += 2;
+    }
+}
 
-            product = (uint32_t)chip16->V[x] * (uint32_t)chip16->V[y] + (uint32_t)chip16->V[nextX] * (uint32_t)chip16->V[nextY];
+// 5XY1: Multiplicación
+static void opMul(Chip16 *chip16, const Chip16Instr *ins)
+{
+    uint32_t result = (uint32_t)chip16->V[ins->x] * (uint32_t)chip16->V[ins->y];
+    chip16->V[ins->x] = result & 0xFFFF;
+}
 
-            chip16->V[x] = product & 0xFFFF;           // Producto escalar
-            chip16->V[0xF] = (product >> 16) & 0xFFFF; // Desbordamiento
-        }
-        break;
+// 5XY2 : División
+static void opDiv(Chip16 *chip16, const Chip16Instr *ins)
+{
+    if (chip16->V[ins->y] != 0)
+    {
+        chip16->V[0xF] = chip16->V[ins->x] % chip16->V[ins->y]; // Resto
+        chip16->V[ins->x] = chip16->V[ins->x] / chip16->V[ins->y]; // Cociente
+    }
+    else
+    {
+        chip16->V[ins->x] = 0xFFFF; // División por cero - ERROR
+        chip16->V[0xF] = 0;
+    }
+}
 
-    case 0x6000: // 6XKK: Establecer VX = KK
-        chip16->V[x] = kk;
-        break;
+// 5XY3 : Suma vectorial
+static void opVadd(Chip16 *chip16, const Chip16Instr *ins)
+{
+    uint16_t nextX = (ins->x + 1) % REGISTER_COUNT;
+    uint16_t nextY = (ins->y + 1) % REGISTER_COUNT;
 
-    case 0x7000: // 7XKK: Establecer VX = VX + KK
-        chip16->V[x] += kk;
-        break;
+    chip16->V[ins->x] += chip16->V[ins->y];
+    chip16->V[nextX] += chip16->V[nextY];
+}
 
-    case 0x8000:
-        switch (n)
-        {
-        case 0x0: // 8XY0: Establecer VX = VY
-            chip16->V[x] = chip16->V[y];
-            break;
+// 5XY4 : Producto escalar
+static void opDot(Chip16 *chip16, const Chip16Instr *ins)
+{
+    uint16_t nextX = (ins->x + 1) % REGISTER_COUNT;
+    uint16_t nextY = (ins->y + 1) % REGISTER_COUNT;
 
-        case 0x1: // 8XY1: Establecer VX = VX OR VY
-            chip16->V[x] |= chip16->V[y];
-            break;
+    uint32_t product = (uint32_t)chip16->V[ins->x] * (uint32_t)chip16->V[ins->y] + (uint32_t)chip16->V[nextX] * (uint32_t)chip16->V[nextY];
 
-        case 0x2: // 8XY2: Establecer VX = VX AND VY
-            chip16->V[x] &= chip16->V[y];
-            break;
+    chip16->V[ins->x] = product & 0xFFFF;           // Producto escalar
+    chip16->V[0xF] = (product >> 16) & 0xFFFF; // Desbordamiento
+}
 
-        case 0x3: // 8XY3: Establecer VX = VX XOR VY
-            chip16->V[x] ^= chip16->V[y];
-            break;
+// 6XKK: Establecer VX = KK
+static void opLdVxByte(Chip16 *chip16, const Chip16Instr *ins)
+{
+    chip16->V[ins->x] = ins->kk;
+}
 
-        case 0x4: // 8XY4: Establecer VX = VX + VY, VF = carry
-        {
-            int sum = chip16->V[x] + chip16->V[y];
-            chip16->V[0xF] = (sum > 0xFFFF) ? 1 : 0;
-            chip16->V[x] = sum & 0xFFFF;
-        }
-        break;
+// 7XKK: Establecer VX = VX + KK
+static void opAddVxByte(Chip16 *chip16, const Chip16Instr *ins)
+{
+    chip16->V[ins->x] += ins->kk;
+}
 
-        case 0x5: // 8XY5: Establecer VX = VX - VY, VF = not borrow
-            chip16->V[0xF] = (chip16->V[x] > chip16->V[y]) ? 1 : 0;
-            chip16->V[x] = (chip16->V[x] - chip16->V[y]) & 0xFFFF;
-            break;
+// 8XY0: Establecer VX = VY
+static void opLdVxVy(Chip16 *chip16, const Chip16Instr *ins)
+{
+    chip16->V[ins->x] = chip16->V[ins->y];
+}
 
-        case 0x6: // 8XY6: Desplazar VX a la derecha, VF = bit menos significativo
+// 8XY1: Establecer VX = VX OR VY
+static void opOr(Chip16 *chip16, const Chip16Instr *ins)
+{
+    chip16->V[ins->x] |= chip16->V[ins->y];
+}
 
-            chip16->V[0xF] = chip16->V[x] & 0x1;
-            chip16->V[x] >>= 1;
+// 8XY2: Establecer VX = VX AND VY
+static void opAnd(Chip16 *chip16, const Chip16Instr *ins)
+{
+    chip16->V[ins->x] &= chip16->V[ins->y];
+}
 
-            break;
+// 8XY3: Establecer VX = VX XOR VY
+static void opXor(Chip16 *chip16, const Chip16Instr *ins)
+{
+    chip16->V[ins->x] ^= chip16->V[ins->y];
+}
 
-        case 0x7: // 8XY7: Establecer VX = VY - VX, VF = not borrow
-            chip16->V[0xF] = (chip16->V[y] > chip16->V[x]) ? 1 : 0;
-            chip16->V[x] = chip16->V[y] - chip16->V[x];
-            break;
+// 8XY4: Establecer VX = VX + VY, VF = carry
+static void opAddVxVy(Chip16 *chip16, const Chip16Instr *ins)
+{
+    int sum = chip16->V[ins->x] + chip16->V[ins->y];
+    chip16->V[0xF] = (sum > 0xFFFF) ? 1 : 0;
+    chip16->V[ins->x] = sum & 0xFFFF;
+}
 
-        case 0xE: // 8XYE: Desplazar VX a la izquierda, VF = bit más significativo
+// 8XY5: Establecer VX = VX - VY, VF = not borrow
+static void opSub(Chip16 *chip16, const Chip16Instr *ins)
+{
+    chip16->V[0xF] = (chip16->V[ins->x] > chip16->V[ins->y]) ? 1 : 0;
+    chip16->V[ins->x] = (chip16->V[ins->x] - chip16->V[ins->y]) & 0xFFFF;
+}
 
-            chip16->V[0xF] = (chip16->V[x] & 0x8000) >> 15;
-            chip16->V[x] <<= 1;
+// 8XY6: Desplazar VX a la derecha, VF = bit menos significativo
+static void opShr(Chip16 *chip16, const Chip16Instr *ins)
+{
+    chip16->V[0xF] = chip16->V[ins->x] & 0x1;
+    chip16->V[ins->x] >>= 1;
+}
 
-            break;
-        }
-        break;
+// 8XY7: Establecer VX = VY - VX, VF = not borrow
+static void opSubn(Chip16 *chip16, const Chip16Instr *ins)
+{
+    chip16->V[0xF] = (chip16->V[ins->y] > chip16->V[ins->x]) ? 1 : 0;
+    chip16->V[ins->x] = chip16->V[ins->y] - chip16->V[ins->x];
+}
 
-    case 0x9000:
-        switch (n)
-        {
-        case 0x0: // 9XY0: Saltar siguiente instrucción si VX != VY
-            if (chip16->V[x] != chip16->V[y])
-            {
-                chip16->PC += 2;
-            }
+// 8XYE: Desplazar VX a la izquierda, VF = bit más significativo
+static void opShl(Chip16 *chip16, const Chip16Instr *ins)
+{
+    chip16->V[0xF] = (chip16->V[ins->x] & 0x8000) >> 15;
+    chip16->V[ins->x] <<= 1;
+}
 
-            break;
+// 9XY0: Saltar siguiente instrucción si VX != VY
+static void opSneVxVy(Chip16 *chip16, const Chip16Instr *ins)
+{
+    if (chip16->V[ins->x] != chip16->V[ins->y])
+    {
+        chip16->PC += 2;
+    }
+}
 
-        case 0x1: // 9XY1: ROtación derecha
-            value = chip16->V[x];
-            shift = chip16->V[y] & 0x0F;
+// 9XY1: Rotación derecha
+static void opRor(Chip16 *chip16, const Chip16Instr *ins)
+{
+    uint16_t value = chip16->V[ins->x];
+    uint8_t shift = chip16->V[ins->y] & 0x0F;
 
-            chip16->V[x] = (value >> shift) | (value << (16 - shift));
-            break;
-        case 0x2: // 9XY2: Rotación izquierda
-            value = chip16->V[x];
-            shift = chip16->V[y] & 0x0F;
+    chip16->V[ins->x] = (value >> shift) | (value << (16 - shift));
+}
 
-            chip16->V[x] = (value << shift) | (value >> (16 - shift));
-            break;
-        case 0x3: // 9XY3: Contar bits
-            value = chip16->V[x];
-            count = 0;
+// 9XY2: Rotación izquierda
+static void opRol(Chip16 *chip16, const Chip16Instr *ins)
+{
+    uint16_t value = chip16->V[ins->x];
+    uint8_t shift = chip16->V[ins->y] & 0x0F;
 
-            for (int i = 0; i < 16; i++)
-            {
-                if (value & (1 << i))
-                {
-                    count++;
-                }
-            }
+    chip16->V[ins->x] = (value << shift) | (value >> (16 - shift));
+}
 
-            chip16->V[x] = count;
-            break;
+// 9XY3: Contar bits
+static void opPopcnt(Chip16 *chip16, const Chip16Instr *ins)
+{
+    uint16_t value = chip16->V[ins->x];
+    uint16_t count = 0;
 
-        default:
-            break;
+    for (int i = 0; i < 16; i++)
+    {
+        if (value & (1 << i))
+        {
+            count++;
         }
+    }
 
-        break;
-    case 0xA000: // ANNN: Establecer I = NNN
-        chip16->I = nnn;
-        break;
+    chip16->V[ins->x] = count;
+}
 
-    case 0xB000: 
-    switch (n)
-    {
-    case 0x0: // BNNN: Saltar a dirección NNN + V0
-        chip16->PC = nnn + (chip16->V[0] & 0xFFFF);
-        break;
+// ANNN: Establecer I = NNN
+static void opLdI(Chip16 *chip16, const Chip16Instr *ins)
+{
+    chip16->I = ins->nnn;
+}
 
-    case 0x1: // B001: Copiar bloque de memoria
-        count = chip16->V[x];
-        src = chip16->I;
-        dst = chip16->I + count;
+// BNNN: Saltar a dirección NNN + V0
+static void opJpV0(Chip16 *chip16, const Chip16Instr *ins)
+{
+    chip16->PC = ins->nnn + (chip16->V[0] & 0xFFFF);
+}
 
-        if (dst<MEMORY_SIZE){
-            if(src<dst && src + count > dst){
-                for (int i=count-1; i>=0; i--){
-                    chip16->memory[dst+i] = chip16->memory[src+i];
-                }
-            }
-            else{
-                for (int i=0; i<count; i++){
-                    chip16->memory[dst+i] = chip16->memory[src+i];
-                }
+// B001: Copiar bloque de memoria
+static void opMemcpy(Chip16 *chip16, const Chip16Instr *ins)
+{
+    uint16_t count = chip16->V[ins->x];
+    uint16_t src = chip16->I;
+    uint16_t dst = chip16->I + count;
+
+    if (dst < MEMORY_SIZE)
+    {
+        if (src < dst && src + count > dst)
+        {
+            for (int i = count - 1; i >= 0; i--)
+            {
+                chip16->memory[dst + i] = chip16->memory[src + i];
             }
         }
-        break;
-    
-    case 0x2: // B002: BUscar valor en memoria
-        value = chip16->V[x];
-        found = false;
-
-        for (int i=0; i<256 && (chip16->I + i+1)< MEMORY_SIZE; i+=2){
-            memValue = (chip16->memory[chip16->I + i] << 8) | chip16->memory[chip16->I + i + 1];
-            if(memValue == value){
-                chip16->V[0xF] = i/2;
-                found = true;
-                break;
+        else
+        {
+            for (int i = 0; i < count; i++)
+            {
+                chip16->memory[dst + i] = chip16->memory[src + i];
             }
-            
-        }
-        if (!found) {
-            chip16->V[0xF] = 0xFFFF;
         }
-        break;
-    default:
-        break;
+
+        chip16InvalidateCode(chip16, dst, count);
     }
-    break;
+}
 
-    case 0xC000:
-        switch (n)
-        {
-        case 0x0: // CXKK: Establecer VX = random byte AND KK
-            chip16->V[x] = (rand() % 256) & kk; // No se cambia a 65536 para mantener compatibilidad con programas existentes
-            break;
+// B002: Buscar valor en memoria
+static void opMemsrch(Chip16 *chip16, const Chip16Instr *ins)
+{
+    uint16_t value = chip16->V[ins->x];
+    uint16_t memValue;
+    bool found = false;
 
-        
-        
-        default:
+    for (int i = 0; i < 256 && (chip16->I + i + 1) < MEMORY_SIZE; i += 2)
+    {
+        memValue = (chip16->memory[chip16->I + i] << 8) | chip16->memory[chip16->I + i + 1];
+        if (memValue == value)
+        {
+            chip16->V[0xF] = i / 2;
+            found = true;
             break;
         }
-        break;
-    case 0xD000: // DXYN: Dibujar sprite en posición VX, VY con N bytes
+    }
+    if (!found)
     {
-        xPos = chip16->V[x] % DISPLAY_WIDTH;
-        yPos = chip16->V[y] % DISPLAY_HEIGHT;
-        height = n;
+        chip16->V[0xF] = 0xFFFF;
+    }
+}
 
-        chip16->V[0xF] = 0; // Reset del flag de colisión
+// CXKK: Establecer VX = random byte AND KK
+static void opRnd(Chip16 *chip16, const Chip16Instr *ins)
+{
+    chip16->V[ins->x] = (chip16Random(chip16) >> 24) & ins->kk; // No se cambia a 65536 para mantener compatibilidad con programas existentes
+}
 
-        for (int row = 0; row < height; row++)
-        {
-            uint8_t spriteDataB = chip16->memory[chip16->I + row];
+// DXYN: Dibujar sprite en posición VX, VY con N bytes
+static void opDrw(Chip16 *chip16, const Chip16Instr *ins)
+{
+    uint16_t xPos = chip16->V[ins->x] % DISPLAY_WIDTH;
+    uint16_t yPos = chip16->V[ins->y] % DISPLAY_HEIGHT;
+    uint16_t height = ins->n;
 
-            for (int col = 0; col < 8; col++)
-            {
-                if ((spriteDataB & (0x80 >> col)) != 0)
-                {
-                    // Coordenadas con wrap-around
-                    pixelX = (xPos + col) % DISPLAY_WIDTH;
-                    pixelY = (yPos + row) % DISPLAY_HEIGHT;
-                    pixelPos = pixelX + (pixelY * DISPLAY_WIDTH);
-
-                    // Comprobar colisión
-                    if (chip16->gfx[pixelPos] == 1)
-                    {
-                        chip16->V[0xF] = 1;
-                    }
-
-                    // XOR con el pixel existente
-                    chip16->gfx[pixelPos] ^= 1;
-                }
-            }
-        }
+    chip16->V[0xF] = 0; // Reset del flag de colisión
 
-        chip16->drawFlag = true;
-    }
-    break;
+    for (int row = 0; row < height; row++)
+    {
+        uint8_t spriteDataB = chip16->memory[chip16->I + row];
 
-    case 0xE000:
-        switch (kk)
+        for (int col = 0; col < 8; col++)
         {
-        case 0x01: // E001: Llamada con parámetros
-            if(chip16->SP + 4 <= STACK_SIZE)
+            if ((spriteDataB & (0x80 >> col)) != 0)
             {
-            chip16->stack[chip16->SP] = chip16->PC;
-            chip16->stack[chip16->SP + 1] = chip16->V[0xD];
-            chip16->stack[chip16->SP + 2] = chip16->V[0xE];
-            chip16->stack[chip16->SP + 3] = chip16->V[0xF];
-            chip16->SP += 4;
-
-            nParams = y;
-
-            chip16->V[0xD] = (chip16->V[1] >> 8) & 0xFF;
-            chip16->V[0xE] = (chip16->V[1] & 0xFF);
-            chip16->V[0xF] = nParams;
-            chip16->PC = chip16->V[0];
-            }     
-            else{
-                if (chip16->config.debugLevel >= DEBUG_OPCODES)
+                // Coordenadas con wrap-around
+                int pixelX = (xPos + col) % DISPLAY_WIDTH;
+                int pixelY = (yPos + row) % DISPLAY_HEIGHT;
+                int pixelPos = pixelX + (pixelY * DISPLAY_WIDTH);
+
+                // Comprobar colisión
+                if (chip16->gfx[pixelPos] == 1)
                 {
-                    printf("Error: Stack overflow en llamada con parámetros\n");
+                    chip16->V[0xF] = 1;
                 }
-            }
-            break;
-        case 0x02: // E002: Retorno con valor
-
-            returnValue = chip16->V[y];
-            if (chip16->SP >= 4)
-            {
 
-                chip16->SP -= 4;
-                chip16->V[0xF] = chip16->stack[chip16->SP + 3];
-                chip16->V[0xE] = chip16->stack[chip16->SP + 2];
-                chip16->V[0xD] = chip16->stack[chip16->SP + 1];
-                chip16->PC = chip16->stack[chip16->SP];
-                chip16->V[0] = returnValue;
+                // XOR con el pixel existente
+                chip16->gfx[pixelPos] ^= 1;
             }
-            else
-            {
-                if (chip16->config.debugLevel >= DEBUG_OPCODES)
-                {
-                    printf("Error: Stack underflow en retorno con valor\n");
-                }
-            }
-            break;
-        case 0x03: // E003: Aleatorio 16 bits
-            chip16->V[x] = rand() % 65536;
-            break;
+        }
+    }
 
-        case 0x04: // E004: Aleatorio en rango
-            range = x + 1;
-            if (chip16->V[range] > 0)
-            {
-                chip16->V[x] = rand() % chip16->V[range];
-            }
-            else
-            {
-                chip16->V[x] = 0;
-            }
-            break;
+    chip16MarkRows(chip16, yPos, height);
+    chip16->drawFlag = true;
+    chip16->runEvent = CHIP16_RUN_DRAW;
+}
 
-        case 0x9E: // EX9E: Saltar siguiente instrucción si tecla VX está presionada
-            if (chip16->key[chip16->V[x]] != 0)
-            {
-                chip16->PC += 2;
-            }
-            break;
+// E001: Llamada con parámetros
+static void opCallp(Chip16 *chip16, const Chip16Instr *ins)
+{
+    if (chip16->SP + 4 <= STACK_SIZE)
+    {
+        chip16->stack[chip16->SP] = chip16->PC;
+        chip16->stack[chip16->SP + 1] = chip16->V[0xD];
+        chip16->stack[chip16->SP + 2] = chip16->V[0xE];
+        chip16->stack[chip16->SP + 3] = chip16->V[0xF];
+        chip16->SP += 4;
 
-        case 0xA1: // EXA1: Saltar siguiente instrucción si tecla VX no está presionada
-            if (chip16->key[chip16->V[x]] == 0)
-            {
-                chip16->PC += 2;
-            }
-            break;
+        uint8_t nParams = ins->y;
+
+        chip16->V[0xD] = (chip16->V[1] >> 8) & 0xFF;
+        chip16->V[0xE] = (chip16->V[1] & 0xFF);
+        chip16->V[0xF] = nParams;
+        chip16->PC = chip16->V[0];
+    }
+    else
+    {
+        if (chip16->config.debugLevel >= DEBUG_OPCODES)
+        {
+            printf("Error: Stack overflow en llamada con parámetros\n");
         }
-        break;
+    }
+}
 
-    case 0xF000:
-        switch (kk)
+// E002: Retorno con valor
+static void opRetv(Chip16 *chip16, const Chip16Instr *ins)
+{
+    uint16_t returnValue = chip16->V[ins->y];
+    if (chip16->SP >= 4)
+    {
+        chip16->SP -= 4;
+        chip16->V[0xF] = chip16->stack[chip16->SP + 3];
+        chip16->V[0xE] = chip16->stack[chip16->SP + 2];
+        chip16->V[0xD] = chip16->stack[chip16->SP + 1];
+        chip16->PC = chip16->stack[chip16->SP];
+        chip16->V[0] = returnValue;
+    }
+    else
+    {
+        if (chip16->config.debugLevel >= DEBUG_OPCODES)
         {
-        case 0x01: // FX01: Dibujar Sprite 16x16
-            xPos = chip16->V[2] % DISPLAY_WIDTH;
-            yPos = chip16->V[3] % DISPLAY_HEIGHT;
-            chip16->V[0xF] = 0; // Reset del flag de colisión
+            printf("Error: Stack underflow en retorno con valor\n");
+        }
+    }
+}
+
+// E003: Aleatorio 16 bits
+static void opRnd16(Chip16 *chip16, const Chip16Instr *ins)
+{
+    chip16->V[ins->x] = (uint16_t)(chip16Random(chip16) >> 16);
+}
+
+// E004: Aleatorio en rango
+static void opRndr(Chip16 *chip16, const Chip16Instr *ins)
+{
+    uint8_t range = ins->x + 1;
+    if (chip16->V[range] > 0)
+    {
+        chip16->V[ins->x] = chip16Random(chip16) % chip16->V[range];
+    }
+    else
+    {
+        chip16->V[ins->x] = 0;
+    }
+}
+
+// EX9E: Saltar siguiente instrucción si tecla VX está presionada
+static void opSkp(Chip16 *chip16, const Chip16Instr *ins)
+{
+    if (chip16->key[chip16->V[ins->x]] != 0)
+    {
+        chip16->PC += 2;
+    }
+}
 
-            for (int row = 0; row < 16; row++)
+// EXA1: Saltar siguiente instrucción si tecla VX no está presionada
+static void opSknp(Chip16 *chip16, const Chip16Instr *ins)
+{
+    if (chip16->key[chip16->V[ins->x]] == 0)
+    {
+        chip16->PC += 2;
+    }
+}
+
+// FX01: Dibujar Sprite 16x16
+static void opDraw16(Chip16 *chip16, const Chip16Instr *ins)
+{
+    (void)ins;
+    uint16_t xPos = chip16->V[2] % DISPLAY_WIDTH;
+    uint16_t yPos = chip16->V[3] % DISPLAY_HEIGHT;
+    chip16->V[0xF] = 0; // Reset del flag de colisión
+
+    for (int row = 0; row < 16; row++)
+    {
+        uint16_t spriteData = (chip16->memory[chip16->I + row * 2] << 8) |
+                              chip16->memory[chip16->I + row * 2 + 1];
+
+        for (int col = 0; col < 16; col++)
+        {
+            if ((spriteData & (0x8000 >> col)) != 0)
             {
-                spriteData = (chip16->memory[chip16->I + row * 2] << 8) |
-                                      chip16->memory[chip16->I + row * 2 + 1];
+                int pixelX = (xPos + col) % DISPLAY_WIDTH;
+                int pixelY = (yPos + row) % DISPLAY_HEIGHT;
+                int pixelPos = pixelX + (pixelY * DISPLAY_WIDTH);
 
-                for (int col = 0; col < 16; col++)
+                if (chip16->gfx[pixelPos] == 1)
                 {
-                    if ((spriteData & (0x8000 >> col)) != 0)
-                    {
-                        int pixelX = (xPos + col) % DISPLAY_WIDTH;
-                        int pixelY = (yPos + row) % DISPLAY_HEIGHT;
-                        int pixelPos = pixelX + (pixelY * DISPLAY_WIDTH);
-
-                        if (chip16->gfx[pixelPos] == 1)
-                        {
-                            chip16->V[0xF] = 1;
-                        }
-
-                        chip16->gfx[pixelPos] ^= 1;
-                    }
+                    chip16->V[0xF] = 1;
                 }
+
+                chip16->gfx[pixelPos] ^= 1;
             }
+        }
+    }
 
-            chip16->drawFlag = true;
-            break;
-        
-        case 0x02: // Fx02: Dibujar línea horizontal
-        xPos = chip16->V[2] % DISPLAY_WIDTH;
-            yPos = chip16->V[3] % DISPLAY_HEIGHT;
-            length = chip16->V[4];
-            pattern = chip16->V[5];
+    chip16MarkRows(chip16, yPos, 16);
+    chip16->drawFlag = true;
+    chip16->runEvent = CHIP16_RUN_DRAW;
+}
 
-            if (length == 0 || length > DISPLAY_WIDTH - xPos)
-            {
-                length = DISPLAY_WIDTH - xPos;
-            }
+// Fx02: Dibujar línea horizontal
+static void opHline(Chip16 *chip16, const Chip16Instr *ins)
+{
+    (void)ins;
+    uint16_t xPos = chip16->V[2] % DISPLAY_WIDTH;
+    uint16_t yPos = chip16->V[3] % DISPLAY_HEIGHT;
+    uint16_t length = chip16->V[4];
+    uint16_t pattern = chip16->V[5];
+    uint16_t mask, activePattern;
+    int basePos;
+
+    if (length == 0 || length > DISPLAY_WIDTH - xPos)
+    {
+        length = DISPLAY_WIDTH - xPos;
+    }
 
-            chip16->V[0xF] = 0; // Reset del flag de colisión
-            basePos = xPos + (yPos * DISPLAY_WIDTH);
-            if (length <= 16)
-            {
-                mask = 0;
-                for (int i = 0; i < length; i++)
-                {
-                    mask |= (0x8000 >> i);
-                }
+    chip16->V[0xF] = 0; // Reset del flag de colisión
+    basePos = xPos + (yPos * DISPLAY_WIDTH);
+    if (length <= 16)
+    {
+        mask = 0;
+        for (int i = 0; i < length; i++)
+        {
+            mask |= (0x8000 >> i);
+        }
 
-                activePattern = pattern & mask;
-                for (int i = 0; i < length; i++)
+        activePattern = pattern & mask;
+        for (int i = 0; i < length; i++)
+        {
+            if ((activePattern & (0x8000 >> i)) != 0)
+            {
+                if (chip16->gfx[basePos + i] == 1)
                 {
-                    if ((activePattern & (0x8000 >> i)) != 0)
-                    {
-                        if (chip16->gfx[basePos + i] == 1)
-                        {
-                            chip16->V[0xF] = 1;
-                        }
-                        chip16->gfx[basePos + i] ^= 1;
-                    }
+                    chip16->V[0xF] = 1;
                 }
+                chip16->gfx[basePos + i] ^= 1;
             }
-            else
+        }
+    }
+    else
+    {
+        for (int i = 0; i < length; i++)
+        {
+            if ((pattern & (0x8000 >> i)) != 0)
             {
-                for (int i = 0; i < length; i++)
+                if (chip16->gfx[basePos + i] == 1)
                 {
-                    if ((pattern & (0x8000 >> i)) != 0)
-                    {
-                        if (chip16->gfx[basePos + i] == 1)
-                        {
-                            chip16->V[0xF] = 1;
-                        }
-                        chip16->gfx[basePos + i] ^= 1;
-                    }
+                    chip16->V[0xF] = 1;
                 }
+                chip16->gfx[basePos + i] ^= 1;
             }
-            chip16->drawFlag = true;
-            break;
+        }
+    }
+    chip16MarkRows(chip16, yPos, 1);
+    chip16->drawFlag = true;
+    chip16->runEvent = CHIP16_RUN_DRAW;
+}
 
-        case 0x03: // FX03: Dibujar línea vertical
-            xPos = chip16->V[2] % DISPLAY_WIDTH;
-            yPos = chip16->V[3] % DISPLAY_HEIGHT;
-            height = chip16->V[4];
-            pattern = chip16->V[5];
+// FX03: Dibujar línea vertical
+static void opVline(Chip16 *chip16, const Chip16Instr *ins)
+{
+    (void)ins;
+    uint16_t xPos = chip16->V[2] % DISPLAY_WIDTH;
+    uint16_t yPos = chip16->V[3] % DISPLAY_HEIGHT;
+    uint16_t height = chip16->V[4];
+    uint16_t pattern = chip16->V[5];
+    int pixelPos;
+
+    if (height == 0 || height > DISPLAY_HEIGHT - yPos)
+    {
+        height = DISPLAY_HEIGHT - yPos;
+    }
+
+    chip16->V[0xF] = 0;
+    for (int i = 0; i < height; i++)
+    {
+        if ((pattern & (0x8000 >> (i % 16))) != 0)
+        {
+            pixelPos = xPos + ((yPos + i) % DISPLAY_HEIGHT) * DISPLAY_WIDTH;
 
-            if (height == 0 || height > DISPLAY_HEIGHT - yPos)
+            if (chip16->gfx[pixelPos] == 1)
             {
-                height = DISPLAY_HEIGHT - yPos;
+                chip16->V[0xF] = 1;
             }
+            chip16->gfx[pixelPos] ^= 1;
+        }
+    }
 
-            chip16->V[0xF] = 0;
-            for (int i = 0; i < height; i++)
-            {
-                if ((pattern & (0x8000 >> (i % 16))) != 0)
-                {
-                    pixelPos = xPos + ((yPos + i) % DISPLAY_HEIGHT) * DISPLAY_WIDTH;
+    chip16MarkRows(chip16, yPos, height);
+    chip16->drawFlag = true;
+    chip16->runEvent = CHIP16_RUN_DRAW;
+}
 
-                    if (chip16->gfx[pixelPos] == 1)
-                    {
-                        chip16->V[0xF] = 1;
-                    }
-                    chip16->gfx[pixelPos] ^= 1;
-                }
-            }
+// FX07: Establecer VX = valor del delay timer
+static void opLdVxDt(Chip16 *chip16, const Chip16Instr *ins)
+{
+    chip16->V[ins->x] = chip16->delayTimer;
+}
 
-            chip16->drawFlag = true;
-            break;
-        case 0x07: // FX07: Establecer VX = valor del delay timer
-            chip16->V[x] = chip16->delayTimer;
-            break;
+// FX0A: Esperar presión de tecla, almacenar en VX
+static void opLdVxK(Chip16 *chip16, const Chip16Instr *ins)
+{
+    bool keyPressed = false;
 
-        case 0x0A: // FX0A: Esperar presión de tecla, almacenar en VX
+    for (int i = 0; i < KEY_COUNT; i++)
+    {
+        if (chip16->key[i])
         {
-            bool keyPressed = false;
+            chip16->V[ins->x] = i;
+            keyPressed = true;
+            break;
+        }
+    }
 
-            for (int i = 0; i < KEY_COUNT; i++)
-            {
-                if (chip16->key[i])
-                {
-                    chip16->V[x] = i;
-                    keyPressed = true;
-                    break;
-                }
-            }
+    // Si no se presionó tecla, repetir instrucción y detener chip16Run hasta
+    // que chip16SetKey registre una pulsación
+    chip16->waitingKey = !keyPressed;
+    if (!keyPressed)
+    {
+        chip16->PC -= 2;
+        chip16->runEvent = CHIP16_RUN_KEY_WAIT;
+    }
+}
 
-            // Si no se presionó tecla, repetir instrucción
-            if (!keyPressed)
-            {
-                chip16->PC -= 2;
+// FX15: Establecer delay timer = VX
+static void opLdDtVx(Chip16 *chip16, const Chip16Instr *ins)
+{
+    chip16->delayTimer = chip16->V[ins->x];
+    chip16->runEvent = CHIP16_RUN_TIMER_WRITE;
+}
+
+// FX18: Establecer sound timer = VX
+static void opLdStVx(Chip16 *chip16, const Chip16Instr *ins)
+{
+    chip16->soundTimer = chip16->V[ins->x];
+    chip16->runEvent = CHIP16_RUN_TIMER_WRITE;
+}
+
+// FX1E: Establecer I = I + VX
+static void opAddIVx(Chip16 *chip16, const Chip16Instr *ins)
+{
+    chip16->I += chip16->V[ins->x];
+}
+
+// FX29: Establecer I = dirección del carácter en VX
+static void opLdFVx(Chip16 *chip16, const Chip16Instr *ins)
+{
+    if (chip16->mode == MODE_8BIT) {
+        // Modo CHIP-8: Sprites de 5 bytes, solo dígitos 0-F
+        uint8_t digit = chip16->V[ins->x] & 0x0F;  // Limitar a 0-F
+        chip16->I = digit * 5;  // Cada sprite ocupa 5 bytes
+    } else {
+        // Modo CHIP-16: Podría usar sprites extendidos
+        uint8_t character = chip16->V[ins->x] & 0xFF;  // Soportar más caracteres
+
+        if (character <= 0x0F) {
+            // Caracteres estándar 0-F (compatibilidad)
+            chip16->I = character * 5;
+        } else {
+            // Caracteres extendidos (si los implementamos)
+            // Por ejemplo, sprites de mayor resolución o caracteres ASCII
+            if (character < 128 && character >= 16) {
+                // Offset para caracteres extendidos
+                chip16->I = FONTSET_SIZE + ((character - 16) * 8);
+            } else {
+                // Caracter no válido, usar espacio en blanco o '?'
+                chip16->I = 0x0F * 5;  // Apuntar al sprite 'F' como fallback
             }
         }
+    }
+}
+
+// FX33: Almacenar representación BCD de VX en I, I+1, I+2
+static void opLdBVx(Chip16 *chip16, const Chip16Instr *ins)
+{
+    if (chip16->mode == MODE_8BIT) {
+        // Modo CHIP-8: 3 dígitos BCD
+        uint8_t value = chip16->V[ins->x] & 0xFF;
+        chip16->memory[chip16->I] = value / 100;          // Centenas
+        chip16->memory[chip16->I + 1] = (value / 10) % 10; // Decenas
+        chip16->memory[chip16->I + 2] = value % 10;        // Unidades
+        chip16InvalidateCode(chip16, chip16->I, 3);
+    } else {
+        // Modo CHIP-16: 5 dígitos BCD
+        uint16_t value = chip16->V[ins->x];
+        chip16->memory[chip16->I] = value / 10000;         // Decenas de millar
+        chip16->memory[chip16->I + 1] = (value / 1000) % 10; // Millares
+        chip16->memory[chip16->I + 2] = (value / 100) % 10;  // Centenas
+        chip16->memory[chip16->I + 3] = (value / 10) % 10;   // Decenas
+        chip16->memory[chip16->I + 4] = value % 10;          // Unidades
+        chip16InvalidateCode(chip16, chip16->I, 5);
+    }
+}
+
+// FX55: Almacenar V0 a VX en memoria desde I
+static void opLdIVx(Chip16 *chip16, const Chip16Instr *ins)
+{
+    if (chip16->mode == MODE_8BIT) {
+        // Modo compatibilidad CHIP-8
+        for (int i = 0; i <= ins->x; i++) {
+            chip16->memory[chip16->I + i] = chip16->V[i] & 0xFF;
+        }
+        chip16InvalidateCode(chip16, chip16->I, ins->x + 1);
+
+    } else {
+        for (int i = 0; i <= ins->x; i++)
+        {
+            // Almacenar registro de 16 bits en dos bytes consecutivos
+            chip16->memory[chip16->I + (i * 2)] = (chip16->V[i] >> 8) & 0xFF; // Byte alto
+            chip16->memory[chip16->I + (i * 2) + 1] = chip16->V[i] & 0xFF;    // Byte bajo
+        }
+        chip16InvalidateCode(chip16, chip16->I, (ins->x + 1) * 2);
+        chip16->I += (ins->x + 1) * 2;
+    }
+}
+
+// FX65: Cargar V0 a VX desde memoria desde I
+static void opLdVxI(Chip16 *chip16, const Chip16Instr *ins)
+{
+    if (chip16->mode == MODE_8BIT) {
+        // Modo compatibilidad CHIP-8
+        for (int i = 0; i <= ins->x; i++) {
+            chip16->V[i] = chip16->memory[chip16->I + i];
+        }
+
+    } else {
+        // Modo CHIP-16
+        for (int i = 0; i <= ins->x; i++) {
+            chip16->V[i] = (chip16->memory[chip16->I + (i * 2)] << 8) |
+                           chip16->memory[chip16->I + (i * 2) + 1];
+        }
+        chip16->I += (ins->x + 1) * 2;
+    }
+}
+
+// ============================================================================
+// DECODIFICACIÓN Y CACHÉ DE INSTRUCCIONES
+// ============================================================================
+//
+// Cada dirección par de memoria tiene una entrada en chip16->icache con la
+// instrucción ya decodificada (manejador + operandos). La entrada solo se
+// invalida cuando una escritura en memoria (FX33, FX55, B001) la alcanza, así
+// que una ROM que no se modifica a sí misma nunca decodifica dos veces la
+// misma instrucción.
+
+// Decodificar un opcode: elegir manejador y extraer operandos
+static void chip16Decode(uint16_t opcode, Chip16Instr *ins)
+{
+    uint8_t n = opcode & 0x000F;
+    uint8_t kk = opcode & 0x00FF;
+    Chip16Handler handler = opNop;
+
+    switch (opcode & 0xF000)
+    {
+    case 0x0000:
+        switch (kk)
+        {
+        case 0xE0: handler = opCls; break;
+        case 0xEE: handler = opRet; break;
+        default:   handler = opUnknown; break;
+        }
         break;
 
-        case 0x15: // FX15: Establecer delay timer = VX
-            chip16->delayTimer = chip16->V[x];
-            break;
+    case 0x1000: handler = opJp; break;
+    case 0x2000: handler = opCall; break;
+    case 0x3000: handler = opSeVxByte; break;
+    case 0x4000: handler = opSneVxByte; break;
 
-        case 0x18: // FX18: Establecer sound timer = VX
-            chip16->soundTimer = chip16->V[x];
-            break;
+    case 0x5000:
+        switch (n)
+        {
+        case 0x0: handler = opSeVxVy; break;
+        case 0x1: handler = opMul; break;
+        case 0x2: handler = opDiv; break;
+        case 0x3: handler = opVadd; break;
+        case 0x4: handler = opDot; break;
+        }
+        break;
+
+    case 0x6000: handler = opLdVxByte; break;
+    case 0x7000: handler = opAddVxByte; break;
+
+    case 0x8000:
+        switch (n)
+        {
+        case 0x0: handler = opLdVxVy; break;
+        case 0x1: handler = opOr; break;
+        case 0x2: handler = opAnd; break;
+        case 0x3: handler = opXor; break;
+        case 0x4: handler = opAddVxVy; break;
+        case 0x5: handler = opSub; break;
+        case 0x6: handler = opShr; break;
+        case 0x7: handler = opSubn; break;
+        case 0xE: handler = opShl; break;
+        }
+        break;
+
+    case 0x9000:
+        switch (n)
+        {
+        case 0x0: handler = opSneVxVy; break;
+        case 0x1: handler = opRor; break;
+        case 0x2: handler = opRol; break;
+        case 0x3: handler = opPopcnt; break;
+        }
+        break;
+
+    case 0xA000: handler = opLdI; break;
+
+    case 0xB000:
+        switch (n)
+        {
+        case 0x0: handler = opJpV0; break;
+        case 0x1: handler = opMemcpy; break;
+        case 0x2: handler = opMemsrch; break;
+        }
+        break;
+
+    case 0xC000:
+        if (n == 0)
+        {
+            handler = opRnd;
+        }
+        break;
 
-        case 0x1E: // FX1E: Establecer I = I + VX
-            chip16->I += chip16->V[x];
+    case 0xD000: handler = opDrw; break;
+
+    case 0xE000:
+        switch (kk)
+        {
+        case 0x01: handler = opCallp; break;
+        case 0x02: handler = opRetv; break;
+        case 0x03: handler = opRnd16; break;
+        case 0x04: handler = opRndr; break;
+        case 0x9E: handler = opSkp; break;
+        case 0xA1: handler = opSknp; break;
+        }
+        break;
+
+    case 0xF000:
+        switch (kk)
+        {
+        case 0x01: handler = opDraw16; break;
+        case 0x02: handler = opHline; break;
+        case 0x03: handler = opVline; break;
+        case 0x07: handler = opLdVxDt; break;
+        case 0x0A: handler = opLdVxK; break;
+        case 0x15: handler = opLdDtVx; break;
+        case 0x18: handler = opLdStVx; break;
+        case 0x1E: handler = opAddIVx; break;
+        case 0x29: handler = opLdFVx; break;
+        case 0x33: handler = opLdBVx; break;
+        case 0x55: handler = opLdIVx; break;
+        case 0x65: handler = opLdVxI; break;
+        }
+        break;
+    }
+
+    ins->handler = handler;
+    ins->opcode = opcode;
+    ins->x = (opcode & 0x0F00) >> 8;
+    ins->y = (opcode & 0x00F0) >> 4;
+    ins->n = n;
+    ins->kk = kk;
+    ins->nnn = opcode & 0x0FFF;
+}
+
+// Ejecutar una instrucción (se inserta en chip16Cycle y en el bucle de chip16Run)
+static inline void chip16Step(Chip16 *chip16)
+{
+    Chip16Instr decoded;
+    const Chip16Instr *ins;
+    uint16_t pc = chip16->PC;
+
+    if ((pc & 1) == 0 && pc < MEMORY_SIZE)
+    {
+        // Dirección par: servir la instrucción desde la caché predecodificada
+        Chip16Instr *entry = &chip16->icache[pc >> 1];
+
+        if (entry->handler != NULL)
+        {
+            chip16->cacheStats.hits++;
+        }
+        else
+        {
+            chip16Decode((chip16->memory[pc] << 8) | chip16->memory[pc + 1], entry);
+            chip16->cacheStats.misses++;
+        }
+        ins = entry;
+    }
+    else
+    {
+        // Dirección impar: decodificar sin pasar por la caché
+        chip16Decode((chip16->memory[pc] << 8) | chip16->memory[pc + 1], &decoded);
+        ins = &decoded;
+    }
+
+    chip16->opcode = ins->opcode;
+
+    // Incrementar PC antes de ejecutar
+    chip16->PC += 2;
+
+    // Depuración si está habilitada
+    if (chip16->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("Ejecutando opcode: 0x%04X en PC=0x%04X\n", chip16->opcode, chip16->PC - 2);
+    }
+
+    ins->handler(chip16, ins);
+}
+
+// ============================================================================
+// API PÚBLICA DE EJECUCIÓN
+// ============================================================================
+
+// Ejecutar un ciclo de emulación
+void chip16Cycle(Chip16 *chip16)
+{
+    chip16Step(chip16);
+}
+
+// Ejecutar instrucciones hasta agotar maxCycles o hasta que un manejador
+// señale un evento (dibujo, espera de tecla, escritura de timer, opcode
+// desconocido). El bucle interno evita una llamada por instrucción desde el
+// anfitrión, que solo tiene que reaccionar al motivo devuelto.
+static Chip16RunResult chip16RunSlice(Chip16 *chip16, uint32_t maxCycles)
+{
+    uint32_t cycles = 0;
+
+    // Detenido en FX0A: no hay nada que ejecutar hasta que llegue una tecla
+    if (chip16->waitingKey)
+    {
+        chip16->runCycles = 0;
+        chip16->runEvent = CHIP16_RUN_KEY_WAIT;
+        return CHIP16_RUN_KEY_WAIT;
+    }
+
+    chip16->runEvent = CHIP16_RUN_BUDGET;
+    while (cycles < maxCycles)
+    {
+        chip16Step(chip16);
+        cycles++;
+
+        if (chip16->runEvent != CHIP16_RUN_BUDGET)
+        {
             break;
+        }
+    }
 
-        case 0x29:                        // FX29: Establecer I = dirección del carácter en VX
-            // chip16->I = chip16->V[x] * 5; // Cada carácter ocupa 5 bytes
+    chip16->runCycles = cycles;
+    return chip16->runEvent;
+}
 
-            if (chip16->mode == MODE_8BIT) {
-                // Modo CHIP-8: Sprites de 5 bytes, solo dígitos 0-F
-                uint8_t digit = chip16->V[x] & 0x0F;  // Limitar a 0-F
-                chip16->I = digit * 5;  // Cada sprite ocupa 5 bytes
-            } else {
-                // Modo CHIP-16: Podría usar sprites extendidos
-                uint8_t character = chip16->V[x] & 0xFF;  // Soportar más caracteres
-                
-                if (character <= 0x0F) {
-                    // Caracteres estándar 0-F (compatibilidad)
-                    chip16->I = character * 5;
-                } else {
-                    // Caracteres extendidos (si los implementamos)
-                    // Por ejemplo, sprites de mayor resolución o caracteres ASCII
-                    if (character < 128 && character >= 16) {
-                        // Offset para caracteres extendidos
-                        chip16->I = FONTSET_SIZE + ((character - 16) * 8);
-                    } else {
-                        // Caracter no válido, usar espacio en blanco o '?'
-                        chip16->I = 0x0F * 5;  // Apuntar al sprite 'F' como fallback
-                    }
-                }
-            }
+// Con config.cycleTimers el presupuesto se trocea en los tramos que separan
+// dos ticks de DT/ST, que se aplican exactamente tras la instrucción que
+// completa cada periodo. Detenido en FX0A el tiempo emulado sigue corriendo:
+// el resto del presupuesto se consume sin ejecutar nada
+Chip16RunResult chip16Run(Chip16 *chip16, uint32_t maxCycles)
+{
+    if (!chip16->config.cycleTimers)
+    {
+        return chip16RunSlice(chip16, maxCycles);
+    }
+
+    uint32_t done = 0;
+    Chip16RunResult result = CHIP16_RUN_BUDGET;
+
+    chip16AdvanceTimers(chip16, 0);  // Planificar el primer tick si hace falta
+
+    while (done < maxCycles)
+    {
+        uint32_t slice = maxCycles - done;
+        if (slice > chip16->timerCountdown)
+        {
+            slice = chip16->timerCountdown;
+        }
+
+        if (chip16->waitingKey)
+        {
+            chip16->runCycles = slice;
+            result = CHIP16_RUN_KEY_WAIT;
+        }
+        else
+        {
+            result = chip16RunSlice(chip16, slice);
+        }
+
+        done += chip16->runCycles;
+        chip16AdvanceTimers(chip16, chip16->runCycles);
+
+        if (result != CHIP16_RUN_BUDGET && !chip16->waitingKey)
+        {
             break;
+        }
+    }
+
+    chip16->runCycles = done;
+    chip16->runEvent = result;
+    return result;
+}
+
+// ============================================================================
+// ESTADO GUARDADO
+// ============================================================================
+//
+// Formato (enteros en little-endian):
+//   "C16S", versión (1 byte)
+//   registros, pila, temporizadores, teclas y estado de ejecución
+//   memoria y pantalla (un byte por píxel) comprimidas por rachas de ceros
+//
+// Las rachas se codifican con un byte de control: 0x00-0x7F = siguen
+// control + 1 bytes literales; 0x80-0xFF = (control & 0x7F) + 1 ceros. Un
+// cero suelto dentro de una racha de literales se deja como literal. Sin
+// comprimir (chip16SaveStateRaw) todo son rachas de 128 literales: el tamaño
+// es siempre el mismo y cada byte del estado ocupa siempre la misma posición.
+//
+// No se guarda Config (es del anfitrión), la caché de instrucciones (al
+// restaurar solo se invalidan las entradas de la memoria que cambia) ni
+// gfx2Buffer, que chip16ProcessEffects regenera en cada frame.
+
+#define CHIP16_STATE_MAGIC "C16S"
+#define CHIP16_STATE_VERSION 1
+#define CHIP16_RUN_MAX 128 // Longitud máxima de una racha
+
+typedef struct
+{
+    uint8_t *data;
+    size_t size;
+    size_t pos;
+    bool ok;  // false si el buffer se quedó corto
+    bool raw; // Sin comprimir: solo rachas de literales de longitud máxima
+} Chip16StateWriter;
+
+typedef struct
+{
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+    bool ok; // false si los datos se acabaron o no son válidos
+} Chip16StateReader;
+
+static void chip16StatePut(Chip16StateWriter *w, const void *src, size_t len)
+{
+    if (!w->ok || w->size - w->pos < len)
+    {
+        w->ok = false;
+        return;
+    }
+    memcpy(w->data + w->pos, src, len);
+    w->pos += len;
+}
+
+static void chip16StatePutInt(Chip16StateWriter *w, uint64_t value, int bytes)
+{
+    uint8_t buf[8];
+    for (int i = 0; i < bytes; i++)
+    {
+        buf[i] = (uint8_t)(value >> (8 * i));
+    }
+    chip16StatePut(w, buf, (size_t)bytes);
+}
 
-        case 0x33: // FX33: Almacenar representación BCD de VX en I, I+1, I+2
+static void chip16StatePutZeroRuns(Chip16StateWriter *w, const uint8_t *src, size_t len)
+{
+    size_t i = 0;
+
+    if (w->raw)
+    {
+        for (; i < len; i += CHIP16_RUN_MAX)
         {
-            if (chip16->mode == MODE_8BIT) {
-                // Modo CHIP-8: 3 dígitos BCD 
-                uint8_t value = chip16->V[x] & 0xFF;  
-                chip16->memory[chip16->I] = value / 100;          // Centenas
-                chip16->memory[chip16->I + 1] = (value / 10) % 10; // Decenas
-                chip16->memory[chip16->I + 2] = value % 10;        // Unidades
-            } else {
-                // Modo CHIP-16: 5 dígitos BCD
-                uint16_t value = chip16->V[x];
-                chip16->memory[chip16->I] = value / 10000;         // Decenas de millar
-                chip16->memory[chip16->I + 1] = (value / 1000) % 10; // Millares
-                chip16->memory[chip16->I + 2] = (value / 100) % 10;  // Centenas
-                chip16->memory[chip16->I + 3] = (value / 10) % 10;   // Decenas
-                chip16->memory[chip16->I + 4] = value % 10;          // Unidades
-            }
+            size_t n = len - i < CHIP16_RUN_MAX ? len - i : CHIP16_RUN_MAX;
+            chip16StatePutInt(w, n - 1, 1);
+            chip16StatePut(w, src + i, n);
         }
-        break;
+        return;
+    }
 
-        case 0x55: // FX55: Almacenar V0 a VX en memoria desde I
-            
-        if (chip16->mode == MODE_8BIT) {
-            // Modo compatibilidad CHIP-8
-            for (int i = 0; i <= x; i++) {
-                chip16->memory[chip16->I + i] = chip16->V[i] & 0xFF;
+    while (i < len && w->ok)
+    {
+        size_t n = 0;
+        if (src[i] == 0)
+        {
+            // De 8 en 8 mientras se pueda: la memoria libre es casi toda ceros
+            uint64_t word;
+            while (i + n + 8 <= len && n + 8 <= CHIP16_RUN_MAX &&
+                   (memcpy(&word, src + i + n, 8), word == 0))
+            {
+                n += 8;
             }
-            
-        } else {
-            for (int i = 0; i <= x; i++)
+            while (i + n < len && n < CHIP16_RUN_MAX && src[i + n] == 0)
             {
-                // Almacenar registro de 16 bits en dos bytes consecutivos
-                chip16->memory[chip16->I + (i * 2)] = (chip16->V[i] >> 8) & 0xFF; // Byte alto
-                chip16->memory[chip16->I + (i * 2) + 1] = chip16->V[i] & 0xFF;    // Byte bajo
+                n++;
             }
-            chip16->I += (x + 1) * 2;
+            chip16StatePutInt(w, 0x80 | (n - 1), 1);
+        }
+        else
+        {
+            // Literales hasta dos ceros seguidos
+            while (i + n < len && n < CHIP16_RUN_MAX &&
+                   !(src[i + n] == 0 && (i + n + 1 == len || src[i + n + 1] == 0)))
+            {
+                n++;
             }
-            break;
+            chip16StatePutInt(w, n - 1, 1);
+            chip16StatePut(w, src + i, n);
+        }
+        i += n;
+    }
+}
 
-        case 0x65: // FX65: Cargar V0 a VX desde memoria desde I
-        if (chip16->mode == MODE_8BIT) {
-            // Modo compatibilidad CHIP-8
-            for (int i = 0; i <= x; i++) {
-                chip16->V[i] = chip16->memory[chip16->I + i];
-            }
-            
-        } else {
-            // Modo CHIP-16
-            for (int i = 0; i <= x; i++) {
-                chip16->V[i] = (chip16->memory[chip16->I + (i * 2)] << 8) |
-                               chip16->memory[chip16->I + (i * 2) + 1];
+static void chip16StateGet(Chip16StateReader *r, void *dst, size_t len)
+{
+    if (!r->ok || r->size - r->pos < len)
+    {
+        r->ok = false;
+        memset(dst, 0, len);
+        return;
+    }
+    memcpy(dst, r->data + r->pos, len);
+    r->pos += len;
+}
+
+static uint64_t chip16StateGetInt(Chip16StateReader *r, int bytes)
+{
+    uint8_t buf[8];
+    uint64_t value = 0;
+    chip16StateGet(r, buf, (size_t)bytes);
+    for (int i = 0; i < bytes; i++)
+    {
+        value |= (uint64_t)buf[i] << (8 * i);
+    }
+    return value;
+}
+
+// Decodificar len bytes comprimidos en dst. Con dst NULL solo se comprueba
+// que los datos son válidos y se avanza el lector
+static void chip16StateGetZeroRuns(Chip16StateReader *r, uint8_t *dst, size_t len)
+{
+    size_t i = 0;
+    while (i < len && r->ok)
+    {
+        uint8_t control = (uint8_t)chip16StateGetInt(r, 1);
+        size_t n = (size_t)(control & 0x7F) + 1;
+        if (n > len - i)
+        {
+            r->ok = false;
+            break;
+        }
+        if (dst == NULL)
+        {
+            // Solo comprobar: saltar los literales
+            if (!(control & 0x80))
+            {
+                if (r->size - r->pos < n)
+                {
+                    r->ok = false;
+                    break;
+                }
+                r->pos += n;
             }
-            chip16->I += (x + 1) * 2;
         }
-            break;
+        else if (control & 0x80)
+        {
+            memset(dst + i, 0, n);
         }
-        break;
+        else
+        {
+            chip16StateGet(r, dst + i, n);
+        }
+        i += n;
+    }
+}
 
-    default:
-        if (chip16->config.debugLevel >= DEBUG_OPCODES)
+// Decodificar la memoria directamente sobre el núcleo invalidando solo las
+// entradas de la caché de instrucciones cuyos bytes cambian: al restaurar un
+// estado cercano (rebobinado, run-ahead) casi toda la caché sigue valiendo.
+// Los datos ya se han comprobado con chip16StateGetZeroRuns
+static void chip16StateRestoreMemory(Chip16 *chip16, Chip16StateReader *r)
+{
+    static const uint8_t zeros[CHIP16_RUN_MAX];
+    uint32_t addr = 0;
+
+    while (addr < MEMORY_SIZE)
+    {
+        uint8_t control = (uint8_t)chip16StateGetInt(r, 1);
+        uint32_t n = (uint32_t)(control & 0x7F) + 1;
+        const uint8_t *src = zeros;
+        if (!(control & 0x80))
+        {
+            src = r->data + r->pos;
+            r->pos += n;
+        }
+
+        // Casi todas las rachas siguen igual
+        if (memcmp(chip16->memory + addr, src, n) == 0)
+        {
+            addr += n;
+            continue;
+        }
+
+        // Tramo [first, last] de bytes distintos dentro de la racha
+        uint8_t *dst = chip16->memory + addr;
+        uint32_t first = 0;
+        while (first < n && dst[first] == src[first])
+        {
+            first++;
+        }
+        if (first < n)
         {
-            printf("Opcode desconocido: 0x%04X\n", chip16->opcode);
+            uint32_t last = n - 1;
+            while (dst[last] == src[last])
+            {
+                last--;
+            }
+            memcpy(dst + first, src + first, last - first + 1);
+            chip16InvalidateCode(chip16, addr + first, last - first + 1);
         }
+        addr += n;
     }
+}
 
-    
-}
\ No newline at end of file
+static size_t chip16SaveStateTo(const Chip16 *chip16, uint8_t *buffer, size_t size, bool raw)
+{
+    Chip16StateWriter w = {buffer, size, 0, true, raw};
+
+    chip16StatePut(&w, CHIP16_STATE_MAGIC, 4);
+    chip16StatePutInt(&w, CHIP16_STATE_VERSION, 1);
+
+    chip16StatePutInt(&w, chip16->opcode, 2);
+    for (int i = 0; i < REGISTER_COUNT; i++)
+    {
+        chip16StatePutInt(&w, chip16->V[i], 2);
+    }
+    chip16StatePutInt(&w, chip16->I, 2);
+    chip16StatePutInt(&w, chip16->PC, 2);
+    chip16StatePutInt(&w, chip16->SP, 2);
+    for (int i = 0; i < STACK_SIZE; i++)
+    {
+        chip16StatePutInt(&w, chip16->stack[i], 2);
+    }
+    chip16StatePutInt(&w, chip16->delayTimer, 1);
+    chip16StatePutInt(&w, chip16->soundTimer, 1);
+    chip16StatePut(&w, chip16->key, KEY_COUNT);
+    chip16StatePutInt(&w, chip16->drawFlag, 1);
+    chip16StatePutInt(&w, chip16->dirtyRows, 4);
+    chip16StatePutInt(&w, chip16->waitingKey, 1);
+    chip16StatePutInt(&w, chip16->runEvent, 1);
+    chip16StatePutInt(&w, chip16->timerCountdown, 4);
+    chip16StatePutInt(&w, chip16->timerRemainder, 4);
+    chip16StatePutInt(&w, chip16->rngState, 4);
+    chip16StatePutInt(&w, chip16->mode, 1);
+    chip16StatePutInt(&w, chip16->currentEffect, 1);
+    chip16StatePutInt(&w, chip16->effectTimer, 1);
+    chip16StatePutInt(&w, chip16->colorIndex, 1);
+
+    chip16StatePutZeroRuns(&w, chip16->memory, MEMORY_SIZE);
+
+    chip16StatePutZeroRuns(&w, chip16->gfx, sizeof(chip16->gfx));
+
+    return w.ok ? w.pos : 0;
+}
+
+size_t chip16SaveState(const Chip16 *chip16, uint8_t *buffer, size_t size)
+{
+    return chip16SaveStateTo(chip16, buffer, size, false);
+}
+
+size_t chip16SaveStateRaw(const Chip16 *chip16, uint8_t *buffer, size_t size)
+{
+    return chip16SaveStateTo(chip16, buffer, size, true);
+}
+
+bool chip16LoadState(Chip16 *chip16, const uint8_t *buffer, size_t size)
+{
+    Chip16StateReader r = {buffer, size, 0, true};
+    char magic[4];
+
+    chip16StateGet(&r, magic, 4);
+    if (!r.ok || memcmp(magic, CHIP16_STATE_MAGIC, 4) != 0)
+    {
+        fprintf(stderr, "Error: El estado guardado no es de CHIP-16\n");
+        return false;
+    }
+    unsigned version = (unsigned)chip16StateGetInt(&r, 1);
+    if (version != CHIP16_STATE_VERSION)
+    {
+        fprintf(stderr, "Error: Versión de estado guardado no soportada: %u\n", version);
+        return false;
+    }
+
+    // Primera pasada: los registros se leen en variables locales y la memoria
+    // solo se comprueba, para no dejar el núcleo a medias si los datos están
+    // truncados o no son válidos
+    uint16_t opcode = (uint16_t)chip16StateGetInt(&r, 2);
+    uint16_t V[REGISTER_COUNT];
+    for (int i = 0; i < REGISTER_COUNT; i++)
+    {
+        V[i] = (uint16_t)chip16StateGetInt(&r, 2);
+    }
+    uint16_t I = (uint16_t)chip16StateGetInt(&r, 2);
+    uint16_t PC = (uint16_t)chip16StateGetInt(&r, 2);
+    uint16_t SP = (uint16_t)chip16StateGetInt(&r, 2);
+    uint16_t stack[STACK_SIZE];
+    for (int i = 0; i < STACK_SIZE; i++)
+    {
+        stack[i] = (uint16_t)chip16StateGetInt(&r, 2);
+    }
+    uint8_t delayTimer = (uint8_t)chip16StateGetInt(&r, 1);
+    uint8_t soundTimer = (uint8_t)chip16StateGetInt(&r, 1);
+    uint8_t key[KEY_COUNT];
+    chip16StateGet(&r, key, KEY_COUNT);
+    bool drawFlag = chip16StateGetInt(&r, 1) != 0;
+    uint32_t dirtyRows = (uint32_t)chip16StateGetInt(&r, 4);
+    bool waitingKey = chip16StateGetInt(&r, 1) != 0;
+    Chip16RunResult runEvent = (Chip16RunResult)chip16StateGetInt(&r, 1);
+    uint32_t timerCountdown = (uint32_t)chip16StateGetInt(&r, 4);
+    uint32_t timerRemainder = (uint32_t)chip16StateGetInt(&r, 4);
+    uint32_t rngState = (uint32_t)chip16StateGetInt(&r, 4);
+    unsigned mode = (unsigned)chip16StateGetInt(&r, 1);
+    unsigned currentEffect = (unsigned)chip16StateGetInt(&r, 1);
+    uint8_t effectTimer = (uint8_t)chip16StateGetInt(&r, 1);
+    uint8_t colorIndex = (uint8_t)chip16StateGetInt(&r, 1);
+
+    Chip16StateReader memory = r;
+    chip16StateGetZeroRuns(&r, NULL, MEMORY_SIZE);
+
+    uint8_t gfx[DISPLAY_WIDTH * DISPLAY_HEIGHT];
+    chip16StateGetZeroRuns(&r, gfx, sizeof(gfx));
+
+    if (!r.ok || SP > STACK_SIZE || PC >= MEMORY_SIZE || rngState == 0 ||
+        mode > MODE_16BIT || currentEffect > EFFECT_COLOR_CYCLE ||
+        colorIndex >= COLOR_PALETTE_SIZE)
+    {
+        fprintf(stderr, "Error: Estado guardado truncado o corrupto\n");
+        return false;
+    }
+
+    // Segunda pasada: copiar el estado de la máquina; config y estadísticas
+    // se conservan
+    chip16->opcode = opcode;
+    chip16StateRestoreMemory(chip16, &memory);
+    memcpy(chip16->V, V, sizeof(chip16->V));
+    chip16->I = I;
+    chip16->PC = PC;
+    memcpy(chip16->gfx, gfx, sizeof(chip16->gfx));
+    chip16->delayTimer = delayTimer;
+    chip16->soundTimer = soundTimer;
+    memcpy(chip16->stack, stack, sizeof(chip16->stack));
+    chip16->SP = SP;
+    memcpy(chip16->key, key, KEY_COUNT);
+    chip16->drawFlag = drawFlag;
+    chip16->dirtyRows = dirtyRows;
+    chip16->waitingKey = waitingKey;
+    chip16->runEvent = runEvent;
+    chip16->runCycles = 0;
+    chip16->timerCountdown = timerCountdown;
+    chip16->timerRemainder = timerRemainder;
+    chip16->rngState = rngState;
+    chip16->mode = (EmuMode)mode;
+    chip16->currentEffect = (GraphicsEffects)currentEffect;
+    chip16->effectTimer = effectTimer;
+    chip16->colorIndex = colorIndex;
+
+    return true;
+}
+
+bool chip16SaveStateFile(const Chip16 *chip16, const char *filename)
+{
+    uint8_t buffer[CHIP16_STATE_MAX_SIZE];
+    size_t size = chip16SaveState(chip16, buffer, sizeof(buffer));
+
+    FILE *file = fopen(filename, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "Error: No se pudo crear el archivo %s\n", filename);
+        return false;
+    }
+    bool ok = fwrite(buffer, 1, size, file) == size;
+    if (fclose(file) != 0)
+    {
+        ok = false;
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "Error: No se pudo escribir el estado en %s\n", filename);
+    }
+    return ok;
+}
+
+bool chip16LoadStateFile(Chip16 *chip16, const char *filename)
+{
+    FILE *file = fopen(filename, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "Error: No se pudo abrir el archivo %s\n", filename);
+        return false;
+    }
+
+    // Un byte más que el máximo para detectar archivos demasiado grandes
+    uint8_t buffer[CHIP16_STATE_MAX_SIZE + 1];
+    size_t size = fread(buffer, 1, sizeof(buffer), file);
+    fclose(file);
+
+    if (size > CHIP16_STATE_MAX_SIZE)
+    {
+        fprintf(stderr, "Error: %s no es un estado guardado de CHIP-16\n", filename);
+        return false;
+    }
+    return chip16LoadState(chip16, buffer, size);
+}
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include "config.h"
 
 // Definición del conjunto de fuentes en formato de sprites hexadecimales
@@ -26,7 +27,46 @@ static const uint8_t chip16_fontset[FONTSET_SIZE] = {
 };
 
 
+typedef struct Chip16 Chip16;
+
+// Motivo por el que chip16Run devuelve el control al anfitrión
+typedef enum {
+    CHIP16_RUN_BUDGET,               // Se ejecutaron maxCycles instrucciones sin eventos
+    CHIP16_RUN_DRAW,                 // La pantalla cambió
+    CHIP16_RUN_KEY_WAIT,             // FX0A esperando una tecla (el PC sigue apuntando a FX0A)
+    CHIP16_RUN_TIMER_WRITE,          // Escritura en el delay o sound timer (FX15, FX18)
+    CHIP16_RUN_UNKNOWN_OPCODE        // Opcode 0NNN no soportado
+} Chip16RunResult;
+
+typedef struct Chip16Instr Chip16Instr;
+
+// Manejador que ejecuta una instrucción ya decodificada
+typedef void (*Chip16Handler)(Chip16* chip16, const Chip16Instr* ins);
+
+// Instrucción predecodificada: manejador + campos del opcode
+struct Chip16Instr {
+    Chip16Handler handler;        // Función que ejecuta la instrucción (NULL = entrada no válida)
+    uint16_t opcode;              // Opcode original
+    uint16_t nnn;                 // Dirección de 12 bits
+    uint8_t x;                    // Segundo nibble (registro X)
+    uint8_t y;                    // Tercer nibble (registro Y)
+    uint8_t n;                    // Cuarto nibble
+    uint8_t kk;                   // Byte bajo
+};
+
+// Contadores de la caché de instrucciones predecodificadas
 typedef struct {
+    uint64_t hits;                // Instrucciones servidas desde la caché
+    uint64_t misses;              // Instrucciones decodificadas y guardadas en la caché
+    uint64_t invalidations;       // Entradas invalidadas por escrituras en memoria
+} Chip16CacheStats;
+
+// dirtyRows tiene un bit por fila de pantalla
+#if DISPLAY_HEIGHT > 32
+#error "dirtyRows requiere DISPLAY_HEIGHT <= 32"
+#endif
+
+struct Chip16 {
     uint16_t opcode;              // Opcode actual
     uint8_t memory[MEMORY_SIZE];  // Memoria del sistema
     uint16_t V[REGISTER_COUNT];    // Registros V0-VF
@@ -39,15 +79,37 @@ typedef struct {
     uint16_t SP;                  // Stack Pointer
     uint8_t key[KEY_COUNT];       // Estado del teclado
     bool drawFlag;                // Bandera para indicar si hay que actualizar la pantalla
+    uint32_t dirtyRows;           // Filas modificadas desde el último render (bit y = fila y)
+    bool waitingKey;              // Detenido en FX0A hasta que se pulse una tecla
     Config config;                // Configuración del emulador
     EmuMode mode; 
 
     //2o buffer
-    uint8_t gfx2Buffer[DISPLAY_WIDTH * DISPLAY_HEIGHT]; // Buffer de pantalla secundario
+    uint8_t gfx2Buffer[DISPLAY_WIDTH * DISPLAY_HEIGHT]; // Salida de los efectos que modifican píxeles
     GraphicsEffects currentEffect; // Efecto gráfico actual
     uint8_t effectTimer; // Temporizador para efectos gráficos
     uint8_t colorIndex; // Índice del color actual en el ciclo de colores
-} Chip16;
+
+    // Caché de instrucciones predecodificadas, una entrada por dirección par
+    Chip16Instr icache[MEMORY_SIZE / 2];
+    Chip16CacheStats cacheStats;  // Estadísticas de la caché
+
+    // Estado de chip16Run
+    Chip16RunResult runEvent;     // Evento que detiene chip16Run (CHIP16_RUN_BUDGET = ninguno)
+    uint32_t runCycles;           // Instrucciones ejecutadas en la última llamada a chip16Run
+
+    // Temporizadores por instrucciones (config.cycleTimers)
+    uint32_t timerCountdown;      // Instrucciones hasta el siguiente tick de DT/ST
+    uint32_t timerRemainder;      // Fracción acumulada del periodo (en 1/TIMER_FREQ de instrucción)
+
+    uint32_t rngState;            // Estado del generador de CXKK, E003 y E004 (xorshift32, nunca 0)
+};
+
+// Tamaño máximo de un estado guardado: cabecera y registros más la memoria y
+// la pantalla en el peor caso de la compresión (un byte de control por cada
+// 128 literales)
+#define CHIP16_STATE_MAX_SIZE (160 + MEMORY_SIZE + MEMORY_SIZE / 128 + \
+                               DISPLAY_WIDTH * DISPLAY_HEIGHT + (DISPLAY_WIDTH * DISPLAY_HEIGHT) / 128)
 
 // Funciones principales del emulador
 void chip16Init(Chip16* chip16);
@@ -56,6 +118,46 @@ void chip16Cycle(Chip16* chip16);
 void chip16UpdateTimers(Chip16* chip16);
 void chip16SetKey(Chip16* chip16, uint8_t key, uint8_t value);
 void chip16SetEffect(Chip16* chip16, GraphicsEffects effect);
-void chip16ProcessEffects(Chip16* chip16);
+// Avanzar el efecto activo un frame. Devuelve true si el efecto modifica los
+// píxeles y ha escrito el resultado en gfx2Buffer; con false (sin efecto o un
+// efecto solo de paleta) el renderizador debe leer gfx directamente
+bool chip16ProcessEffects(Chip16* chip16);
+
+// Ejecutar hasta maxCycles instrucciones o hasta el primer evento. Devuelve el
+// motivo de la parada y deja en chip16->runCycles las instrucciones ejecutadas.
+// Con config.cycleTimers también genera los ticks de DT/ST y, detenido en
+// FX0A, consume el presupuesto entero (el tiempo emulado sigue corriendo)
+Chip16RunResult chip16Run(Chip16* chip16, uint32_t maxCycles);
+
+// Temporizadores por instrucciones: DT y ST bajan cada clockSpeed / TIMER_FREQ
+// instrucciones ejecutadas en lugar de en cada chip16UpdateTimers, que pasa a
+// no hacer nada. La ejecución deja de depender del reloj del anfitrión
+void chip16SetCycleTimers(Chip16* chip16, bool enable);
+
+// Invalidar toda la caché de instrucciones (tras modificar la memoria desde fuera del núcleo)
+void chip16FlushCache(Chip16* chip16);
+
+// Sembrar el generador pseudoaleatorio de CXKK, E003 y E004 (chip16Init lo siembra con la hora)
+void chip16Seed(Chip16* chip16, uint32_t seed);
+
+// Guardar el estado de la máquina en buffer (CHIP16_STATE_MAX_SIZE bytes
+// bastan siempre). Devuelve los bytes escritos, o 0 si no caben. No incluye
+// Config: al restaurar se conserva la configuración actual
+size_t chip16SaveState(const Chip16* chip16, uint8_t* buffer, size_t size);
+
+// Como chip16SaveState pero sin comprimir. El resultado, que también lee
+// chip16LoadState, mide siempre lo mismo y cada campo ocupa siempre la misma
+// posición, así que dos estados se pueden comparar byte a byte (rebobinado)
+size_t chip16SaveStateRaw(const Chip16* chip16, uint8_t* buffer, size_t size);
+
+// Restaurar un estado guardado con chip16SaveState. Invalida las entradas de
+// la caché de instrucciones cuya memoria cambia. Si los datos no son válidos
+// devuelve false y el núcleo no cambia. No usa memoria estática: se puede
+// llamar a la vez desde varios hilos con núcleos distintos
+bool chip16LoadState(Chip16* chip16, const uint8_t* buffer, size_t size);
+
+// Variantes en archivo de chip16SaveState y chip16LoadState
+bool chip16SaveStateFile(const Chip16* chip16, const char* filename);
+bool chip16LoadStateFile(Chip16* chip16, const char* filename);
 
 #endif // CHIP16_H
\ No newline at end of file
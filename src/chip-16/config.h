@@ -20,7 +20,7 @@
 #define DEFAULT_PIXEL_COLOR 0x00FF00FF  // Magenta
 
 // Configuraciones de emulación
-#define DEFAULT_SPEED 5  // Retardo en milisegundos entre instrucciones
+#define DEFAULT_SPEED 700  // Instrucciones por segundo (config.clockSpeed)
 #define TIMER_FREQ 60    // Frecuencia de actualización de timers (60Hz)
 
 
@@ -59,9 +59,10 @@ static const uint32_t COLOR_PALETTE[COLOR_PALETTE_SIZE] = {
 // Configuración global
 typedef struct {
     DebugLevel debugLevel;
-    int clockSpeed;
+    int clockSpeed;          // Instrucciones por segundo
     bool enableSound;
     uint32_t pixelColor;
+    bool cycleTimers;        // DT/ST cuentan instrucciones, no llamadas a chip16UpdateTimers
 } Config;
 
 #endif // CONFIG_H
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "display.h"
+#include "blit.h"
 
 // Inicializar el subsistema de visualización
 bool displayInit(Display* display, const char* title) {
@@ -8,10 +9,19 @@ bool displayInit(Display* display, const char* title) {
     strncpy(display->windowTitle, title, 255);
     display->windowTitle[255] = '\0';
     display->dualWindowMode = false;
+    display->lastColor = 0;
+    display->lastDebugColor = 0;
+    display->fullRefresh = true;
+    display->debugFullRefresh = true;
+    display->shownEffect = false;
+    display->redraw = false;
     display->debugWindow = NULL;
     display->debugRenderer = NULL;
     display->debugTexture = NULL;
     
+    // Tabla del kernel de expansión de píxeles
+    blitInit();
+    
     // Crear ventana SDL
     display->window = SDL_CreateWindow(
         display->windowTitle,
@@ -66,7 +76,7 @@ bool displayInit(Display* display, const char* title) {
     return true;
 }
 
-void displayToggleDualWindow(Display* display, Chip16* chip16) {
+void displayToggleDualWindow(Display* display) {
     if (!display->dualWindowMode) {
         // Activar modo dual - crear segunda ventana
         char debugTitle[256];
@@ -126,8 +136,10 @@ void displayToggleDualWindow(Display* display, Chip16* chip16) {
         display->dualWindowMode = true;
         printf("Modo ventana dual: ACTIVADO\n");
         
-        // Forzar redibujado
-        chip16->drawFlag = true;
+        // Forzar redibujado completo (la textura nueva está vacía) sin esperar
+        // a que el hilo de emulación publique otro frame
+        display->debugFullRefresh = true;
+        display->redraw = true;
         
     } else {
         // Desactivar modo dual - destruir segunda ventana
@@ -149,52 +161,70 @@ void displayToggleDualWindow(Display* display, Chip16* chip16) {
     }
 }
 
-// Renderizar el estado actual del emulador
-void displayRender(Display* display, Chip16* chip16, const char* colorArg) {
-    if (!chip16->drawFlag) {
-        return;  // No hay necesidad de actualizar la pantalla
+// Subir a una textura de streaming las filas marcadas en dirty. Se bloquea el
+// bloque entre la primera y la última fila modificadas y se expande cada fila
+// en su memoria respetando el pitch, sin buffer intermedio. Si el bloqueo falla
+// se usa un buffer temporal y SDL_UpdateTexture con el mismo rectángulo
+static void displayUpload(SDL_Texture* texture, const uint8_t* gfx, uint32_t dirty, uint32_t color) {
+    if (dirty == 0) {
+        return;
+    }
+    
+    int first = __builtin_ctz(dirty);
+    int count = 32 - __builtin_clz(dirty) - first;
+    const uint8_t* src = &gfx[first * DISPLAY_WIDTH];
+    SDL_Rect rect = {0, first, DISPLAY_WIDTH, count};
+    void* locked;
+    int pitch;
+    
+    if (SDL_LockTexture(texture, &rect, &locked, &pitch) == 0) {
+        if (pitch == DISPLAY_WIDTH * (int)sizeof(uint32_t)) {
+            blitBytesToRGBA(locked, src, count * DISPLAY_WIDTH, color);
+        } else {
+            for (int y = 0; y < count; y++) {
+                blitBytesToRGBA((uint32_t*)((uint8_t*)locked + y * pitch),
+                                &src[y * DISPLAY_WIDTH], DISPLAY_WIDTH, color);
+            }
+        }
+        SDL_UnlockTexture(texture);
+        return;
     }
+    
+    uint32_t pixels[DISPLAY_WIDTH * DISPLAY_HEIGHT];
+    blitBytesToRGBA(pixels, src, count * DISPLAY_WIDTH, color);
+    SDL_UpdateTexture(texture, &rect, pixels, DISPLAY_WIDTH * sizeof(uint32_t));
+}
 
-    chip16ProcessEffects(chip16);
+// Mostrar un frame publicado por el hilo de emulación. SDL_RenderPresent
+// espera al vsync: aquí solo se bloquea el hilo de presentación
+void displayRender(Display* display, const Frame* frame, const char* colorArg) {
+    // Los efectos de paleta se aplican al expandir; solo los que modifican
+    // píxeles dejan su resultado en effect[]
+    const uint8_t* pixels = frame->pixelEffect ? frame->effect : frame->gfx;
     
     // Determinar el color del pixel
     uint32_t pixelColor;
-    // if (colorArg != NULL) {
-    //     // Convertir argumento de color de string a uint32
-    //     pixelColor = strtoul(colorArg, NULL, 16);
-    // } else {
-    //     // Usar color predeterminado
-    //     pixelColor = chip16->config.pixelColor;
-    // }
-
-     // === NUEVO: Lógica de selección de color según el efecto ===
-     if (chip16->currentEffect == EFFECT_COLOR_CYCLE) {
+    if (frame->colorCycle) {
         // Si el efecto está activo, usar el color de la paleta
-        pixelColor = COLOR_PALETTE[chip16->colorIndex];
+        pixelColor = COLOR_PALETTE[frame->colorIndex];
     } else if (colorArg != NULL) {
         // Si no hay efecto pero hay argumento de línea de comandos
         pixelColor = strtoul(colorArg, NULL, 16);
     } else {
         // Color por defecto
-        pixelColor = chip16->config.pixelColor;
-    }
-    
-    // Crear buffer de pixels para la textura
-    uint32_t pixels[DISPLAY_WIDTH * DISPLAY_HEIGHT];
-    memset(pixels, 0, sizeof(pixels));  // Limpiar buffer con negro
-    
-    // Convertir el estado de gfx[] a pixeles con color
-    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
-        for (int x = 0; x < DISPLAY_WIDTH; x++) {
-            int index = x + (y * DISPLAY_WIDTH);
-            if (chip16->gfx2Buffer[index] == 1) {
-                pixels[index] = pixelColor;
-            }
-        }
+        pixelColor = frame->pixelColor;
     }
     
-    // Actualizar textura con nuevos datos
-    SDL_UpdateTexture(display->texture, NULL, pixels, DISPLAY_WIDTH * sizeof(uint32_t));
+    // El frame trae las filas de gfx[] cambiadas desde el último que se
+    // mostró, incluidas las de los frames descartados entre medias. Un cambio
+    // de color (por ejemplo, el ciclo de colores) invalida la textura entera,
+    // igual que un efecto de píxeles en este frame o en el que se mostró
+    bool full = display->fullRefresh || pixelColor != display->lastColor ||
+                frame->pixelEffect || display->shownEffect;
+    display->lastColor = pixelColor;
+    display->fullRefresh = false;
+    display->shownEffect = frame->pixelEffect;
+    displayUpload(display->texture, pixels, full ? UINT32_MAX : frame->dirtyRows, pixelColor);
     
     // Renderizar
     SDL_RenderClear(display->renderer);
@@ -203,34 +233,26 @@ void displayRender(Display* display, Chip16* chip16, const char* colorArg) {
     
 
     if (display->dualWindowMode && display->debugWindow) {
-        // Limpiar buffer de pixels
-        memset(pixels, 0, sizeof(pixels));
-        
         // Determinar color para la ventana de debug (siempre sin efectos)
         uint32_t debugColor;
         if (colorArg != NULL) {
             debugColor = strtoul(colorArg, NULL, 16);
         } else {
-            debugColor = chip16->config.pixelColor;
+            debugColor = frame->pixelColor;
         }
         
         // Usar gfx[] original para la ventana de debug
-        for (int y = 0; y < DISPLAY_HEIGHT; y++) {
-            for (int x = 0; x < DISPLAY_WIDTH; x++) {
-                int index = x + (y * DISPLAY_WIDTH);
-                if (chip16->gfx[index] == 1) {  // <-- Nota: usamos gfx, no effectBuffer
-                    pixels[index] = debugColor;
-                }
-            }
-        }
+        bool debugFull = display->debugFullRefresh || debugColor != display->lastDebugColor;
+        display->lastDebugColor = debugColor;
+        display->debugFullRefresh = false;
+        displayUpload(display->debugTexture, frame->gfx,
+                      debugFull ? UINT32_MAX : frame->dirtyRows, debugColor);
         
-        SDL_UpdateTexture(display->debugTexture, NULL, pixels, DISPLAY_WIDTH * sizeof(uint32_t));
         SDL_RenderClear(display->debugRenderer);
         SDL_RenderCopy(display->debugRenderer, display->debugTexture, NULL, NULL);
         SDL_RenderPresent(display->debugRenderer);
     }
-    // Restablecer flag de dibujo
-    chip16->drawFlag = false;
+    display->redraw = false;
 }
 
 // Liberar recursos del subsistema de visualización
@@ -3,6 +3,7 @@
 
 #include <SDL2/SDL.h>
 #include "chip16.h"
+#include "frames.h"
 
 // Estructura para gestionar la visualización
 typedef struct {
@@ -16,12 +17,18 @@ typedef struct {
     SDL_Texture* debugTexture;      // Textura de debug
     char debugWindowTitle[256]; // Título de la ventana de debug
     bool dualWindowMode;            // ¿Modo doble ventana activo?
+    uint32_t lastColor;             // Color del último render: si cambia se sube la pantalla entera
+    uint32_t lastDebugColor;        // Ídem para la ventana de debug
+    bool fullRefresh;               // La textura no refleja el último frame (recién creada)
+    bool debugFullRefresh;          // Ídem para la textura de debug
+    bool shownEffect;               // La textura contiene la salida de un efecto de píxeles
+    bool redraw;                    // Volver a mostrar el último frame aunque no haya uno nuevo
 } Display;
 
 // Funciones de visualización
 bool displayInit(Display* display, const char* title);
-void displayRender(Display* display, Chip16* chip16, const char* colorArg);
+void displayRender(Display* display, const Frame* frame, const char* colorArg);
 void displayCleanup(Display* display);
-void displayToggleDualWindow(Display* display, Chip16* chip16);
+void displayToggleDualWindow(Display* display);
 
 #endif // DISPLAY_H
\ No newline at end of file
@@ -0,0 +1,54 @@
+#ifndef FRAMES_H
+#define FRAMES_H
+
+#include <SDL2/SDL.h>
+#include "chip16.h"
+
+// Triple buffer sin bloqueos entre el hilo de emulación (escritor) y el de
+// presentación (lector)
+//
+// El escritor rellena su buffer y lo intercambia atómicamente por el
+// intermedio; el lector, si hay un frame nuevo, intercambia el suyo por el
+// intermedio. Ninguno espera al otro: la emulación nunca se detiene por un
+// SDL_RenderPresent lento y el lector siempre obtiene el frame completo más
+// reciente (los intermedios que no llegue a ver se descartan).
+//
+// Cada frame lleva las filas que cambian respecto al último que el lector
+// tomó, para que este suba solo esas. Como el escritor no sabe si el lector
+// llegará a ver el frame que publica, arrastra las filas de los frames que
+// publicó desde el último que sabe leído: el conjunto puede sobrar, pero no
+// faltar.
+
+// Frame completo publicado por el hilo de emulación
+typedef struct {
+    uint8_t gfx[DISPLAY_WIDTH * DISPLAY_HEIGHT];     // Framebuffer sin efectos
+    uint8_t effect[DISPLAY_WIDTH * DISPLAY_HEIGHT];  // gfx2Buffer, solo si pixelEffect
+    bool pixelEffect;               // Un efecto de píxeles escribió effect[]
+    bool colorCycle;                // Ciclo de color activo: usar COLOR_PALETTE[colorIndex]
+    uint8_t colorIndex;             // Índice del ciclo de color
+    uint32_t pixelColor;            // config.pixelColor del núcleo
+    uint32_t dirtyRows;             // Filas cambiadas desde el último frame leído (bit y = fila y)
+} Frame;
+
+typedef struct {
+    Frame buffers[3];
+    SDL_atomic_t middle;            // Índice del buffer intermedio | FRAMES_FRESH si no se ha leído
+    int back;                       // Buffer del escritor (solo el hilo de emulación)
+    int front;                      // Buffer del lector (solo el hilo de presentación)
+    uint32_t unseen;                // Filas de los frames publicados sin leer (solo el escritor)
+} Frames;
+
+void framesInit(Frames* frames);
+
+// Escritor: buffer a rellenar y publicación del frame terminado. Antes de
+// publicar, dirtyRows del frame son las filas cambiadas desde el anterior
+// publicado; framesPublish les añade las de los que el lector no ha visto
+Frame* framesBack(Frames* frames);
+void framesPublish(Frames* frames);
+
+// Lector: frame más reciente si hay uno nuevo desde la última llamada (NULL si
+// no) y último frame obtenido, válido hasta la siguiente llamada a framesAcquire
+const Frame* framesAcquire(Frames* frames);
+const Frame* framesFront(const Frames* frames);
+
+#endif // FRAMES_H
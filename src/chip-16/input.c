@@ -1,7 +1,79 @@
+#include <stdio.h>
 #include "input.h"
 
-// Procesar eventos de entrada
-bool inputProcess(SDL_Event* event, Chip16* chip16, Display* display) {
+#define INPUT_QUEUE_MASK (INPUT_QUEUE_SIZE - 1)
+
+// Encolar un evento (solo desde inputWatch)
+static void inputPush(InputState* input, Uint64 time, InputEventType type, uint8_t key) {
+    unsigned head = (unsigned)SDL_AtomicGet(&input->head);
+    if (head - (unsigned)SDL_AtomicGet(&input->tail) == INPUT_QUEUE_SIZE) {
+        fprintf(stderr, "Aviso: cola de entrada llena, evento descartado\n");
+        return;
+    }
+    
+    InputEvent* event = &input->queue[head & INPUT_QUEUE_MASK];
+    event->time = time;
+    event->type = (uint8_t)type;
+    event->key = key;
+    
+    // SDL_AtomicSet es un intercambio con barrera completa: el evento es
+    // visible para el consumidor antes que el nuevo head
+    SDL_AtomicSet(&input->head, (int)(head + 1));
+}
+
+// Captura de teclas: SDL la llama al recibir cada evento, antes de
+// encolarlo para SDL_PollEvent
+static int inputWatch(void* userdata, SDL_Event* event) {
+    InputState* input = userdata;
+    
+    if ((event->type != SDL_KEYDOWN && event->type != SDL_KEYUP) || event->key.repeat) {
+        return 0;
+    }
+    
+    Uint64 now = SDL_GetPerformanceCounter();
+    SDL_Keycode sym = event->key.keysym.sym;
+    bool down = event->type == SDL_KEYDOWN;
+    int key;
+    
+    if (sym == SDLK_TAB) {
+        // Avance rápido mientras se mantenga pulsada
+        SDL_AtomicSet(&input->turbo, down ? 1 : 0);
+    } else if (sym == SDLK_BACKSPACE) {
+        // Rebobinar mientras se mantenga pulsada
+        SDL_AtomicSet(&input->rewind, down ? 1 : 0);
+    } else if (sym == SDLK_F1) {
+        // Reiniciar emulador
+        if (down) {
+            inputPush(input, now, INPUT_RESET, 0);
+        }
+    } else if (sym == SDLK_F2) {
+        // Toggle del efecto de ciclo de color
+        if (down) {
+            inputPush(input, now, INPUT_TOGGLE_EFFECT, 0);
+        }
+    } else if ((key = inputMapKey(sym)) >= 0) {
+        // Mapear otras teclas al teclado CHIP-8
+        inputPush(input, now, down ? INPUT_KEY_DOWN : INPUT_KEY_UP, (uint8_t)key);
+    }
+    
+    return 0;
+}
+
+void inputInit(InputState* input) {
+    SDL_AtomicSet(&input->head, 0);
+    SDL_AtomicSet(&input->tail, 0);
+    SDL_AtomicSet(&input->turbo, 0);
+    SDL_AtomicSet(&input->rewind, 0);
+    SDL_AddEventWatch(inputWatch, input);
+}
+
+void inputCleanup(InputState* input) {
+    SDL_DelEventWatch(inputWatch, input);
+}
+
+// Procesar eventos de la ventana (las teclas del emulador ya las ha
+// encolado inputWatch)
+bool inputProcess(SDL_Event* event, Display* display) {
     bool quit = false;
     
     while (SDL_PollEvent(event)) {
@@ -13,48 +85,19 @@ bool inputProcess(SDL_Event* event, Chip16* chip16, Display* display) {
             case SDL_KEYDOWN:
                 if (event->key.keysym.sym == SDLK_ESCAPE) {
                     quit = true;
-                } else if (event->key.keysym.sym == SDLK_F1) {
-                    // Reiniciar emulador
-                    chip16Init(chip16);
-                    return false;  // Continuar ejecución
-                } 
-                else if (event->key.keysym.sym == SDLK_F2) {
-                    // Toggle del efecto de ciclo de color
-                    if (chip16->currentEffect == EFFECT_COLOR_CYCLE) {
-                        chip16SetEffect(chip16, EFFECT_NONE);
-                        printf("Efecto de ciclo de color: DESACTIVADO\n");
-                    } else {
-                        chip16SetEffect(chip16, EFFECT_COLOR_CYCLE);
-                        printf("Efecto de ciclo de color: ACTIVADO\n");
-                    }
-                }
-
-                else if (event->key.keysym.sym == SDLK_F3) {
+                } else if (event->key.keysym.sym == SDLK_F3) {
                     // Toggle del modo ventana dual
-                    displayToggleDualWindow(display, chip16);
-                }
-
-                else {
-                    // Mapear otras teclas al teclado CHIP-8
-                    inputMapKey(event, chip16, true);
+                    displayToggleDualWindow(display);
                 }
                 break;
-                
-            case SDL_KEYUP:
-                // Mapear tecla liberada al teclado CHIP-8
-                inputMapKey(event, chip16, false);
-                break;
         }
     }
     
     return quit;
 }
 
-// Mapear teclas SDL a teclas CHIP-8
-void inputMapKey(SDL_Event* event, Chip16* chip16, bool keyDown) {
-    uint8_t keyValue = keyDown ? 1 : 0;
-    SDL_Keycode key = event->key.keysym.sym;
-    
+// Mapear teclas SDL a teclas CHIP-8 (-1 si la tecla no está asignada)
+int inputMapKey(SDL_Keycode key) {
     // Mapeo basado en la disposición original del teclado hexadecimal CHIP-8
     // 1 2 3 C    ->    1 2 3 4
     // 4 5 6 D    ->    Q W E R
@@ -62,21 +105,68 @@ void inputMapKey(SDL_Event* event, Chip16* chip16, bool keyDown) {
     // A 0 B F    ->    Z X C V
     
     switch (key) {
-        case SDLK_x: chip16SetKey(chip16, 0x0, keyValue); break;  // 0
-        case SDLK_1: chip16SetKey(chip16, 0x1, keyValue); break;  // 1
-        case SDLK_2: chip16SetKey(chip16, 0x2, keyValue); break;  // 2
-        case SDLK_3: chip16SetKey(chip16, 0x3, keyValue); break;  // 3
-        case SDLK_q: chip16SetKey(chip16, 0x4, keyValue); break;  // 4
-        case SDLK_w: chip16SetKey(chip16, 0x5, keyValue); break;  // 5
-        case SDLK_e: chip16SetKey(chip16, 0x6, keyValue); break;  // 6
-        case SDLK_a: chip16SetKey(chip16, 0x7, keyValue); break;  // 7
-        case SDLK_s: chip16SetKey(chip16, 0x8, keyValue); break;  // 8
-        case SDLK_d: chip16SetKey(chip16, 0x9, keyValue); break;  // 9
-        case SDLK_z: chip16SetKey(chip16, 0xA, keyValue); break;  // A
-        case SDLK_c: chip16SetKey(chip16, 0xB, keyValue); break;  // B
-        case SDLK_4: chip16SetKey(chip16, 0xC, keyValue); break;  // C
-        case SDLK_r: chip16SetKey(chip16, 0xD, keyValue); break;  // D
-        case SDLK_f: chip16SetKey(chip16, 0xE, keyValue); break;  // E
-        case SDLK_v: chip16SetKey(chip16, 0xF, keyValue); break;  // F
+        case SDLK_x: return 0x0;
+        case SDLK_1: return 0x1;
+        case SDLK_2: return 0x2;
+        case SDLK_3: return 0x3;
+        case SDLK_q: return 0x4;
+        case SDLK_w: return 0x5;
+        case SDLK_e: return 0x6;
+        case SDLK_a: return 0x7;
+        case SDLK_s: return 0x8;
+        case SDLK_d: return 0x9;
+        case SDLK_z: return 0xA;
+        case SDLK_c: return 0xB;
+        case SDLK_4: return 0xC;
+        case SDLK_r: return 0xD;
+        case SDLK_f: return 0xE;
+        case SDLK_v: return 0xF;
+        default:     return -1;
     }
-}
\ No newline at end of file
+}
+
+bool inputNext(InputState* input, Uint64 until, InputEvent* event) {
+    unsigned tail = (unsigned)SDL_AtomicGet(&input->tail);
+    if (tail == (unsigned)SDL_AtomicGet(&input->head)) {
+        return false;
+    }
+    
+    const InputEvent* next = &input->queue[tail & INPUT_QUEUE_MASK];
+    if (next->time > until) {
+        return false;
+    }
+    
+    *event = *next;
+    SDL_AtomicSet(&input->tail, (int)(tail + 1));
+    return true;
+}
+
+void inputApply(Chip16* chip16, const InputEvent* event) {
+    switch (event->type) {
+        case INPUT_KEY_DOWN:
+            chip16SetKey(chip16, event->key, 1);
+            break;
+            
+        case INPUT_KEY_UP:
+            chip16SetKey(chip16, event->key, 0);
+            break;
+            
+        case INPUT_RESET: {
+            // El reinicio conserva la configuración (velocidad, color...)
+            Config config = chip16->config;
+            chip16Init(chip16);
+            chip16->config = config;
+            break;
+        }
+            
+        case INPUT_TOGGLE_EFFECT:
+            if (chip16->currentEffect == EFFECT_COLOR_CYCLE) {
+                chip16SetEffect(chip16, EFFECT_NONE);
+                printf("Efecto de ciclo de color: DESACTIVADO\n");
+            } else {
+                chip16SetEffect(chip16, EFFECT_COLOR_CYCLE);
+                printf("Efecto de ciclo de color: ACTIVADO\n");
+            }
+            break;
+    }
+}
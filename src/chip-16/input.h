@@ -5,8 +5,58 @@
 #include "chip16.h"
 #include "display.h"
 
-// Manejo de entrada del usuario
-bool inputProcess(SDL_Event* event, Chip16* chip16, Display* display);
-void inputMapKey(SDL_Event* event, Chip16* chip16, bool keyDown);
+// Entrada del usuario como cola de eventos con marca de tiempo
+//
+// Las pulsaciones se capturan con un SDL_AddEventWatch en el momento en que
+// SDL las recibe (dentro del bombeo de eventos del hilo principal, el único
+// desde el que SDL permite leerlas), se marcan con SDL_GetPerformanceCounter
+// y pasan al hilo de emulación por una cola circular sin bloqueos de un solo
+// productor y un solo consumidor. El hilo de emulación aplica cada evento en
+// la instrucción del lote que corresponde a su marca, con al menos una
+// instrucción entre una pulsación y lo que venga detrás (replaySpaceEvent),
+// así que una pulsación y su liberación dentro del mismo lote no se pierden.
+//
+// La marca es la del bombeo, no la de la pulsación: el hilo principal también
+// presenta y, con vsync, se queda parado en SDL_RenderPresent hasta el
+// siguiente refresco, así que las teclas que llegan mientras tanto salen con
+// la misma marca. La latencia queda cuantizada al periodo de refresco (hasta
+// ~16 ms a 60 Hz). event.key.timestamp no lo evita: SDL la pone al bombear
 
-#endif // INPUT_H
\ No newline at end of file
+#define INPUT_QUEUE_SIZE 256  // Eventos en vuelo (potencia de 2)
+
+typedef enum {
+    INPUT_KEY_DOWN,         // Tecla key pulsada
+    INPUT_KEY_UP,           // Tecla key liberada
+    INPUT_RESET,            // F1: reiniciar el núcleo
+    INPUT_TOGGLE_EFFECT     // F2: activar/desactivar el ciclo de color
+} InputEventType;
+
+typedef struct {
+    Uint64 time;            // SDL_GetPerformanceCounter al recibir el evento
+    uint8_t type;           // InputEventType
+    uint8_t key;            // Tecla CHIP-8 (eventos de tecla)
+} InputEvent;
+
+typedef struct {
+    InputEvent queue[INPUT_QUEUE_SIZE];
+    SDL_atomic_t head;      // Eventos escritos (solo lo avanza el hilo principal)
+    SDL_atomic_t tail;      // Eventos leídos (solo lo avanza el hilo de emulación)
+    SDL_atomic_t turbo;     // Tab pulsado: avance rápido
+    SDL_atomic_t rewind;    // Retroceso pulsado: rebobinar
+} InputState;
+
+// Manejo de entrada del usuario. inputInit registra la captura de eventos
+// (después de SDL_Init) e inputCleanup la retira
+void inputInit(InputState* input);
+void inputCleanup(InputState* input);
+bool inputProcess(SDL_Event* event, Display* display);
+int inputMapKey(SDL_Keycode key);
+
+// Sacar de la cola el siguiente evento si llegó antes de until (desde el
+// hilo de emulación)
+bool inputNext(InputState* input, Uint64 until, InputEvent* event);
+
+// Aplicar un evento al núcleo (desde el hilo de emulación)
+void inputApply(Chip16* chip16, const InputEvent* event);
+
+#endif // INPUT_H
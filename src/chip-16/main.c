@@ -1,14 +1,333 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <SDL2/SDL.h>
 #include "chip16.h"
+#include "audio.h"
 #include "display.h"
+#include "frames.h"
 #include "input.h"
+#include "replay.h"
+#include "rewind.h"
+
+#define FRAME_MAX_LAG 5  // Frames de retraso a partir de los cuales no se recuperan
+#define TURBO_DEFAULT_FACTOR 0  // Velocidad con Tab pulsado (0 = sin límite)
+#define RUN_AHEAD_MAX_FRAMES 8  // Frames de adelanto como máximo
+
+// Estado compartido con el hilo de emulación
+typedef struct {
+    Chip16* chip16;
+    Frames* frames;
+    InputState* input;
+    Audio* audio;
+    SDL_atomic_t quit;
+    SDL_atomic_t presentCost;   // Coste medio de displayRender en µs (lo mide el hilo principal)
+    Uint32 frameEvent;          // Evento que despierta al hilo principal al publicar ((Uint32)-1 = ninguno)
+    SDL_atomic_t frameWake;     // Ya hay un frameEvent en la cola sin atender
+    int turboFactor;            // Multiplicador de velocidad en turbo (0 = sin límite)
+    Rewind* rewind;             // Historial para rebobinar (NULL = desactivado)
+    uint8_t* rewindState;       // Estado sin comprimir del frame (CHIP16_STATE_MAX_SIZE bytes)
+    uint16_t heldKeys;          // Teclas pulsadas según la cola de entrada (bit k = tecla k)
+    Replay* replay;             // Grabación de la entrada (NULL = no se graba)
+    uint64_t emulated;          // Frames emulados desde el inicio (posición en la grabación)
+    int runAhead;               // Frames de adelanto al presentar (0 = desactivado)
+    uint8_t* aheadState;        // Estado real mientras se adelanta (CHIP16_STATE_MAX_SIZE bytes)
+} Emulation;
+
+// Publicar la pantalla del núcleo en el triple buffer. Los efectos avanzan
+// un paso por frame publicado, como antes por frame dibujado
+static void emulationPublish(Emulation* emu) {
+    Chip16* chip16 = emu->chip16;
+    Frame* frame = framesBack(emu->frames);
+    
+    frame->pixelEffect = chip16ProcessEffects(chip16);
+    memcpy(frame->gfx, chip16->gfx, sizeof(frame->gfx));
+    if (frame->pixelEffect) {
+        memcpy(frame->effect, chip16->gfx2Buffer, sizeof(frame->effect));
+    }
+    frame->colorCycle = chip16->currentEffect == EFFECT_COLOR_CYCLE;
+    frame->colorIndex = chip16->colorIndex;
+    frame->pixelColor = chip16->config.pixelColor;
+    frame->dirtyRows = chip16->dirtyRows;
+    framesPublish(emu->frames);
+    
+    // Despertar al hilo principal, que duerme en SDL_WaitEvent sin frames
+    // nuevos. Basta un evento en la cola hasta que lo atienda
+    if (emu->frameEvent != (Uint32)-1 && SDL_AtomicCAS(&emu->frameWake, 0, 1)) {
+        SDL_Event wake;
+        SDL_zero(wake);
+        wake.type = emu->frameEvent;
+        SDL_PushEvent(&wake);
+    }
+    
+    chip16->drawFlag = false;
+    chip16->dirtyRows = 0;
+}
+
+// Ejecutar las instrucciones del frame hasta la posición target. Una espera
+// de tecla (FX0A) no avanza hasta el siguiente evento de entrada, así que el
+// resto del tramo se descarta
+static void emulationRunTo(Emulation* emu, uint32_t* executed, uint32_t target) {
+    Chip16* chip16 = emu->chip16;
+    
+    while (*executed < target) {
+        Chip16RunResult reason = chip16Run(chip16, target - *executed);
+        *executed += chip16->runCycles;
+        if (reason == CHIP16_RUN_KEY_WAIT) {
+            break;
+        }
+    }
+    *executed = target;
+}
+
+// Seguir qué teclas están pulsadas para devolverlas al núcleo al terminar
+// de rebobinar
+static void emulationTrackKey(Emulation* emu, const InputEvent* event) {
+    if (event->type == INPUT_KEY_DOWN) {
+        emu->heldKeys |= (uint16_t)(1u << event->key);
+    } else if (event->type == INPUT_KEY_UP) {
+        emu->heldKeys &= (uint16_t)~(1u << event->key);
+    }
+}
+
+// Guardar el estado del frame recién terminado en el historial
+static void emulationRecord(Emulation* emu) {
+    size_t size = chip16SaveStateRaw(emu->chip16, emu->rewindState, CHIP16_STATE_MAX_SIZE);
+    if (size > 0) {
+        rewindPush(emu->rewind, emu->rewindState, size);
+    }
+}
+
+// Retroceder un frame en el historial. Mientras se rebobina la entrada no
+// llega al núcleo: solo se anotan las teclas pulsadas, que se restauran al
+// soltar Retroceso
+static void emulationRewind(Emulation* emu, Uint64 inputEnd) {
+    Chip16* chip16 = emu->chip16;
+    InputEvent event;
+    
+    while (inputNext(emu->input, inputEnd, &event)) {
+        emulationTrackKey(emu, &event);
+    }
+    
+    size_t size = rewindStep(emu->rewind, emu->rewindState);
+    if (size == 0 || !chip16LoadState(chip16, emu->rewindState, size)) {
+        return;
+    }
+    // El estado restaurado no sigue a la pantalla publicada
+    chip16->drawFlag = true;
+    chip16->dirtyRows = UINT32_MAX;
+}
+
+// Devolver al núcleo las teclas pulsadas ahora, no las del frame restaurado
+static void emulationRestoreKeys(Emulation* emu) {
+    for (uint8_t key = 0; key < KEY_COUNT; key++) {
+        chip16SetKey(emu->chip16, key, (emu->heldKeys >> key) & 1);
+    }
+}
+
+// Presentar el futuro (run-ahead): guardar el estado, emular runAhead frames
+// más con la entrada actual, publicar la pantalla resultante y volver al
+// estado guardado. Oculta los frames de retraso que muchos juegos meten
+// entre la tecla y la pantalla (bucles de espera sobre el delay timer) a
+// cambio de repetir runAhead frames de emulación por frame. cycleRemainder
+// es el del frame real, para que los adelantados tengan su mismo presupuesto
+static void emulationRunAhead(Emulation* emu, uint32_t cycleRemainder) {
+    Chip16* chip16 = emu->chip16;
+    size_t size = chip16SaveStateRaw(chip16, emu->aheadState, CHIP16_STATE_MAX_SIZE);
+    if (size == 0) {
+        return;
+    }
+    
+    for (int i = 0; i < emu->runAhead; i++) {
+        cycleRemainder += (uint32_t)chip16->config.clockSpeed;
+        uint32_t cycleTarget = cycleRemainder / TIMER_FREQ;
+        cycleRemainder %= TIMER_FREQ;
+        uint32_t executed = 0;
+        emulationRunTo(emu, &executed, cycleTarget);
+        chip16UpdateTimers(chip16);
+    }
+    
+    bool published = chip16->drawFlag;
+    if (published) {
+        emulationPublish(emu);
+    }
+    
+    // Los efectos avanzan al publicar: su progreso no se deshace
+    uint8_t effectTimer = chip16->effectTimer;
+    uint8_t colorIndex = chip16->colorIndex;
+    
+    chip16LoadState(chip16, emu->aheadState, size);
+    chip16->effectTimer = effectTimer;
+    chip16->colorIndex = colorIndex;
+    if (published) {
+        // La pantalla publicada es la del futuro, no la del estado real: el
+        // siguiente frame publicado se sube entero
+        chip16->drawFlag = false;
+        chip16->dirtyRows = UINT32_MAX;
+    }
+}
+
+// Hilo de emulación: ejecuta el núcleo frame a frame y publica cada pantalla
+// terminada en el triple buffer, sin esperar nunca al vsync.
+//
+// Los frames se planifican con plazos absolutos medidos con
+// SDL_GetPerformanceCounter: tras cada frame el hilo duerme hasta el inicio
+// del siguiente, así que los errores de SDL_Delay no se acumulan. El
+// presupuesto de instrucciones de cada frame arrastra la fracción sobrante
+// del anterior, de modo que en un segundo se ejecutan exactamente
+// config.clockSpeed instrucciones.
+//
+// La entrada llegada durante el frame anterior se reparte por el lote: cada
+// evento se aplica en la instrucción proporcional a su instante dentro de
+// esa ventana, con un frame de latencia constante.
+//
+// Con Tab pulsado (turbo) los frames emulados se suceden turboFactor veces
+// más rápido, o sin pausa con 0. Solo se publica uno de cada frameSkip frames
+// con dibujo (drawFlag sigue activo hasta entonces), con frameSkip elegido a
+// partir del coste medido de la presentación para que el hilo principal
+// nunca se quede atrás.
+//
+// Cada frame terminado se guarda en el historial de rebobinado; con
+// Retroceso pulsado, en lugar de emular se restaura un frame anterior por
+// cada frame. Con adelanto (runAhead) a velocidad normal se presenta el
+// frame que habrá dentro de runAhead frames
+static int emulationThread(void* data) {
+    Emulation* emu = data;
+    Chip16* chip16 = emu->chip16;
+    
+    Uint64 frequency = SDL_GetPerformanceFrequency();
+    Uint64 start = SDL_GetPerformanceCounter();
+    uint64_t frame = 0;             // Frames desde start
+    uint32_t cycleRemainder = 0;    // Fracción de instrucción pendiente (en 1/TIMER_FREQ)
+    int speed = 1;                  // Multiplicador activo (0 = sin límite)
+    uint32_t frameSkip = 1;         // En turbo, publicar un frame de cada frameSkip
+    uint32_t skipped = 0;           // Frames con dibujo sin publicar desde el último
+    double frameTicks = 0;          // Duración media de un frame emulado en turbo (ticks)
+    Uint64 lastFrameTime = start;
+    Uint64 inputTime = start;       // Fin de la ventana de entrada del frame anterior
+    bool rewinding = false;         // Rebobinando en el frame anterior
+    
+    while (!SDL_AtomicGet(&emu->quit)) {
+        // Cambiar de velocidad reinicia la planificación
+        int wanted = SDL_AtomicGet(&emu->input->turbo) ? emu->turboFactor : 1;
+        if (wanted != speed) {
+            speed = wanted;
+            start = SDL_GetPerformanceCounter();
+            frame = 0;
+            frameSkip = 1;
+            skipped = 0;
+        }
+        
+        // Con Retroceso pulsado se restaura el frame anterior en lugar de
+        // emular uno nuevo. Al soltarlo el núcleo recupera las teclas que
+        // estén pulsadas en ese momento
+        bool rewindHeld = emu->rewind != NULL && SDL_AtomicGet(&emu->input->rewind);
+        if (rewindHeld) {
+            inputTime = SDL_GetPerformanceCounter();
+            emulationRewind(emu, inputTime);
+        } else {
+            if (rewinding) {
+                emulationRestoreKeys(emu);
+            }
+            
+            // Presupuesto del frame: clockSpeed / TIMER_FREQ más lo que sobró
+            cycleRemainder += (uint32_t)chip16->config.clockSpeed;
+            uint32_t cycleTarget = cycleRemainder / TIMER_FREQ;
+            cycleRemainder %= TIMER_FREQ;
+            
+            // Aplicar los eventos de entrada de la ventana [inputTime, now) en
+            // su posición del lote y ejecutar el resto del presupuesto
+            Uint64 inputEnd = SDL_GetPerformanceCounter();
+            Uint64 window = inputEnd - inputTime;
+            uint32_t executed = 0;
+            uint32_t nextAt = 0;
+            InputEvent event;
+            while (inputNext(emu->input, inputEnd, &event)) {
+                uint32_t at = 0;
+                if (event.time > inputTime && window > 0) {
+                    at = (uint32_t)((event.time - inputTime) * cycleTarget / window);
+                }
+                at = replaySpaceEvent(at, event.type, cycleTarget, &nextAt);
+                emulationRunTo(emu, &executed, at);
+                emulationTrackKey(emu, &event);
+                inputApply(chip16, &event);
+                if (emu->replay != NULL) {
+                    // La grabación anota dónde se aplicó; tras un reinicio
+                    // la semilla es la suya, no la hora
+                    replayWrite(emu->replay, emu->emulated, at, event.type, event.key);
+                    if (event.type == INPUT_RESET) {
+                        chip16Seed(chip16, emu->replay->seed);
+                    }
+                }
+            }
+            inputTime = inputEnd;
+            emulationRunTo(emu, &executed, cycleTarget);
+            
+            // Temporizadores a 60Hz: un tick por frame
+            chip16UpdateTimers(chip16);
+            emu->emulated++;
+            
+            if (emu->rewind != NULL) {
+                emulationRecord(emu);
+            }
+        }
+        rewinding = rewindHeld;
+        
+        // El pitido suena mientras ST > 0: solo se escribe la bandera que lee
+        // el callback de audio
+        audioSetTone(emu->audio, chip16->config.enableSound && chip16->soundTimer > 0);
+        
+        // Publicar la pantalla si ha cambiado (en turbo, una de cada frameSkip)
+        if (emu->runAhead > 0 && speed == 1 && !rewindHeld) {
+            emulationRunAhead(emu, cycleRemainder);
+        } else if (chip16->drawFlag && (speed == 1 || ++skipped >= frameSkip)) {
+            emulationPublish(emu);
+            skipped = 0;
+            
+            // frameSkip = frames emulados que caben en una presentación
+            if (speed != 1 && frameTicks > 0) {
+                double presentTicks = SDL_AtomicGet(&emu->presentCost) * (double)frequency / 1e6;
+                frameSkip = (uint32_t)(presentTicks / frameTicks) + 1;
+            }
+        }
+        
+        frame++;
+        Uint64 now = SDL_GetPerformanceCounter();
+        if (speed != 1) {
+            frameTicks = frameTicks * 0.9 + (double)(now - lastFrameTime) * 0.1;
+        }
+        lastFrameTime = now;
+        
+        // Sin límite no hay plazos
+        if (speed == 0) {
+            continue;
+        }
+        
+        // Dormir hasta el plazo del siguiente frame. Si vamos con más de
+        // FRAME_MAX_LAG frames de retraso (el proceso estuvo detenido) se
+        // reinicia la planificación en lugar de recuperar el tiempo a ráfagas
+        Uint64 period = frequency / ((Uint64)TIMER_FREQ * speed);
+        Uint64 deadline = start + frame * frequency / ((Uint64)TIMER_FREQ * speed);
+        if (now < deadline) {
+            SDL_Delay((Uint32)((deadline - now) * 1000 / frequency));
+        } else if (now - deadline > FRAME_MAX_LAG * period) {
+            start = now;
+            frame = 0;
+        }
+    }
+    
+    return 0;
+}
 
 int main(int argc, char** argv) {
     // Verificar argumentos
     if (argc < 2) {
-        printf("Uso: %s <archivo-rom> [color-pixel-hex]\n", argv[0]);
+        printf("Uso: %s <archivo-rom> [color-pixel-hex] [instrucciones-por-segundo] [factor-turbo]\n", argv[0]);
+        printf("Mantener Tab para avanzar rápido (factor-turbo = 0: sin límite)\n");
+        printf("Mantener Retroceso para rebobinar (CHIP16_REWIND_MB: memoria del historial, 0 = desactivado)\n");
+        printf("CHIP16_RUN_AHEAD=n presenta la pantalla con n frames de adelanto (menos retraso de entrada)\n");
+        printf("CHIP16_RECORD=archivo graba la entrada para reproducirla con chip16-headless -i archivo\n");
         return EXIT_FAILURE;
     }
     
@@ -22,12 +341,18 @@ int main(int argc, char** argv) {
     char title[256];
     snprintf(title, sizeof(title), "CHIP-8 Emulator: %s", argv[1]);
     
-    // Inicializar componentes
-    Chip16 chip16;
-    Display display;
+    // Inicializar componentes. El núcleo y el triple buffer los comparten
+    // los dos hilos: mejor fuera de la pila
+    static Chip16 chip16;
+    static Frames frames;
+    static InputState input;
+    static Audio audio;
+    static Display display;
     
     // Inicializar emulador
     chip16Init(&chip16);
+    framesInit(&frames);
+    inputInit(&input);
     
     // Inicializar pantalla
     if (!displayInit(&display, title)) {
@@ -42,45 +367,143 @@ int main(int argc, char** argv) {
         return EXIT_FAILURE;
     }
     
-    // Variables para control de tiempo
-    Uint32 lastCycleTime = SDL_GetTicks();
-    Uint32 lastTimerUpdate = lastCycleTime;
-    int instructionsPerSecond = 700;  // Configuración predeterminada
+    // Velocidad de emulación (por defecto DEFAULT_SPEED instrucciones/s)
+    if (argc > 3) {
+        int speed = atoi(argv[3]);
+        if (speed <= 0) {
+            fprintf(stderr, "Error: Velocidad no válida: %s\n", argv[3]);
+            displayCleanup(&display);
+            SDL_Quit();
+            return EXIT_FAILURE;
+        }
+        chip16.config.clockSpeed = speed;
+    }
+    
+    // Con CHIP16_CYCLE_TIMERS en el entorno DT/ST cuentan instrucciones: la
+    // ejecución no depende del reloj del anfitrión
+    if (getenv("CHIP16_CYCLE_TIMERS") != NULL) {
+        chip16SetCycleTimers(&chip16, true);
+    }
+    
+    // Audio: CHIP16_AUDIO_SAMPLES fija el tamaño del buffer (menos muestras,
+    // menos latencia al empezar y terminar el pitido)
+    const char* samples = getenv("CHIP16_AUDIO_SAMPLES");
+    audioInit(&audio, samples != NULL ? atoi(samples) : AUDIO_DEFAULT_SAMPLES);
+    
+    Emulation emu = {0};
+    emu.chip16 = &chip16;
+    emu.frames = &frames;
+    emu.input = &input;
+    emu.audio = &audio;
+    SDL_AtomicSet(&emu.quit, 0);
+    SDL_AtomicSet(&emu.presentCost, 0);
+    emu.turboFactor = argc > 4 ? atoi(argv[4]) : TURBO_DEFAULT_FACTOR;
+    if (emu.turboFactor < 0) {
+        emu.turboFactor = TURBO_DEFAULT_FACTOR;
+    }
+    
+    // Adelanto al presentar: CHIP16_RUN_AHEAD frames (0 por defecto)
+    static uint8_t aheadState[CHIP16_STATE_MAX_SIZE];
+    const char* runAhead = getenv("CHIP16_RUN_AHEAD");
+    emu.runAhead = runAhead != NULL ? atoi(runAhead) : 0;
+    if (emu.runAhead < 0 || emu.runAhead > RUN_AHEAD_MAX_FRAMES) {
+        fprintf(stderr, "Aviso: adelanto no válido: %s (0-%d)\n", runAhead, RUN_AHEAD_MAX_FRAMES);
+        emu.runAhead = 0;
+    }
+    emu.aheadState = aheadState;
+    
+    // Grabar la entrada en el archivo CHIP16_RECORD para reproducirla con el
+    // ejecutor sin SDL (-i). Se siembra el generador con una semilla conocida
+    // y se desactiva el rebobinado, que rompería la grabación
+    static Replay replay;
+    const char* recordPath = getenv("CHIP16_RECORD");
+    if (recordPath != NULL) {
+        uint32_t seed = (uint32_t)time(NULL);
+        chip16Seed(&chip16, seed);
+        if (replayRecord(&replay, recordPath, &chip16, seed)) {
+            emu.replay = &replay;
+        }
+    }
+    
+    // Historial para rebobinar: CHIP16_REWIND_MB megas (REWIND_DEFAULT_MB por
+    // defecto, 0 lo desactiva). Toda la memoria se reserva aquí
+    static Rewind rewind;
+    static uint8_t rewindState[CHIP16_STATE_MAX_SIZE];
+    const char* rewindMb = getenv("CHIP16_REWIND_MB");
+    int rewindSize = rewindMb != NULL ? atoi(rewindMb) : REWIND_DEFAULT_MB;
+    if (rewindSize > 0 && emu.replay == NULL) {
+        if (rewindInit(&rewind, (size_t)rewindSize << 20, sizeof(rewindState))) {
+            emu.rewind = &rewind;
+            emu.rewindState = rewindState;
+        } else {
+            fprintf(stderr, "Aviso: no hay memoria para el historial de rebobinado\n");
+        }
+    }
+    
+    // Evento con el que el hilo de emulación avisa de cada frame publicado
+    emu.frameEvent = SDL_RegisterEvents(1);
+    
+    // La emulación corre en su propio hilo. Este se queda con los eventos y
+    // la presentación, que SDL exige hacer en el hilo principal
+    SDL_Thread* thread = SDL_CreateThread(emulationThread, "emulacion", &emu);
+    if (thread == NULL) {
+        fprintf(stderr, "Error al crear el hilo de emulación: %s\n", SDL_GetError());
+        audioCleanup(&audio);
+        displayCleanup(&display);
+        SDL_Quit();
+        return EXIT_FAILURE;
+    }
+    
     bool quit = false;
     SDL_Event event;
+    int presentCost = 0;  // Media móvil del coste de displayRender (µs)
     
-    
-    // Bucle principal de emulación
+    // Bucle de presentación
     while (!quit) {
         // Procesar entrada
-        quit = inputProcess(&event, &chip16, &display);
+        quit = inputProcess(&event, &display);
         
-        // Actualizar temporizadores a 60Hz 
-        Uint32 currentTime = SDL_GetTicks();
-        if (currentTime - lastTimerUpdate >= 16) {
-            chip16UpdateTimers(&chip16);
-            lastTimerUpdate = currentTime;
+        // Mostrar el frame completo más reciente (o repetir el último si la
+        // ventana de debug acaba de abrirse). El aviso se rearma antes de
+        // mirar: un frame publicado después vuelve a despertar el bucle
+        SDL_AtomicSet(&emu.frameWake, 0);
+        const Frame* frame = framesAcquire(&frames);
+        if (frame == NULL && display.redraw) {
+            frame = framesFront(&frames);
         }
-        
-        // Ejecutar instrucciones a velocidad constante
-        int cycleTarget = (currentTime - lastCycleTime) * instructionsPerSecond / 1000;
-        if (cycleTarget > 0) {
-            for (int i = 0; i < cycleTarget; i++) {
-                chip16Cycle(&chip16);
+        if (frame != NULL) {
+            // Medir lo que cuesta presentar (incluida la espera del vsync)
+            // para que el turbo ajuste cuántos frames se salta
+            Uint64 before = SDL_GetPerformanceCounter();
+            displayRender(&display, frame, argc > 2 ? argv[2] : NULL);
+            Uint64 cost = (SDL_GetPerformanceCounter() - before) * 1000000 / SDL_GetPerformanceFrequency();
+            presentCost = (presentCost * 7 + (int)cost) / 8;
+            SDL_AtomicSet(&emu.presentCost, presentCost);
+        } else if (!quit) {
+            // Sin frame nuevo se duerme hasta que llegue un evento de entrada
+            // o el aviso de publicación. Un núcleo detenido en FX0A no publica,
+            // así que el proceso queda parado hasta la siguiente tecla
+            if (emu.frameEvent != (Uint32)-1) {
+                SDL_WaitEvent(NULL);
+            } else {
+                SDL_WaitEventTimeout(NULL, 1);
             }
-            lastCycleTime = currentTime;
         }
-        
-        // Renderizar pantalla si es necesario
-        displayRender(&display, &chip16, argc > 2 ? argv[2] : NULL);
-        
-        // Pequeña pausa para evitar uso excesivo de CPU
-        SDL_Delay(1);
     }
     
+    // Detener la emulación antes de liberar nada
+    SDL_AtomicSet(&emu.quit, 1);
+    SDL_WaitThread(thread, NULL);
+    if (emu.replay != NULL) {
+        replayFinish(&replay, emu.emulated);
+    }
+    audioCleanup(&audio);
+    
     // Liberar recursos
+    rewindFree(&rewind);
+    inputCleanup(&input);
     displayCleanup(&display);
     SDL_Quit();
     
     return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -0,0 +1,208 @@
+#include <stdlib.h>
+#include <string.h>
+#include "replay.h"
+
+#define REPLAY_HEADER_SIZE 14   // Magic, versión, semilla, clockSpeed y flags
+#define REPLAY_EVENT_SIZE 14    // Frame, instrucción, tipo y tecla
+
+static void replayPutInt(uint8_t* out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint64_t replayGetInt(const uint8_t* in, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value |= (uint64_t)in[i] << (8 * i);
+    }
+    return value;
+}
+
+bool replayRecord(Replay* replay, const char* filename, const Chip16* chip16, uint32_t seed) {
+    memset(replay, 0, sizeof(*replay));
+    replay->seed = seed;
+    replay->clockSpeed = (uint32_t)chip16->config.clockSpeed;
+    replay->cycleTimers = chip16->config.cycleTimers;
+    
+    replay->file = fopen(filename, "wb");
+    if (replay->file == NULL) {
+        fprintf(stderr, "Error: No se pudo crear el archivo %s\n", filename);
+        return false;
+    }
+    
+    uint8_t header[REPLAY_HEADER_SIZE];
+    memcpy(header, REPLAY_MAGIC, 4);
+    header[4] = REPLAY_VERSION;
+    replayPutInt(header + 5, replay->seed, 4);
+    replayPutInt(header + 9, replay->clockSpeed, 4);
+    header[13] = replay->cycleTimers ? 1 : 0;
+    if (fwrite(header, 1, sizeof(header), replay->file) != sizeof(header)) {
+        fprintf(stderr, "Error: No se pudo escribir en %s\n", filename);
+        fclose(replay->file);
+        replay->file = NULL;
+        return false;
+    }
+    return true;
+}
+
+void replayWrite(Replay* replay, uint64_t frame, uint32_t at, uint8_t type, uint8_t key) {
+    if (replay->file == NULL) {
+        return;
+    }
+    
+    uint8_t record[REPLAY_EVENT_SIZE];
+    replayPutInt(record, frame, 8);
+    replayPutInt(record + 8, at, 4);
+    record[12] = type;
+    record[13] = key;
+    
+    // Si falla la escritura se deja de grabar: lo anotado hasta aquí sigue
+    // siendo una grabación válida
+    if (fwrite(record, 1, sizeof(record), replay->file) != sizeof(record)) {
+        fprintf(stderr, "Aviso: error al escribir la grabación, se detiene\n");
+        fclose(replay->file);
+        replay->file = NULL;
+    }
+}
+
+void replayFinish(Replay* replay, uint64_t frames) {
+    replayWrite(replay, frames, 0, REPLAY_END, 0);
+    if (replay->file != NULL) {
+        fclose(replay->file);
+        replay->file = NULL;
+    }
+}
+
+bool replayLoad(Replay* replay, const char* filename) {
+    memset(replay, 0, sizeof(*replay));
+    
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Error: No se pudo abrir el archivo %s\n", filename);
+        return false;
+    }
+    
+    uint8_t header[REPLAY_HEADER_SIZE];
+    if (fread(header, 1, sizeof(header), file) != sizeof(header) ||
+        memcmp(header, REPLAY_MAGIC, 4) != 0 || header[4] != REPLAY_VERSION) {
+        fprintf(stderr, "Error: %s no es una grabación válida\n", filename);
+        fclose(file);
+        return false;
+    }
+    replay->seed = (uint32_t)replayGetInt(header + 5, 4);
+    replay->clockSpeed = (uint32_t)replayGetInt(header + 9, 4);
+    replay->cycleTimers = (header[13] & 1) != 0;
+    
+    // Los eventos se cargan enteros para no leer el archivo durante la medida
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fseek(file, REPLAY_HEADER_SIZE, SEEK_SET);
+    size_t capacity = fileSize > REPLAY_HEADER_SIZE ? (size_t)(fileSize - REPLAY_HEADER_SIZE) / REPLAY_EVENT_SIZE : 0;
+    replay->events = malloc((capacity > 0 ? capacity : 1) * sizeof(ReplayEvent));
+    if (replay->events == NULL) {
+        fprintf(stderr, "Error: No hay memoria para la grabación %s\n", filename);
+        fclose(file);
+        return false;
+    }
+    
+    uint8_t record[REPLAY_EVENT_SIZE];
+    while (replay->count < capacity && fread(record, 1, sizeof(record), file) == sizeof(record)) {
+        ReplayEvent* event = &replay->events[replay->count];
+        event->frame = replayGetInt(record, 8);
+        event->at = (uint32_t)replayGetInt(record + 8, 4);
+        event->type = record[12];
+        event->key = record[13];
+        
+        // Los eventos deben venir en orden y las teclas existir
+        if ((replay->count > 0 && event->frame < event[-1].frame) ||
+            (event->type != REPLAY_END && event->type > REPLAY_TOGGLE_EFFECT) ||
+            event->key >= KEY_COUNT) {
+            fprintf(stderr, "Error: %s no es una grabación válida\n", filename);
+            replayFree(replay);
+            fclose(file);
+            return false;
+        }
+        
+        replay->count++;
+        if (event->type == REPLAY_END) {
+            break;
+        }
+    }
+    
+    fclose(file);
+    return true;
+}
+
+void replayFree(Replay* replay) {
+    free(replay->events);
+    replay->events = NULL;
+    replay->count = 0;
+    replay->next = 0;
+}
+
+uint64_t replayLength(const Replay* replay) {
+    if (replay->count == 0) {
+        return 0;
+    }
+    
+    // Sin REPLAY_END (el frontend no terminó bien) se llega hasta el último evento
+    const ReplayEvent* last = &replay->events[replay->count - 1];
+    return last->type == REPLAY_END ? last->frame : last->frame + 1;
+}
+
+bool replayNext(Replay* replay, uint64_t frame, ReplayEvent* event) {
+    if (replay->next == replay->count) {
+        return false;
+    }
+    
+    const ReplayEvent* next = &replay->events[replay->next];
+    if (next->frame != frame || next->type == REPLAY_END) {
+        return false;
+    }
+    
+    *event = *next;
+    replay->next++;
+    return true;
+}
+
+uint32_t replaySpaceEvent(uint32_t at, uint8_t type, uint32_t budget, uint32_t* next) {
+    // Una pulsación deja sitio en el frame para una instrucción antes de
+    // lo que venga detrás
+    uint32_t last = (type == REPLAY_KEY_DOWN && budget > 0) ? budget - 1 : budget;
+    if (at > last) {
+        at = last;
+    }
+    if (at < *next) {
+        at = *next;
+    }
+    
+    *next = (type == REPLAY_KEY_DOWN && at < budget) ? at + 1 : at;
+    return at;
+}
+
+void replayApply(const Replay* replay, Chip16* chip16, const ReplayEvent* event) {
+    switch (event->type) {
+        case REPLAY_KEY_DOWN:
+            chip16SetKey(chip16, event->key, 1);
+            break;
+            
+        case REPLAY_KEY_UP:
+            chip16SetKey(chip16, event->key, 0);
+            break;
+            
+        case REPLAY_RESET: {
+            // Como inputApply, pero con la semilla de la grabación en lugar
+            // de la hora
+            Config config = chip16->config;
+            chip16Init(chip16);
+            chip16->config = config;
+            chip16Seed(chip16, replay->seed);
+            break;
+        }
+            
+        case REPLAY_TOGGLE_EFFECT:
+            chip16SetEffect(chip16, chip16->currentEffect == EFFECT_COLOR_CYCLE ? EFFECT_NONE : EFFECT_COLOR_CYCLE);
+            break;
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdio.h>
+#include "chip16.h"
+
+// Grabación y reproducción de la entrada
+//
+// El frontend SDL (con CHIP16_RECORD=archivo) anota cada evento de entrada
+// que llega al núcleo con el frame emulado y la instrucción del frame en la
+// que se aplicó, junto con la semilla del generador pseudoaleatorio y la
+// configuración que cambia la ejecución. El ejecutor sin SDL (-i archivo)
+// repite los mismos presupuestos de instrucciones por frame y aplica cada
+// evento en la misma posición: la partida se reproduce instrucción a
+// instrucción sin depender del reloj, así que sirve como carga fija para
+// medir el rendimiento.
+//
+// Formato (little-endian): "C16R", versión (1 byte), semilla (4),
+// clockSpeed (4) y flags (1, bit 0 = cycleTimers). Después, un registro de
+// 14 bytes por evento: frame (8), instrucción del frame (4), tipo (1) y
+// tecla (1). La grabación termina con un REPLAY_END en el frame siguiente al
+// último emulado
+
+#define REPLAY_MAGIC "C16R"
+#define REPLAY_VERSION 1
+
+// Los cuatro primeros tienen los mismos valores que InputEventType
+typedef enum {
+    REPLAY_KEY_DOWN,        // Tecla key pulsada
+    REPLAY_KEY_UP,          // Tecla key liberada
+    REPLAY_RESET,           // Reinicio del núcleo
+    REPLAY_TOGGLE_EFFECT,   // Activar o desactivar el ciclo de color
+    REPLAY_END = 0xFF       // Fin de la grabación
+} ReplayEventType;
+
+typedef struct {
+    uint64_t frame;         // Frame emulado (desde 0)
+    uint32_t at;            // Instrucción del frame en la que se aplica
+    uint8_t type;           // ReplayEventType
+    uint8_t key;            // Tecla (eventos de tecla)
+} ReplayEvent;
+
+typedef struct {
+    uint32_t seed;          // Semilla del generador al empezar y tras cada reinicio
+    uint32_t clockSpeed;    // Instrucciones por segundo
+    bool cycleTimers;       // DT/ST por instrucciones
+    FILE* file;             // Grabación en curso (NULL = no se graba)
+    ReplayEvent* events;    // Eventos cargados con replayLoad
+    size_t count;
+    size_t next;            // Siguiente evento por reproducir
+} Replay;
+
+// Empezar a grabar en filename con la configuración actual del núcleo. El
+// llamador debe sembrar el núcleo con seed
+bool replayRecord(Replay* replay, const char* filename, const Chip16* chip16, uint32_t seed);
+
+// Anotar un evento aplicado en la instrucción at del frame
+void replayWrite(Replay* replay, uint64_t frame, uint32_t at, uint8_t type, uint8_t key);
+
+// Terminar la grabación: frames es el número de frames emulados
+void replayFinish(Replay* replay, uint64_t frames);
+
+// Cargar una grabación completa en memoria
+bool replayLoad(Replay* replay, const char* filename);
+void replayFree(Replay* replay);
+
+// Frames que dura la grabación cargada
+uint64_t replayLength(const Replay* replay);
+
+// Sacar el siguiente evento si pertenece al frame indicado
+bool replayNext(Replay* replay, uint64_t frame, ReplayEvent* event);
+
+// Instrucción del frame en la que se aplica un evento que llegó en at, para
+// un frame de budget instrucciones. Los eventos no retroceden y, tras una
+// pulsación, el siguiente espera al menos una instrucción: una pulsación y su
+// liberación dentro del mismo lote no se anulan, y un núcleo parado en FX0A
+// llega a ver la tecla. next lleva la posición mínima del siguiente evento
+// (0 al empezar cada frame). El frontend graba la posición ya corregida y la
+// reproducción vuelve a aplicar la regla, que no cambia esas posiciones
+uint32_t replaySpaceEvent(uint32_t at, uint8_t type, uint32_t budget, uint32_t* next);
+
+// Aplicar un evento al núcleo igual que lo hizo el frontend
+void replayApply(const Replay* replay, Chip16* chip16, const ReplayEvent* event);
+
+#endif // REPLAY_H
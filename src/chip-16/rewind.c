@@ -0,0 +1,230 @@
+#include <stdlib.h>
+#include <string.h>
+#include "rewind.h"
+
+#define REWIND_RUN_MAX 128  // Longitud máxima de una racha
+
+// Frame de número de secuencia seq
+static RewindEntry* rewindEntry(Rewind* rewind, uint64_t seq) {
+    return &rewind->entries[seq % REWIND_MAX_FRAMES];
+}
+
+// Comprimir src ^ ref (src si ref es NULL) por rachas de ceros, con el mismo
+// formato que los estados guardados: 0x00-0x7F = control + 1 literales,
+// 0x80-0xFF = (control & 0x7F) + 1 ceros. out necesita len + len / 128 + 1 bytes
+static size_t rewindEncode(uint8_t* out, const uint8_t* src, const uint8_t* ref, size_t len) {
+    size_t pos = 0;
+    size_t i = 0;
+    
+    while (i < len) {
+        size_t n = 0;
+        if ((src[i] ^ (ref ? ref[i] : 0)) == 0) {
+            // De 8 en 8 mientras se pueda: entre frames casi nada cambia
+            uint64_t a, b = 0;
+            while (i + n + 8 <= len && n + 8 <= REWIND_RUN_MAX) {
+                memcpy(&a, src + i + n, 8);
+                if (ref) {
+                    memcpy(&b, ref + i + n, 8);
+                }
+                if (a != b) {
+                    break;
+                }
+                n += 8;
+            }
+            while (i + n < len && n < REWIND_RUN_MAX &&
+                   (src[i + n] ^ (ref ? ref[i + n] : 0)) == 0) {
+                n++;
+            }
+            out[pos++] = (uint8_t)(0x80 | (n - 1));
+        } else {
+            // Literales hasta dos ceros seguidos
+            size_t start = pos++;
+            while (i + n < len && n < REWIND_RUN_MAX) {
+                uint8_t value = src[i + n] ^ (ref ? ref[i + n] : 0);
+                if (value == 0 && (i + n + 1 == len ||
+                                   (src[i + n + 1] ^ (ref ? ref[i + n + 1] : 0)) == 0)) {
+                    break;
+                }
+                out[pos++] = value;
+                n++;
+            }
+            out[start] = (uint8_t)(n - 1);
+        }
+        i += n;
+    }
+    
+    return pos;
+}
+
+// Inversa de rewindEncode: out = datos ^ ref (o los datos si ref es NULL)
+static void rewindDecode(uint8_t* out, const uint8_t* src, const uint8_t* ref, size_t len) {
+    size_t i = 0;
+    
+    while (i < len) {
+        uint8_t control = *src++;
+        size_t n = (size_t)(control & 0x7F) + 1;
+        if (control & 0x80) {
+            if (ref) {
+                memcpy(out + i, ref + i, n);
+            } else {
+                memset(out + i, 0, n);
+            }
+        } else {
+            for (size_t k = 0; k < n; k++) {
+                out[i + k] = src[k] ^ (ref ? ref[i + k] : 0);
+            }
+            src += n;
+        }
+        i += n;
+    }
+}
+
+// Descartar el frame más antiguo y los deltas que se quedan sin fotograma clave
+static void rewindDropOldest(Rewind* rewind) {
+    do {
+        rewind->firstSeq++;
+        rewind->count--;
+    } while (rewind->count > 0 && rewindEntry(rewind, rewind->firstSeq)->keySeq < rewind->firstSeq);
+    
+    if (rewind->count == 0) {
+        rewind->head = 0;
+    }
+    if (rewind->keySeq < rewind->firstSeq) {
+        rewind->keyValid = false;
+    }
+}
+
+// Liberar size bytes contiguos en head descartando los frames más antiguos
+static void rewindReserve(Rewind* rewind, size_t size) {
+    if (rewind->count == REWIND_MAX_FRAMES) {
+        rewindDropOldest(rewind);
+    }
+    
+    while (rewind->count > 0) {
+        size_t tail = rewindEntry(rewind, rewind->firstSeq)->offset;
+        if (tail < rewind->head) {
+            // Ocupado [tail, head): libres el final de pool y [0, tail)
+            if (rewind->head + size <= rewind->capacity) {
+                return;
+            }
+            if (size <= tail) {
+                rewind->head = 0;
+                return;
+            }
+        } else if (rewind->head + size <= tail) {
+            // Ocupado [tail, capacity) y [0, head): libre [head, tail)
+            return;
+        }
+        rewindDropOldest(rewind);
+    }
+    rewind->head = 0;
+}
+
+bool rewindInit(Rewind* rewind, size_t capacity, size_t maxStateSize) {
+    memset(rewind, 0, sizeof(*rewind));
+    rewind->capacity = capacity;
+    rewind->maxStateSize = maxStateSize;
+    rewind->pool = malloc(capacity);
+    rewind->entries = malloc(REWIND_MAX_FRAMES * sizeof(RewindEntry));
+    rewind->keyState = malloc(maxStateSize);
+    rewind->scratch = malloc(maxStateSize + maxStateSize / REWIND_RUN_MAX + 1);
+    
+    if (!rewind->pool || !rewind->entries || !rewind->keyState || !rewind->scratch) {
+        rewindFree(rewind);
+        return false;
+    }
+    return true;
+}
+
+void rewindFree(Rewind* rewind) {
+    free(rewind->pool);
+    free(rewind->entries);
+    free(rewind->keyState);
+    free(rewind->scratch);
+    memset(rewind, 0, sizeof(*rewind));
+}
+
+void rewindClear(Rewind* rewind) {
+    rewind->head = 0;
+    rewind->firstSeq = 0;
+    rewind->count = 0;
+    rewind->keyValid = false;
+}
+
+void rewindPush(Rewind* rewind, const uint8_t* state, size_t size) {
+    if (size > rewind->maxStateSize) {
+        return;
+    }
+    
+    bool key = !rewind->keyValid || size != rewind->keySize ||
+               rewind->sinceKey + 1 >= REWIND_KEYFRAME_INTERVAL;
+    size_t encoded;
+    
+    for (;;) {
+        encoded = rewindEncode(rewind->scratch, state, key ? NULL : rewind->keyState, size);
+        if (encoded > rewind->capacity) {
+            return;  // No cabe ni con el historial vacío
+        }
+        rewindReserve(rewind, encoded);
+        
+        // Con un historial muy pequeño la reserva puede haber descartado el
+        // fotograma clave del delta: se guarda completo
+        if (key || rewind->keyValid) {
+            break;
+        }
+        key = true;
+    }
+    
+    uint64_t seq = rewind->firstSeq + rewind->count;
+    RewindEntry* entry = rewindEntry(rewind, seq);
+    entry->offset = rewind->head;
+    entry->size = (uint32_t)encoded;
+    entry->stateSize = (uint32_t)size;
+    memcpy(rewind->pool + rewind->head, rewind->scratch, encoded);
+    rewind->head += encoded;
+    rewind->count++;
+    
+    if (key) {
+        memcpy(rewind->keyState, state, size);
+        rewind->keySize = size;
+        rewind->keySeq = seq;
+        rewind->keyValid = true;
+        rewind->sinceKey = 0;
+    } else {
+        rewind->sinceKey++;
+    }
+    entry->keySeq = rewind->keySeq;
+}
+
+size_t rewindStep(Rewind* rewind, uint8_t* state) {
+    if (rewind->count < 2) {
+        return 0;
+    }
+    
+    // Descartar el frame actual; su espacio queda libre para el siguiente
+    uint64_t last = rewind->firstSeq + rewind->count - 1;
+    rewind->head = rewindEntry(rewind, last)->offset;
+    rewind->count--;
+    if (rewind->keySeq == last) {
+        rewind->keyValid = false;
+    }
+    
+    // Recuperar el fotograma clave del nuevo frame más reciente si hace falta
+    uint64_t seq = last - 1;
+    const RewindEntry* entry = rewindEntry(rewind, seq);
+    if (!rewind->keyValid || rewind->keySeq != entry->keySeq) {
+        const RewindEntry* key = rewindEntry(rewind, entry->keySeq);
+        rewindDecode(rewind->keyState, rewind->pool + key->offset, NULL, key->stateSize);
+        rewind->keySize = key->stateSize;
+        rewind->keySeq = entry->keySeq;
+        rewind->keyValid = true;
+    }
+    rewind->sinceKey = (uint32_t)(seq - rewind->keySeq);
+    
+    if (entry->keySeq == seq) {
+        memcpy(state, rewind->keyState, entry->stateSize);
+    } else {
+        rewindDecode(state, rewind->pool + entry->offset, rewind->keyState, entry->stateSize);
+    }
+    return entry->stateSize;
+}
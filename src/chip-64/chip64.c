@@ -1,3 +1,4 @@
+#define _POSIX_C_SOURCE 199309L // clock_gettime para medir los efectos
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,43 +10,25 @@
 // ============================================================================
 
 /**
- * @brief Obtiene la máscara apropiada según el modo de emulación
+ * @brief Multiplicación 64×64 → 128 bits sin __uint128_t
  *
- * Esto permite que las operaciones respeten el tamaño de bits activo:
- * - MODE_8BIT:  0xFF (255)
- * - MODE_16BIT: 0xFFFF (65535)
- * - MODE_64BIT: 0xFFFFFFFFFFFFFFFF (2^64 - 1)
+ * Devuelve los 64 bits bajos y deja los altos en *hi. La usan los núcleos de
+ * 8 y 16 bits, que no necesitan enteros de 128 bits en el bucle caliente.
  */
-static inline uint64_t getMask(Chip64 *chip64)
+static inline uint64_t mulWide(uint64_t a, uint64_t b, uint64_t *hi)
 {
-    switch (chip64->mode)
-    {
-    case MODE_8BIT:
-        return 0xFF;
-    case MODE_16BIT:
-        return 0xFFFF;
-    case MODE_64BIT:
-        return 0xFFFFFFFFFFFFFFFF;
-    default:
-        return 0xFFFFFFFFFFFFFFFF;
-    }
-}
-
-/**
- * @brief Enmascara un valor al tamaño del modo actual
- */
-static inline uint64_t maskValue(Chip64 *chip64, uint64_t value)
-{
-    return value & getMask(chip64);
+    uint64_t aLo = a & 0xFFFFFFFF, aHi = a >> 32;
+    uint64_t bLo = b & 0xFFFFFFFF, bHi = b >> 32;
+    uint64_t ll = aLo * bLo;
+    uint64_t lh = aLo * bHi;
+    uint64_t hl = aHi * bLo;
+    uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+
+    *hi = aHi * bHi + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    return (mid << 32) | (ll & 0xFFFFFFFF);
 }
 
-/**
- * @brief Obtiene el valor máximo representable según el modo
- */
-static inline uint64_t getMaxValue(Chip64 *chip64)
-{
-    return getMask(chip64);
-}
+static void chip64SelectCore(Chip64 *chip64);
 
 // ============================================================================
 // FUNCIONES PÚBLICAS - DIMENSIONES DEL DISPLAY
@@ -85,10 +68,12 @@ void chip64Init(Chip64 *chip64)
     // Inicializar registros y memoria
     memset(chip64->memory, 0, MEMORY_SIZE);
     memset(chip64->V, 0, REGISTER_COUNT * sizeof(uint64_t));
-    memset(chip64->gfx, 0, DISPLAY_WIDTH * DISPLAY_HEIGHT);
+    memset(chip64->gfxRows, 0, sizeof(chip64->gfxRows));
     memset(chip64->gfx2Buffer, 0, DISPLAY_WIDTH * DISPLAY_HEIGHT);
     memset(chip64->key, 0, KEY_COUNT);
     memset(chip64->stack, 0, STACK_SIZE * sizeof(uint16_t));
+    memset(chip64->icache, 0, sizeof(chip64->icache));
+    memset(&chip64->cacheStats, 0, sizeof(chip64->cacheStats));
 
     chip64->opcode = 0;
     chip64->I = 0;
@@ -97,9 +82,14 @@ void chip64Init(Chip64 *chip64)
     chip64->delayTimer = 0;
     chip64->soundTimer = 0;
     chip64->drawFlag = false;
-    chip64->currentEffect = EFFECT_NONE;
-    chip64->effectTimer = 0;
+    chip64->dirtyRows = UINT64_MAX; // El primer render dibuja la pantalla completa
+    chip64->waitingKey = false;
+    chip64->runEvent = CHIP64_RUN_BUDGET;
+    chip64->runCycles = 0;
+    memset(&chip64->effects, 0, sizeof(chip64->effects));
     chip64->colorIndex = 0;
+    chip64->cycleFn = NULL;
+    chip64SelectCore(chip64);
 
     // Cargar fuente en memoria
     memcpy(chip64->memory, chip64_fontset, FONTSET_SIZE);
@@ -107,7 +97,7 @@ void chip64Init(Chip64 *chip64)
     memcpy(chip64->palette, DEFAULT_PALETTE, sizeof(DEFAULT_PALETTE));
 
     // Inicializar semilla para números aleatorios
-    srand(time(NULL));
+    chip64Seed(chip64, (uint32_t)time(NULL));
 
     // --- Debug ---
     if (chip64->config.debugLevel >= DEBUG_OPCODES)
@@ -131,6 +121,71 @@ void chip64Init(Chip64 *chip64)
     }
 }
 
+bool chip64LoadROM(Chip64 *chip64, const char *filename)
+{
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Error: No se pudo abrir el archivo %s\n", filename);
+        return false;
+    }
+
+    // Determinar tamaño del archivo
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    // Verificar que la ROM cabe en memoria (64KB - 512 bytes reservados)
+    if (fileSize < 0 || fileSize > MEMORY_SIZE - ROM_LOAD_ADDRESS)
+    {
+        fprintf(stderr, "Error: La ROM es demasiado grande para la memoria\n");
+        fclose(file);
+        return false;
+    }
+
+    // Leer ROM en memoria
+    size_t bytesRead = fread(&chip64->memory[ROM_LOAD_ADDRESS], 1, (size_t)fileSize, file);
+    fclose(file);
+
+    if (bytesRead != (size_t)fileSize)
+    {
+        fprintf(stderr, "Error: No se pudo leer el archivo completo\n");
+        return false;
+    }
+
+    // La memoria ha cambiado: descartar instrucciones predecodificadas
+    chip64FlushCache(chip64);
+
+    return true;
+}
+
+void chip64FlushCache(Chip64 *chip64)
+{
+    memset(chip64->icache, 0, sizeof(chip64->icache));
+}
+
+// Sembrar el generador pseudoaleatorio (xorshift32, el estado nunca puede ser 0)
+void chip64Seed(Chip64 *chip64, uint32_t seed)
+{
+    chip64->rngState = seed * 2654435761u ^ 0x9E3779B9u;
+    if (chip64->rngState == 0)
+    {
+        chip64->rngState = 1;
+    }
+}
+
+// Siguiente número del generador. Es parte del estado del núcleo (a
+// diferencia de rand()), así que un estado restaurado saca los mismos números
+static uint32_t chip64Random(Chip64 *chip64)
+{
+    uint32_t x = chip64->rngState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    chip64->rngState = x;
+    return x;
+}
+
 void chip64UpdateTimers(Chip64 *chip64)
 {
     if (chip64->delayTimer > 0)
@@ -140,8 +195,6 @@ void chip64UpdateTimers(Chip64 *chip64)
     if (chip64->soundTimer > 0)
     {
         chip64->soundTimer--;
-        // Aquí se podría agregar código para manejar el sonido
-        printf("BEEP!\n");
     }
 }
 
@@ -150,6 +203,12 @@ void chip64SetKey(Chip64 *chip64, uint8_t key, uint8_t value)
     if (key < KEY_COUNT)
     {
         chip64->key[key] = value;
+
+        // Una pulsación despierta a un programa detenido en FX0A
+        if (value != 0)
+        {
+            chip64->waitingKey = false;
+        }
     }
 }
 
@@ -169,6 +228,9 @@ void chip64SetMode(Chip64 *chip64, EmuMode mode)
         chip64->config.colorMode = false;   // Monocromo en modos compatibles
     }
 
+    chip64->dirtyRows = UINT64_MAX; // Puede cambiar la zona visible
+    chip64SelectCore(chip64);
+
     if (chip64->config.debugLevel >= DEBUG_OPCODES)
     {
         printf("⚙️  Modo cambiado: %s (Display: %dx%d)\n",
@@ -178,6 +240,20 @@ void chip64SetMode(Chip64 *chip64, EmuMode mode)
     }
 }
 
+void chip64SetHighResMode(Chip64 *chip64, bool enable)
+{
+    chip64->config.highResMode = enable;
+    chip64->dirtyRows = UINT64_MAX; // Cambia la zona visible
+    chip64SelectCore(chip64);
+
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("🖥️  Alta resolución: %s (Display: %dx%d)\n",
+               enable ? "activada" : "desactivada",
+               chip64GetDisplayWidth(chip64), chip64GetDisplayHeight(chip64));
+    }
+}
+
 void chip64SetColorMode(Chip64 *chip64, bool enable)
 {
     chip64->config.colorMode = enable;
@@ -198,951 +274,1251 @@ void chip64SetPalette(Chip64 *chip64, const Color16 *newPalette)
     }
 }
 
+const char *chip64EffectName(GraphicsEffects effect)
+{
+    switch (effect)
+    {
+    case EFFECT_NONE:
+        return "Ninguno";
+    case EFFECT_COLOR_CYCLE:
+        return "Ciclo de colores";
+    case EFFECT_FADE:
+        return "Fundido";
+    case EFFECT_SHAKE:
+        return "Temblor";
+    case EFFECT_SCANLINES:
+        return "Scanlines";
+    default:
+        return "Desconocido";
+    }
+}
+
 void chip64SetEffect(Chip64 *chip64, GraphicsEffects effect)
 {
-    chip64->currentEffect = effect;
-    chip64->effectTimer = 0; // Reiniciar timer al cambiar efecto
+    // Reiniciar el pipeline y sus contadores
+    memset(&chip64->effects, 0, sizeof(chip64->effects));
+    if (effect != EFFECT_NONE)
+    {
+        chip64AddEffect(chip64, effect);
+    }
 
     if (chip64->config.debugLevel >= DEBUG_OPCODES)
     {
-        printf("Efecto gráfico: ");
-        switch (effect)
-        {
-        case EFFECT_NONE:
-            printf("Ninguno\n");
-            break;
-        case EFFECT_COLOR_CYCLE:
-            printf("Ciclo de colores\n");
-            break;
-        // case EFFECT_FADE:
-        //     printf("Fade (no implementado)\n");
-        //     break;
-        // case EFFECT_SHAKE:
-        //     printf("Screen shake (no implementado)\n");
-        //     break;
-        default:
-            printf("Desconocido\n");
-            break;
-        }
+        printf("Efecto gráfico: %s\n", chip64EffectName(effect));
     }
 }
 
-void chip64ProcessEffects(Chip64 *chip64)
+bool chip64AddEffect(Chip64 *chip64, GraphicsEffects effect)
 {
-    memcpy(chip64->gfx2Buffer, chip64->gfx, (DISPLAY_HEIGHT * DISPLAY_WIDTH));
+    Chip64EffectPipeline *fx = &chip64->effects;
 
-    // Si hay efecto activo, actualizar su estado
-    switch (chip64->currentEffect)
+    if (effect == EFFECT_NONE || fx->count >= MAX_EFFECT_STAGES)
     {
-    case EFFECT_NONE:
-        // Sin procesamiento adicional
-        break;
+        return false;
+    }
+    for (int i = 0; i < fx->count; i++)
+    {
+        if (fx->stages[i].effect == effect)
+        {
+            return false;
+        }
+    }
 
-    case EFFECT_COLOR_CYCLE:
-        // Actualizar timer del ciclo de colores
-        chip64->effectTimer++;
+    memset(&fx->stages[fx->count], 0, sizeof(fx->stages[0]));
+    fx->stages[fx->count].effect = effect;
+    fx->count++;
 
-        if (chip64->effectTimer >= COLOR_CYCLE_FRAMES)
-        {
-            chip64->effectTimer = 0;
-            chip64->colorIndex = (chip64->colorIndex + 1) % COLOR_PALETTE_SIZE;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("Efecto gráfico añadido: %s (%d etapas)\n", chip64EffectName(effect), fx->count);
+    }
+    return true;
+}
 
-            if (chip64->config.debugLevel >= DEBUG_VERBOSE)
+void chip64GetFramebuffer(const Chip64 *chip64, uint8_t *out)
+{
+    for (int y = 0; y < DISPLAY_HEIGHT; y++)
+    {
+        for (int word = 0; word < DISPLAY_WIDTH / 64; word++)
+        {
+            uint64_t bits = chip64->gfxRows[y][word];
+            uint8_t *dst = &out[y * DISPLAY_WIDTH + word * 64];
+            for (int x = 0; x < 64; x++)
             {
-                printf("🎨 Ciclo de color: índice %d (Color: 0x%08X)\n",
-                       chip64->colorIndex, COLOR_PALETTE[chip64->colorIndex]);
+                dst[x] = (bits >> (63 - x)) & 1;
             }
         }
-
-        // El renderizador debe usar colorIndex para elegir el color
-        // de la paleta COLOR_PALETTE_RGBA al dibujar píxeles activos
-        break;
-
-        // case EFFECT_FADE:
-        //     // TODO: Implementar fade in/out
-        //     // Podría modificar la intensidad de los píxeles en gfx2Buffer
-        //     break;
-
-        // case EFFECT_SHAKE:
-        //     // TODO: Implementar screen shake
-        //     // Podría desplazar aleatoriamente los píxeles en gfx2Buffer
-        //     break;
-
-    default:
-        break;
     }
 }
 
-void chip64GetStatus(Chip64 *chip64, char *buffer, size_t bufferSize)
+// ============================================================================
+// PIPELINE DE EFECTOS
+// ============================================================================
+
+// Parámetros de composición de un frame. Las etapas solo modifican estos
+// valores por fila; la pasada fusionada los aplica todos de una vez
+typedef struct {
+    int16_t srcY[DISPLAY_HEIGHT];   // Fila de origen de cada fila de salida (fuera de rango = negra)
+    uint8_t level[DISPLAY_HEIGHT];  // Intensidad de cada fila de salida (0-255)
+    int shiftX;                     // Desplazamiento horizontal de toda la imagen
+    bool pixels;                    // Alguna etapa modifica píxeles
+} Chip64EffectFrame;
+
+// Secuencia del temblor: pares (dx, dy) en unidades de SHAKE_AMPLITUDE / 2
+static const int8_t shakeOffsets[SHAKE_FRAMES][2] = {
+    {2, 0}, {-2, 1}, {1, -2}, {-1, 2}, {2, -1}, {-2, -2}, {0, 2}, {1, -1}
+};
+
+static uint64_t chip64NowNs(void)
 {
-    snprintf(buffer, bufferSize,
-             "PC=0x%04X I=0x%016llX SP=%d Mode=%s Res=%dx%d",
-             chip64->PC,
-             (unsigned long long)chip64->I,
-             chip64->SP,
-             chip64->mode == MODE_8BIT ? "8bit" : chip64->mode == MODE_16BIT ? "16bit"
-                                                                             : "64bit",
-             chip64GetDisplayWidth(chip64),
-             chip64GetDisplayHeight(chip64));
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
 }
 
-// Ejecutar un ciclo de emulación
-void chip64Cycle(Chip64 *chip64)
+// Periodo en frames de una etapa: su timer va de 0 a periodo - 1 (las etapas
+// sin animación lo dejan en 0)
+static uint16_t chip64EffectPeriod(GraphicsEffects effect)
 {
-    // Extraer opcode (2 bytes)
-    chip64->opcode = (chip64->memory[chip64->PC] << 8) |
-                     chip64->memory[chip64->PC + 1];
-
-    // Incrementar PC antes de ejecutar
-    chip64->PC += 2;
-
-    // Variables para decodificación del opcode
-    uint8_t x = (chip64->opcode & 0x0F00) >> 8;
-    uint8_t y = (chip64->opcode & 0x00F0) >> 4;
-    uint8_t n = chip64->opcode & 0x000F;
-    uint8_t kk = chip64->opcode & 0x00FF;
-    uint16_t nnn = chip64->opcode & 0x0FFF;
-
-    // Variables para el uso en instrucciones
-    // --- Valores y operandos generales ---
-    uint64_t value; // Valor temporal genérico para cálculos y operaciones
-    uint64_t src;   // Dirección fuente en operaciones de memoria (MEMCPY, MEMSRCH)
-    uint64_t dst;   // Dirección destino en operaciones de memoria (MEMCPY)
-    uint64_t count; // Contador para loops (copias, búsquedas, bits activos)
-
-    // --- Coordenadas y dimensiones para gráficos ---
-    uint64_t xPos;   // Posición X en display para operaciones de dibujo
-    uint64_t yPos;   // Posición Y en display para operaciones de dibujo
-    uint64_t height; // Altura de sprites (DRW) o líneas verticales (VLINE)
-    uint64_t width;  // Ancho de sprites (reservado para futuro uso)
-
-    // --- Datos de gráficos y patrones ---
-    uint64_t memValue;   // Valor leído de memoria (búsquedas, load/store)
-    uint64_t spriteData; // Datos de sprite de 16/32 bits (DRAW16, líneas)
-    uint64_t pattern;    // Patrón de bits para dibujar líneas (HLINE, VLINE)
-    uint64_t length;     // Longitud de líneas horizontales (HLINE)
-
-    // --- Operaciones aritméticas de alta precisión ---
-    __uint128_t result;  // Resultado de sumas/restas para detectar carry/borrow
-    __uint128_t product; // Producto de multiplicaciones para detectar overflow
-
-    // --- Operaciones de bits y control ---
-    uint8_t shift;       // Cantidad de bits para rotaciones (ROR, ROL) y shifts
-    uint8_t range;       // Límite superior para números aleatorios en rango (RNDR)
-    uint8_t spriteDataB; // Datos de sprite de 8 bits (DRW estándar)
-
-    // --- Flags de estado ---
-    bool found;      // Flag: ¿se encontró el valor en búsqueda? (MEMSRCH)
-    bool keyPressed; // Flag: ¿se detectó una tecla presionada? (FX0A)
-
-    // --- Cálculos de píxeles individuales ---
-    int pixelX;   // Coordenada X del píxel actual (con wrapping)
-    int pixelY;   // Coordenada Y del píxel actual (con wrapping)
-    int pixelPos; // Posición lineal en framebuffer (pixelX + pixelY * WIDTH)
-    int basePos;  // Posición base para líneas horizontales (optimización)
-
-    // --- Dimensiones efectivas del display ---
-    uint16_t dispWidth;  // Ancho del display según modo (64 o 128)
-    uint16_t dispHeight; // Altura del display según modo (32 o 64)
-
-    dispHeight = chip64GetDisplayHeight(chip64);
-    dispWidth = chip64GetDisplayWidth(chip64);
-
-    // Depuración si está habilitada
-    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    switch (effect)
     {
-        printf("Ejecutando opcode: 0x%04X en PC=0x%04X\n", chip64->opcode, chip64->PC - 2);
+    case EFFECT_COLOR_CYCLE:
+        return COLOR_CYCLE_FRAMES;
+    case EFFECT_FADE:
+        return 2 * FADE_FRAMES;
+    case EFFECT_SHAKE:
+        return SHAKE_FRAMES;
+    default:
+        return 1;
     }
+}
 
-    // Decodificar e implementar opcode
-    switch (chip64->opcode & 0xF000)
+// Avanzar una etapa un frame y aplicar su contribución a los parámetros
+static void chip64RunEffectStage(Chip64 *chip64, Chip64EffectStage *stage,
+                                 Chip64EffectFrame *frame, int height)
+{
+    switch (stage->effect)
     {
-    case 0x0000:
-        switch (kk)
+    case EFFECT_COLOR_CYCLE:
+        // Solo paleta: el renderizador usa colorIndex al expandir los píxeles
+        stage->timer++;
+        if (stage->timer >= COLOR_CYCLE_FRAMES)
         {
-        case 0xE0:
-            // 00E0: Limpiar pantalla
-            memset(chip64->gfx, 0, DISPLAY_WIDTH * DISPLAY_HEIGHT);
-            chip64->drawFlag = true;
-            if (chip64->config.debugLevel >= DEBUG_OPCODES)
-            {
-                printf("CLS\n");
-            }
-            break;
-
-        case 0xEE:
-            // 00EE: Retornar de subrutina
-            chip64->SP--;
-            chip64->PC = chip64->stack[chip64->SP];
-            if (chip64->config.debugLevel >= DEBUG_OPCODES)
-            {
-                printf("RET (→ 0x%04X)\n", chip64->PC);
-            }
-            break;
+            stage->timer = 0;
+            chip64->colorIndex = (chip64->colorIndex + 1) % COLOR_PALETTE_SIZE;
 
-        default:
-            if (chip64->config.debugLevel >= DEBUG_OPCODES)
+            if (chip64->config.debugLevel >= DEBUG_VERBOSE)
             {
-                printf("Opcode desconocido: 0x%04X\n", chip64->opcode);
+                printf("🎨 Ciclo de color: índice %d (Color: 0x%08X)\n",
+                       chip64->colorIndex, COLOR_PALETTE[chip64->colorIndex]);
             }
-            break;
-        }
-
-    case 0x1000: // 1NNN: Saltar a dirección NNN
-        chip64->PC = nnn;
-        if (chip64->config.debugLevel >= DEBUG_OPCODES)
-        {
-            printf("JP 0x%03X\n", nnn);
-        }
-        break;
-
-    case 0x2000: // 2NNN: Llamar subrutina en NNN
-        chip64->stack[chip64->SP] = chip64->PC;
-        chip64->SP++;
-        chip64->PC = nnn;
-        if (chip64->config.debugLevel >= DEBUG_OPCODES)
-        {
-            printf("CALL 0x%03X (SP=%d)\n", nnn, chip64->SP);
         }
         break;
 
-    case 0x3000: // 3XKK: Saltar siguiente instrucción si VX == KK
-        if ((chip64->V[x] & 0xFF) == kk)
-        {
-            chip64->PC += 2;
-        }
-        if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    case EFFECT_FADE:
+    {
+        // Rampa triangular: de 255 a 0 en FADE_FRAMES frames y de vuelta
+        int t = stage->timer;
+        int fade = (t < FADE_FRAMES) ? 255 - 255 * t / FADE_FRAMES
+                                     : 255 * (t - FADE_FRAMES) / FADE_FRAMES;
+        for (int y = 0; y < height; y++)
         {
-            printf("SE V%X, 0x%02X (V%X=%llu)\n", x, kk, x,
-                   (unsigned long long)(chip64->V[x] & 0xFF));
+            frame->level[y] = (uint8_t)(frame->level[y] * fade / 255);
         }
+        stage->timer = (stage->timer + 1) % (2 * FADE_FRAMES);
+        frame->pixels = true;
         break;
+    }
 
-    case 0x4000: // 4XKK: Saltar siguiente instrucción si VX != KK
-        if (maskValue(chip64, chip64->V[x]) != kk)
-        {
-            chip64->PC += 2;
-        }
-        if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    case EFFECT_SHAKE:
+    {
+        const int8_t *offset = shakeOffsets[stage->timer];
+        int dy = offset[1] * SHAKE_AMPLITUDE / 2;
+        for (int y = 0; y < height; y++)
         {
-            printf("SNE V%X, 0x%02X\n", x, kk);
+            frame->srcY[y] = (int16_t)(frame->srcY[y] - dy);
         }
+        frame->shiftX += offset[0] * SHAKE_AMPLITUDE / 2;
+        stage->timer = (stage->timer + 1) % SHAKE_FRAMES;
+        frame->pixels = true;
         break;
+    }
 
-    case 0x5000:
-        switch (n)
-        {
-        case 0x0: // 5XY0: SE Vx, Vy - Saltar si Vx == Vy
-            if (chip64->V[x] == chip64->V[y])
-            {
-                chip64->PC += 2;
-            }
-            if (chip64->config.debugLevel >= DEBUG_OPCODES)
-            {
-                printf("SE V%X, V%X\n", x, y);
-            }
-            break;
-
-        case 0x1: // 5XY1: MUL Vx, Vy - Multiplicación
-            result = (__uint128_t)chip64->V[x] * (__uint128_t)chip64->V[y];
-            chip64->V[x] = maskValue(chip64, (uint64_t)result);
-            chip64->V[REG_VF] = (result > getMask(chip64)) ? 1 : 0;
-            if (chip64->config.debugLevel >= DEBUG_OPCODES)
-            {
-                printf("MUL V%X, V%X (overflow=%d)\n", x, y, chip64->V[REG_VF]);
-            }
-            break;
-
-        case 0x2: // 5XY2: DIV Vx, Vy - División
-            if (chip64->V[y] != 0)
-            {
-                chip64->V[REG_VF] = chip64->V[x] % chip64->V[y]; // Resto
-                chip64->V[x] = chip64->V[x] / chip64->V[y];      // Cociente
-            }
-            else
-            {
-                chip64->V[x] = getMask(chip64); // División por cero - ERROR
-                chip64->V[REG_VF] = 0;
-            }
-            if (chip64->config.debugLevel >= DEBUG_OPCODES)
-            {
-                printf("DIV V%X, V%X (resto=V%X)\n", x, y, REG_VF);
-            }
-            break;
-
-        case 0x3: // 5XY3: VADD Vx, Vy - Suma vectorial 2D
+    case EFFECT_SCANLINES:
+        for (int y = 1; y < height; y += 2)
         {
-            uint8_t nextX = (x + 1) % REGISTER_COUNT;
-            uint8_t nextY = (y + 1) % REGISTER_COUNT;
-            chip64->V[x] = maskValue(chip64, chip64->V[x] + chip64->V[y]);
-            chip64->V[nextX] = maskValue(chip64, chip64->V[nextX] + chip64->V[nextY]);
-            if (chip64->config.debugLevel >= DEBUG_OPCODES)
-            {
-                printf("VADD V%X, V%X (2D vector)\n", x, y);
-            }
+            frame->level[y] = (uint8_t)(frame->level[y] * SCANLINE_LEVEL / 255);
         }
+        frame->pixels = true;
         break;
 
-        case 0x4: // 5XY4: DOT Vx, Vy - Producto escalar 2D
-        {
-            uint8_t nextX = (x + 1) % REGISTER_COUNT;
-            uint8_t nextY = (y + 1) % REGISTER_COUNT;
-            product = (__uint128_t)chip64->V[x] * (__uint128_t)chip64->V[y] +
-                      (__uint128_t)chip64->V[nextX] * (__uint128_t)chip64->V[nextY];
-            chip64->V[x] = maskValue(chip64, (uint64_t)product);
-            chip64->V[REG_VF] = maskValue(chip64, (uint64_t)(product >> 64));
-            if (chip64->config.debugLevel >= DEBUG_OPCODES)
-            {
-                printf("DOT V%X, V%X (2D scalar product)\n", x, y);
-            }
-        }
-        break;
-        }
+    default:
         break;
+    }
+}
 
-    case 0x6000: // 6XKK: LD Vx, byte --> VX = KK
-        chip64->V[x] = kk;
-        if (chip64->config.debugLevel >= DEBUG_OPCODES)
-        {
-            printf("LD V%X, 0x%02X\n", x, kk);
-        }
-        break;
+// Pasada única sobre la zona visible de gfx2Buffer con los parámetros de todas
+// las etapas: intensidad de la fila si el píxel de origen está encendido, 0 si no
+static void chip64ComposeEffects(Chip64 *chip64, const Chip64EffectFrame *frame,
+                                 int width, int height)
+{
+    for (int y = 0; y < height; y++)
+    {
+        uint8_t *dst = &chip64->gfx2Buffer[y * DISPLAY_WIDTH];
+        int srcY = frame->srcY[y];
+        uint8_t level = frame->level[y];
 
-    case 0x7000: // 7XKK: ADD Vx, KK --> VX = VX + KK
-        chip64->V[x] = maskValue(chip64, chip64->V[x] + kk);
-        if (chip64->config.debugLevel >= DEBUG_OPCODES)
+        if (srcY < 0 || srcY >= height || level == 0)
         {
-            printf("ADD V%X, 0x%02X\n", x, kk);
+            memset(dst, 0, width);
+            continue;
         }
-        break;
-
-    case 0x8000:
-        switch (n)
-        {
-        case 0x0: // 8XY0: LD Vx, Vy --> VX = VY
-            chip64->V[x] = chip64->V[y];
-            if (chip64->config.debugLevel >= DEBUG_OPCODES)
-            {
-                printf("LD V%X, V%X\n", x, y);
-            }
-            break;
-        case 0x1: // 8XY1: OR Vx, Vy --> VX = VX OR VY
-            chip64->V[x] |= chip64->V[y];
-            if (chip64->config.debugLevel >= DEBUG_OPCODES)
-            {
-                printf("OR V%X, V%X\n", x, y);
-            }
-            break;
-        case 0x2: // 8XY2: AND Vx, Vy --> VX = VX AND VY
-            chip64->V[x] &= chip64->V[y];
-            if (chip64->config.debugLevel >= DEBUG_OPCODES)
-            {
-                printf("AND V%X, V%X\n", x, y);
-            }
-            break;
-        case 0x3: // 8XY3: XOR Vx, Vy --> VX = VX XOR VY
-            chip64->V[x] ^= chip64->V[y];
-            if (chip64->config.debugLevel >= DEBUG_OPCODES)
-            {
-                printf("XOR V%X, V%X\n", x, y);
-            }
-            break;
-        case 0x4: // 8XY4: ADD Vx, Vy --> VX = VX + VY, VF = carry
-            result = (__uint128_t)chip64->V[x] + (__uint128_t)chip64->V[y];
-            chip64->V[REG_VF] = (result > getMask(chip64)) ? 1 : 0;
-            chip64->V[x] = maskValue(chip64, (uint64_t)result);
-            if (chip64->config.debugLevel >= DEBUG_OPCODES)
 
-            {
-                printf("ADD V%X, V%X (carry=%d)\n", x, y, chip64->V[REG_VF]);
-            }
-            break;
-        case 0x5: // 8XY5: SUB Vx, Vy --> VX = VX - VY, VF = NOT borrow
-            chip64->V[REG_VF] = (chip64->V[x] >= chip64->V[y]) ? 1 : 0;
-            chip64->V[x] = maskValue(chip64, chip64->V[x] - chip64->V[y]);
-            if (chip64->config.debugLevel >= DEBUG_OPCODES)
-            {
-                printf("SUB V%X, V%X (NOT borrow=%d)\n", x, y, chip64->V[REG_VF]);
-            }
-            break;
-        case 0x6: // 8XY6: SHR Vx {, Vy} --> VX = VX >> 1, VF = LSB before shift
-            chip64->V[REG_VF] = chip64->V[x] & 0x1;
-            chip64->V[x] >>= 1;
-            if (chip64->config.debugLevel >= DEBUG_OPCODES)
-            {
-                printf("SHR V%X (LSB=%d)\n", x, chip64->V[REG_VF]);
-            }
-            break;
-        case 0x7: // 8XY7: SUBN Vx, Vy --> VX = VY - VX, VF = NOT borrow
-            chip64->V[REG_VF] = (chip64->V[y] >= chip64->V[x]) ? 1 : 0;
-            chip64->V[x] = maskValue(chip64, chip64->V[y] - chip64->V[x]);
-            if (chip64->config.debugLevel >= DEBUG_OPCODES)
-            {
-                printf("SUBN V%X, V%X (NOT borrow=%d)\n", x, y, chip64->V[REG_VF]);
-            }
-            break;
-        case 0xE: // 8XYE: SHL Vx {, Vy} --> VX = VX << 1, VF = MSB before shift
+        const uint64_t *row = chip64->gfxRows[srcY];
+        for (int x = 0; x < width; x++)
         {
-            uint8_t bitPos = (chip64->mode == MODE_8BIT) ? 7 : (chip64->mode == MODE_16BIT) ? 15
-                                                                                            : 63;
-            chip64->V[REG_VF] = (chip64->V[x] & ((uint64_t)1 << bitPos)) >> bitPos;
-            chip64->V[x] = maskValue(chip64, chip64->V[x] << 1);
-            if (chip64->config.debugLevel >= DEBUG_OPCODES)
+            int srcX = x - frame->shiftX;
+            uint8_t bit = 0;
+            if (srcX >= 0 && srcX < width)
             {
-                printf("SHL V%X (MSB=%d)\n", x, chip64->V[REG_VF]);
+                bit = (row[srcX >> 6] >> (63 - (srcX & 63))) & 1;
             }
+            dst[x] = level & (uint8_t)(0 - bit);
         }
-        break;
-        }
-        break;
+    }
+}
 
-    case 0x9000:
-        switch (n)
-        {
-        case 0x0: // 9XY0: SNE Vx, Vy --> Saltar si VX != VY
-            if (chip64->V[x] != chip64->V[y])
-            {
-                chip64->PC += 2;
-            }
-            if (chip64->config.debugLevel >= DEBUG_OPCODES)
-            {
-                printf("SNE V%X, V%X\n", x, y);
-            }
-            break;
-        case 0x1: // 9XY1: ROR Vx {, Vy} --> Rotar VX a la derecha
-            value = chip64->V[x];
-            shift = chip64->V[y] & 0x3F;
-            uint8_t bitWidth = (chip64->mode == MODE_8BIT) ? 8 : (chip64->mode == MODE_16BIT) ? 16
-                                                                                              : 64;
-            chip64->V[x] = (value >> shift) | (value << (bitWidth - shift));
-            chip64->V[x] = maskValue(chip64, chip64->V[x]);
-            if (chip64->config.debugLevel >= DEBUG_OPCODES)
-            {
-                printf("ROR V%X, V%X (%d bits)\n", x, y, shift);
-            }
-            break;
-        case 0x2: // 9XY2: ROL Vx {, Vy} --> Rotar VX a la izquierda
-            value = chip64->V[x];
-            shift = chip64->V[y] & 0x3F;
-            uint8_t bitWidth = (chip64->mode == MODE_8BIT) ? 8 : (chip64->mode == MODE_16BIT) ? 16
-                                                                                              : 64;
-            chip64->V[x] = (value << shift) | (value >> (bitWidth - shift));
-            chip64->V[x] = maskValue(chip64, chip64->V[x]);
-            if (chip64->config.debugLevel >= DEBUG_OPCODES)
-            {
-                printf("ROL V%X, V%X (%d bits)\n", x, y, shift);
-            }
-            break;
-        case 0x3: // 9XY3: POPCNT Vx --> Contar bits activos en VX
+bool chip64ProcessEffects(Chip64 *chip64)
 {
-            value = chip64->V[x];
-            count = 0;
-            uint8_t maxBits = (chip64->mode == MODE_8BIT) ? 8 : (chip64->mode == MODE_16BIT) ? 16
-                                                                                             : 64;
-            for (int i = 0; i < maxBits; i++)
-            {
-                if (value & ((uint64_t)1 << i))
-                {
-                    count++;
-                }
-            }
-            chip64->V[x] = count;
-            if (chip64->config.debugLevel >= DEBUG_OPCODES)
-            {
-                printf("POPCNT V%X = %llu\n", x, (unsigned long long)count);
-            }
-        }
-        break;
-        }
+    Chip64EffectPipeline *fx = &chip64->effects;
 
-        
-    
-    case 0xA000: // ANNN: LD I, addr --> I = NNN
-        chip64->I = nnn;
-        if (chip64->config.debugLevel >= DEBUG_OPCODES)
-        {
-            printf("LD I, 0x%03X\n", nnn);
-        }   
-        break;
+    // Sin etapas no hay nada que hacer: el renderizador lee gfxRows
+    if (fx->count == 0)
+    {
+        return false;
+    }
 
-    case 0xB000:
-        switch(n)
-        {
-            case 0x0:  // BNNN: JP V0, addr
-                chip64->PC = nnn + (chip64->V[0] & 0xFFFF);
-                if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-                    printf("JP V0, 0x%03X (→ 0x%04X)\n", nnn, chip64->PC);
-                }
-                break;
-
-            case 0x1:  // B001: MEMCPY - Copiar bloque
-                count = chip64->V[x] & 0xFFFF;
-                src = chip64->I;
-                dst = chip64->I + count;
-                
-                if (dst < MEMORY_SIZE) {
-                    if (src < dst && src + count > dst) {
-                        // Solapamiento: copiar hacia atrás
-                        for (uint64_t i = count; i > 0; i--) {
-                            chip64->memory[dst + i - 1] = chip64->memory[src + i - 1];
-                        }
-                    } else {
-                        for (uint64_t i = 0; i < count; i++) {
-                            chip64->memory[dst + i] = chip64->memory[src + i];
-                        }
-                    }
-                }
-                if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-                    printf("MEMCPY %llu bytes (I=0x%04llX)\n", 
-                           (unsigned long long)count, (unsigned long long)src);
-                }
-                break;
-
-            case 0x2:  // B002: MEMSRCH - Buscar valor en memoria
-                value = chip64->V[x];
-                found = false;
-                
-                uint8_t bytesPerValue = (chip64->mode == MODE_8BIT) ? 1 : 
-                                        (chip64->mode == MODE_16BIT) ? 2 : 8;
-                
-                for (int i = 0; i < 256 && (chip64->I + i + bytesPerValue - 1) < MEMORY_SIZE; 
-                     i += bytesPerValue) {
-                    if (chip64->mode == MODE_8BIT) {
-                        memValue = chip64->memory[chip64->I + i];
-                    } else if (chip64->mode == MODE_16BIT) {
-                        memValue = (chip64->memory[chip64->I + i] << 8) | 
-                                   chip64->memory[chip64->I + i + 1];
-                    } else {
-                        memValue = 0;
-                        for (int j = 0; j < 8; j++) {
-                            memValue = (memValue << 8) | chip64->memory[chip64->I + i + j];
-                        }
-                    }
-                    
-                    if (memValue == value) {
-                        chip64->V[REG_VF] = i / bytesPerValue;
-                        found = true;
-                        break;
-                    }
-                }
-                
-                if (!found) {
-                    chip64->V[REG_VF] = getMask(chip64);
-                }
-                if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-                    printf("MEMSRCH V%X (found=%d)\n", x, found);
-                }
-                break;
-        }
-    break;
+    int width = chip64GetDisplayWidth(chip64);
+    int height = chip64GetDisplayHeight(chip64);
 
-    case 0xC000: // CXKK: RND Vx, byte --> VX = random byte AND KK
-        chip64 ->V[x] = (rand() % 256) & kk; 
-        if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-            printf("RND V%X, 0x%02X (= 0x%02llX)\n", x, kk, 
-                   (unsigned long long)(chip64->V[x] & 0xFF));
-        }
-    break;
-
-    case 0xD000: // DXYN: DRW Vx, Vy, nibble --> Dibujar sprite en posición VX, VY con N bytes
-        xPos = chip64->V[x] % dispWidth;
-        yPos = chip64->V[y] % dispHeight;
-        height = n;
-        
-        chip64->V[REG_VF] = 0;
-        for (uint16_t row = 0; row < height; row++) {
-            spriteDataB = chip64->memory[chip64->I + row];
-            
-            for (int col = 0; col < 8; col++) {
-                if ((spriteDataB & (0x80 >> col)) != 0) {
-                    pixelX = (xPos + col) % dispWidth;
-                    pixelY = (yPos + row) % dispHeight;
-                    pixelPos = pixelX + (pixelY * DISPLAY_WIDTH);
-                    
-                    if (chip64->gfx[pixelPos] == 1) {
-                        chip64->V[REG_VF] = 1;
-                    }
-                    
-                    chip64->gfx[pixelPos] ^= 1;
-                }
-            }
-        }
-        
-        chip64->drawFlag = true;
-        if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-            printf("DRW V%X, V%X, %d (8×%d sprite)\n", x, y, n, n);
-        }
-    break;
+    Chip64EffectFrame frame;
+    for (int y = 0; y < height; y++)
+    {
+        frame.srcY[y] = (int16_t)y;
+        frame.level[y] = 255;
+    }
+    frame.shiftX = 0;
+    frame.pixels = false;
 
-    case 0xE000:
-        switch (kk)
-        {
-        case 0x01: // E001: CALLP - Llamada con parámetros 
-            if (chip64->SP + 4 <= STACK_SIZE) {
-                    chip64->stack[chip64->SP] = chip64->PC;
-                    chip64->stack[chip64->SP + 1] = chip64->V[0xD] & 0xFFFF;
-                    chip64->stack[chip64->SP + 2] = chip64->V[0xE] & 0xFFFF;
-                    chip64->stack[chip64->SP + 3] = chip64->V[REG_VF] & 0xFFFF;
-                    chip64->SP += 4;
-                    
-                    // Configurar registros especiales
-                    chip64->V[0xD] = (chip64->V[1] >> 8) & 0xFF;
-                    chip64->V[0xE] = chip64->V[1] & 0xFF;
-                    chip64->V[REG_VF] = y;  // Número de parámetros
-                    chip64->PC = chip64->V[0] & 0xFFFF;
-                    
-                    if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-                        printf("CALLP %d params (→ 0x%04X, SP=%d)\n", y, chip64->PC, chip64->SP);
-                    }
-                } else if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-                    printf("⚠️  ERROR: Stack overflow en CALLP\n");
-                }
-                break;
+    // Cada etapa solo ajusta los parámetros por fila
+    for (int i = 0; i < fx->count; i++)
+    {
+        chip64RunEffectStage(chip64, &fx->stages[i], &frame, height);
+    }
 
-        case 0x02: // E002: RETV - Retorno con valor
-            {
-                    uint64_t returnValue = chip64->V[y];
-                    
-                    if (chip64->SP >= 4) {
-                        chip64->SP -= 4;
-                        chip64->V[REG_VF] = chip64->stack[chip64->SP + 3];
-                        chip64->V[0xE] = chip64->stack[chip64->SP + 2];
-                        chip64->V[0xD] = chip64->stack[chip64->SP + 1];
-                        chip64->PC = chip64->stack[chip64->SP];
-                        chip64->V[0] = returnValue;
-                        
-                        if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-                            printf("RETV V%X (val=0x%llX, → 0x%04X, SP=%d)\n", 
-                                   y, (unsigned long long)returnValue, chip64->PC, chip64->SP);
-                        }
-                    } else if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-                        printf("⚠️  ERROR: Stack underflow en RETV\n");
-                    }
-                }
-                break;
+    // Los efectos de paleta no necesitan tocar el framebuffer
+    fx->composeLastNs = 0;
+    if (frame.pixels)
+    {
+        uint64_t start = chip64NowNs();
+        chip64ComposeEffects(chip64, &frame, width, height);
+        fx->composeLastNs = chip64NowNs() - start;
+        fx->composeTotalNs += fx->composeLastNs;
+    }
+    fx->frames++;
 
-        case 0x03: // E003: RND16 - Aleatorio 16 bits completo 
-            chip64->V[x] = rand() % 65536;
-            if (chip64->config.debugLevel >= DEBUG_OPCODES)
-            {
-                printf("RND16 V%X = 0x%04llX\n", x, (unsigned long long)chip64->V[x]);
+    return frame.pixels;
+}
+
+void chip64GetStatus(Chip64 *chip64, char *buffer, size_t bufferSize)
+{
+    snprintf(buffer, bufferSize,
+             "PC=0x%04X I=0x%016llX SP=%d Mode=%s Res=%dx%d",
+             chip64->PC,
+             (unsigned long long)chip64->I,
+             chip64->SP,
+             chip64->mode == MODE_8BIT ? "8bit" : chip64->mode == MODE_16BIT ? "16bit"
+                                                                             : "64bit",
+             chip64GetDisplayWidth(chip64),
+             chip64GetDisplayHeight(chip64));
+}
+
+// ============================================================================
+// MANEJADORES DE INSTRUCCIONES
+// ============================================================================
+
+/**
+ * @brief Invalida las entradas de la caché que cubren [addr, addr + len)
+ *
+ * Solo se anula el manejador: el resto de campos sigue siendo válido para una
+ * instrucción que se esté ejecutando desde la entrada que sobrescribe.
+ */
+static inline void chip64InvalidateCode(Chip64 *chip64, uint64_t addr, uint64_t len)
+{
+    if (addr >= MEMORY_SIZE)
+    {
+        return;
+    }
+
+    uint64_t end = addr + len;
+    if (end > MEMORY_SIZE)
+    {
+        end = MEMORY_SIZE;
+    }
+
+    for (uint64_t a = addr & ~(uint64_t)1; a < end; a += 2)
+    {
+        Chip64Instr *entry = &chip64->icache[a >> 1];
+        if (entry->handler != NULL)
+        {
+            entry->handler = NULL;
+            chip64->cacheStats.invalidations++;
+        }
+    }
+}
+
+// Opcodes sin efecto (variantes no definidas)
+static void opNop(Chip64 *chip64, const Chip64Instr *ins)
+{
+    (void)chip64;
+    (void)ins;
+}
+
+// 0NNN: Opcode desconocido
+static void opUnknown(Chip64 *chip64, const Chip64Instr *ins)
+{
+    (void)ins;
+    chip64->runEvent = CHIP64_RUN_UNKNOWN_OPCODE;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("Opcode desconocido: 0x%04X\n", chip64->opcode);
+    }
+}
+
+// 00E0: Limpiar pantalla
+static void opCls(Chip64 *chip64, const Chip64Instr *ins)
+{
+    (void)ins;
+    memset(chip64->gfxRows, 0, sizeof(chip64->gfxRows));
+    chip64->dirtyRows = UINT64_MAX;
+    chip64->drawFlag = true;
+    chip64->runEvent = CHIP64_RUN_DRAW;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("CLS\n");
+    }
+}
+
+// 00EE: Retornar de subrutina
+static void opRet(Chip64 *chip64, const Chip64Instr *ins)
+{
+    (void)ins;
+    chip64->SP--;
+    chip64->PC = chip64->stack[chip64->SP];
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("RET (→ 0x%04X)\n", chip64->PC);
+    }
+}
+
+// 1NNN: Saltar a dirección NNN
+static void opJp(Chip64 *chip64, const Chip64Instr *ins)
+{
+    chip64->PC = ins->nnn;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("JP 0x%03X\n", ins->nnn);
+    }
+}
+
+// 2NNN: Llamar subrutina en NNN
+static void opCall(Chip64 *chip64, const Chip64Instr *ins)
+{
+    chip64->stack[chip64->SP] = chip64->PC;
+    chip64->SP++;
+    chip64->PC = ins->nnn;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("CALL 0x%03X (SP=%d)\n", ins->nnn, chip64->SP);
+    }
+}
+
+// 3XKK: Saltar siguiente instrucción si VX == KK
+static void opSeVxByte(Chip64 *chip64, const Chip64Instr *ins)
+{
+    if ((chip64->V[ins->x] & 0xFF) == ins->kk)
+    {
+        chip64->PC += 2;
+    }
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("SE V%X, 0x%02X (V%X=%llu)\n", ins->x, ins->kk, ins->x,
+               (unsigned long long)(chip64->V[ins->x] & 0xFF));
+    }
+}
+
+// 5XY0: SE Vx, Vy - Saltar si Vx == Vy
+static void opSeVxVy(Chip64 *chip64, const Chip64Instr *ins)
+{
+    if (chip64->V[ins->x] == chip64->V[ins->y])
+    {
+        chip64->PC += 2;
+    }
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("SE V%X, V%X\n", ins->x, ins->y);
+    }
+}
+
+// 6XKK: LD Vx, byte --> VX = KK
+static void opLdVxByte(Chip64 *chip64, const Chip64Instr *ins)
+{
+    chip64->V[ins->x] = ins->kk;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("LD V%X, 0x%02X\n", ins->x, ins->kk);
+    }
+}
+
+// 8XY0: LD Vx, Vy --> VX = VY
+static void opLdVxVy(Chip64 *chip64, const Chip64Instr *ins)
+{
+    chip64->V[ins->x] = chip64->V[ins->y];
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("LD V%X, V%X\n", ins->x, ins->y);
+    }
+}
+
+// 8XY1: OR Vx, Vy --> VX = VX OR VY
+static void opOr(Chip64 *chip64, const Chip64Instr *ins)
+{
+    chip64->V[ins->x] |= chip64->V[ins->y];
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("OR V%X, V%X\n", ins->x, ins->y);
+    }
+}
+
+// 8XY2: AND Vx, Vy --> VX = VX AND VY
+static void opAnd(Chip64 *chip64, const Chip64Instr *ins)
+{
+    chip64->V[ins->x] &= chip64->V[ins->y];
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("AND V%X, V%X\n", ins->x, ins->y);
+    }
+}
+
+// 8XY3: XOR Vx, Vy --> VX = VX XOR VY
+static void opXor(Chip64 *chip64, const Chip64Instr *ins)
+{
+    chip64->V[ins->x] ^= chip64->V[ins->y];
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("XOR V%X, V%X\n", ins->x, ins->y);
+    }
+}
+
+// 8XY6: SHR Vx {, Vy} --> VX = VX >> 1, VF = LSB before shift
+static void opShr(Chip64 *chip64, const Chip64Instr *ins)
+{
+    chip64->V[REG_VF] = chip64->V[ins->x] & 0x1;
+    chip64->V[ins->x] >>= 1;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("SHR V%X (LSB=%d)\n", ins->x, (int)chip64->V[REG_VF]);
+    }
+}
+
+// 9XY0: SNE Vx, Vy --> Saltar si VX != VY
+static void opSneVxVy(Chip64 *chip64, const Chip64Instr *ins)
+{
+    if (chip64->V[ins->x] != chip64->V[ins->y])
+    {
+        chip64->PC += 2;
+    }
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("SNE V%X, V%X\n", ins->x, ins->y);
+    }
+}
+
+// ANNN: LD I, addr --> I = NNN
+static void opLdI(Chip64 *chip64, const Chip64Instr *ins)
+{
+    chip64->I = ins->nnn;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("LD I, 0x%03X\n", ins->nnn);
+    }
+}
+
+// BNNN: JP V0, addr
+static void opJpV0(Chip64 *chip64, const Chip64Instr *ins)
+{
+    chip64->PC = ins->nnn + (chip64->V[0] & 0xFFFF);
+    if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+        printf("JP V0, 0x%03X (→ 0x%04X)\n", ins->nnn, chip64->PC);
+    }
+}
+
+// B001: MEMCPY - Copiar bloque
+static void opMemcpy(Chip64 *chip64, const Chip64Instr *ins)
+{
+    uint64_t count = chip64->V[ins->x] & 0xFFFF;
+    uint64_t src = chip64->I;
+    uint64_t dst = chip64->I + count;
+
+    if (dst < MEMORY_SIZE) {
+        if (src < dst && src + count > dst) {
+            // Solapamiento: copiar hacia atrás
+            for (uint64_t i = count; i > 0; i--) {
+                chip64->memory[dst + i - 1] = chip64->memory[src + i - 1];
             }
+        } else {
+            for (uint64_t i = 0; i < count; i++) {
+                chip64->memory[dst + i] = chip64->memory[src + i];
+            }
+        }
+        chip64InvalidateCode(chip64, dst, count);
+    }
+    if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+        printf("MEMCPY %llu bytes (I=0x%04llX)\n",
+               (unsigned long long)count, (unsigned long long)src);
+    }
+}
+
+// CXKK: RND Vx, byte --> VX = random byte AND KK
+static void opRnd(Chip64 *chip64, const Chip64Instr *ins)
+{
+    chip64->V[ins->x] = (chip64Random(chip64) >> 24) & ins->kk;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+        printf("RND V%X, 0x%02X (= 0x%02llX)\n", ins->x, ins->kk,
+               (unsigned long long)(chip64->V[ins->x] & 0xFF));
+    }
+}
+
+// E001: CALLP - Llamada con parámetros
+static void opCallp(Chip64 *chip64, const Chip64Instr *ins)
+{
+    if (chip64->SP + 4 <= STACK_SIZE) {
+        chip64->stack[chip64->SP] = chip64->PC;
+        chip64->stack[chip64->SP + 1] = chip64->V[0xD] & 0xFFFF;
+        chip64->stack[chip64->SP + 2] = chip64->V[0xE] & 0xFFFF;
+        chip64->stack[chip64->SP + 3] = chip64->V[REG_VF] & 0xFFFF;
+        chip64->SP += 4;
+
+        // Configurar registros especiales
+        chip64->V[0xD] = (chip64->V[1] >> 8) & 0xFF;
+        chip64->V[0xE] = chip64->V[1] & 0xFF;
+        chip64->V[REG_VF] = ins->y;  // Número de parámetros
+        chip64->PC = chip64->V[0] & 0xFFFF;
+
+        if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+            printf("CALLP %d params (→ 0x%04X, SP=%d)\n", ins->y, chip64->PC, chip64->SP);
+        }
+    } else if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+        printf("⚠️  ERROR: Stack overflow en CALLP\n");
+    }
+}
+
+// E002: RETV - Retorno con valor
+static void opRetv(Chip64 *chip64, const Chip64Instr *ins)
+{
+    uint64_t returnValue = chip64->V[ins->y];
+
+    if (chip64->SP >= 4) {
+        chip64->SP -= 4;
+        chip64->V[REG_VF] = chip64->stack[chip64->SP + 3];
+        chip64->V[0xE] = chip64->stack[chip64->SP + 2];
+        chip64->V[0xD] = chip64->stack[chip64->SP + 1];
+        chip64->PC = chip64->stack[chip64->SP];
+        chip64->V[0] = returnValue;
+
+        if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+            printf("RETV V%X (val=0x%llX, → 0x%04X, SP=%d)\n",
+                   ins->y, (unsigned long long)returnValue, chip64->PC, chip64->SP);
+        }
+    } else if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+        printf("⚠️  ERROR: Stack underflow en RETV\n");
+    }
+}
+
+// E003: RND16 - Aleatorio 16 bits completo
+static void opRnd16(Chip64 *chip64, const Chip64Instr *ins)
+{
+    chip64->V[ins->x] = chip64Random(chip64) >> 16;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("RND16 V%X = 0x%04llX\n", ins->x, (unsigned long long)chip64->V[ins->x]);
+    }
+}
+
+// E004: RNDR - Aleatorio en rango
+static void opRndr(Chip64 *chip64, const Chip64Instr *ins)
+{
+    uint8_t rangeReg = (ins->x + 1) % REGISTER_COUNT;
+    if (chip64->V[rangeReg] > 0)
+    {
+        chip64->V[ins->x] = chip64Random(chip64) % (chip64->V[rangeReg] & 0xFFFF);
+    }
+    else
+    {
+        chip64->V[ins->x] = 0;
+    }
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("RNDR V%X (max=V%X=%llu, result=%llu)\n",
+               ins->x, rangeReg,
+               (unsigned long long)chip64->V[rangeReg],
+               (unsigned long long)chip64->V[ins->x]);
+    }
+}
+
+// EX9E: SKP Vx - Saltar si tecla presionada
+static void opSkp(Chip64 *chip64, const Chip64Instr *ins)
+{
+    if (chip64->key[chip64->V[ins->x] & 0xF] != 0) {
+        chip64->PC += 2;
+    }
+    if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+        printf("SKP V%X (key=%llu)\n", ins->x,
+               (unsigned long long)(chip64->V[ins->x] & 0xF));
+    }
+}
+
+// EXA1: SKNP Vx - Saltar si tecla NO presionada
+static void opSknp(Chip64 *chip64, const Chip64Instr *ins)
+{
+    if (chip64->key[chip64->V[ins->x] & 0xF] == 0) {
+        chip64->PC += 2;
+    }
+    if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+        printf("SKNP V%X\n", ins->x);
+    }
+}
+
+// FX07: LD Vx, DT
+static void opLdVxDt(Chip64 *chip64, const Chip64Instr *ins)
+{
+    chip64->V[ins->x] = chip64->delayTimer;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+        printf("LD V%X, DT (=%d)\n", ins->x, chip64->delayTimer);
+    }
+}
+
+// FX0A: LD Vx, K - Esperar tecla
+static void opLdVxK(Chip64 *chip64, const Chip64Instr *ins)
+{
+    bool keyPressed = false;
+    for (int i = 0; i < KEY_COUNT; i++) {
+        if (chip64->key[i]) {
+            chip64->V[ins->x] = i;
+            keyPressed = true;
             break;
+        }
+    }
+
+    // Sin tecla: repetir la instrucción y detener chip64Run hasta que
+    // chip64SetKey registre una pulsación
+    chip64->waitingKey = !keyPressed;
+    if (!keyPressed) {
+        chip64->PC -= 2;  // Repetir instrucción
+        chip64->runEvent = CHIP64_RUN_KEY_WAIT;
+    }
+    if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+        printf("LD V%X, K %s\n", ins->x, keyPressed ? "(pressed)" : "(waiting)");
+    }
+}
 
-        case 0x04: // E004: RNDR - Aleatorio en rango
+// FX15: LD DT, Vx
+static void opLdDtVx(Chip64 *chip64, const Chip64Instr *ins)
+{
+    chip64->delayTimer = chip64->V[ins->x] & 0xFF;
+    chip64->runEvent = CHIP64_RUN_TIMER_WRITE;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+        printf("LD DT, V%X (=%d)\n", ins->x, chip64->delayTimer);
+    }
+}
+
+// FX18: LD ST, Vx
+static void opLdStVx(Chip64 *chip64, const Chip64Instr *ins)
+{
+    chip64->soundTimer = chip64->V[ins->x] & 0xFF;
+    chip64->runEvent = CHIP64_RUN_TIMER_WRITE;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+        printf("LD ST, V%X (=%d)\n", ins->x, chip64->soundTimer);
+    }
+}
+
+// FX1E: ADD I, Vx
+static void opAddIVx(Chip64 *chip64, const Chip64Instr *ins)
+{
+    chip64->I += chip64->V[ins->x];
+    if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+        printf("ADD I, V%X (I=0x%04llX)\n", ins->x, (unsigned long long)chip64->I);
+    }
+}
+
+// FX29: LD F, Vx - Cargar sprite de fuente
+static void opLdFVx(Chip64 *chip64, const Chip64Instr *ins)
+{
+    uint8_t digit = chip64->V[ins->x] & 0x0F;
+    chip64->I = digit * 5;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+        printf("LD F, V%X (char='%X', I=0x%04llX)\n",
+               ins->x, digit, (unsigned long long)chip64->I);
+    }
+}
+
+
+// ============================================================================
+// NÚCLEOS ESPECIALIZADOS POR MODO
+// ============================================================================
+
+// 8-bit (compatibilidad CHIP-8), display 64×32
+#define CORE_SUFFIX 8
+#define CORE_BITS 8
+#define CORE_UINT uint8_t
+#define CORE_MASK 0xFFULL
+#define CORE_WIDTH (DISPLAY_WIDTH / 2)
+#define CORE_HEIGHT (DISPLAY_HEIGHT / 2)
+#include "chip64core.h"
+
+// 16-bit (compatibilidad CHIP-16), display 64×32
+#define CORE_SUFFIX 16
+#define CORE_BITS 16
+#define CORE_UINT uint16_t
+#define CORE_MASK 0xFFFFULL
+#define CORE_WIDTH (DISPLAY_WIDTH / 2)
+#define CORE_HEIGHT (DISPLAY_HEIGHT / 2)
+#include "chip64core.h"
+
+// 64-bit con alta resolución desactivada, display 64×32
+#define CORE_SUFFIX 64
+#define CORE_BITS 64
+#define CORE_UINT uint64_t
+#define CORE_MASK 0xFFFFFFFFFFFFFFFFULL
+#define CORE_WIDTH (DISPLAY_WIDTH / 2)
+#define CORE_HEIGHT (DISPLAY_HEIGHT / 2)
+#include "chip64core.h"
+
+// 64-bit en alta resolución, display 128×64
+#define CORE_SUFFIX 64Hi
+#define CORE_BITS 64
+#define CORE_UINT uint64_t
+#define CORE_MASK 0xFFFFFFFFFFFFFFFFULL
+#define CORE_WIDTH DISPLAY_WIDTH
+#define CORE_HEIGHT DISPLAY_HEIGHT
+#include "chip64core.h"
+
+/**
+ * @brief Elige el núcleo especializado para el modo y la resolución actuales
+ *
+ * La caché guarda punteros a manejadores de una variante concreta, así que se
+ * vacía cuando la variante cambia.
+ */
+static void chip64SelectCore(Chip64 *chip64)
+{
+    Chip64CycleFn core;
+    Chip64RunFn run;
+
+    switch (chip64->mode)
+    {
+    case MODE_8BIT:
+        core = chip64Cycle8;
+        run = chip64Run8;
+        break;
+    case MODE_16BIT:
+        core = chip64Cycle16;
+        run = chip64Run16;
+        break;
+    default:
+        core = chip64->config.highResMode ? chip64Cycle64Hi : chip64Cycle64;
+        run = chip64->config.highResMode ? chip64Run64Hi : chip64Run64;
+        break;
+    }
+
+    if (chip64->cycleFn != core)
+    {
+        chip64->cycleFn = core;
+        chip64->runFn = run;
+        chip64FlushCache(chip64);
+    }
+}
+
+// Ejecutar un ciclo de emulación con el núcleo del modo activo
+void chip64Cycle(Chip64 *chip64)
+{
+    chip64->cycleFn(chip64);
+}
+
+// Ejecutar hasta maxCycles instrucciones o hasta el primer evento
+Chip64RunResult chip64Run(Chip64 *chip64, uint32_t maxCycles)
+{
+    return chip64->runFn(chip64, maxCycles);
+}
+
+// ============================================================================
+// ESTADO GUARDADO
+// ============================================================================
+//
+// Formato (enteros en little-endian):
+//   "C64S", versión (1 byte)
+//   registros, pila, temporizadores, teclas y estado de ejecución
+//   memoria y pantalla comprimidas por rachas de ceros
+//
+// Las rachas se codifican con un byte de control: 0x00-0x7F = siguen
+// control + 1 bytes literales; 0x80-0xFF = (control & 0x7F) + 1 ceros. Un
+// cero suelto dentro de una racha de literales se deja como literal.
+//
+// No se guarda Config (es del anfitrión) salvo highResMode y colorMode, que
+// forman parte del modo de la máquina, ni la caché de instrucciones (al
+// restaurar solo se invalidan las entradas de la memoria que cambia) ni
+// gfx2Buffer, que chip64ProcessEffects regenera en cada frame. De los efectos
+// se guardan las etapas y sus contadores, no las medidas de tiempo.
+
+#define CHIP64_STATE_MAGIC "C64S"
+#define CHIP64_STATE_VERSION 1
+#define CHIP64_RUN_MAX 128 // Longitud máxima de una racha
+
+typedef struct
+{
+    uint8_t *data;
+    size_t size;
+    size_t pos;
+    bool ok; // false si el buffer se quedó corto
+} Chip64StateWriter;
+
+typedef struct
+{
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+    bool ok; // false si los datos se acabaron o no son válidos
+} Chip64StateReader;
+
+static void chip64StatePut(Chip64StateWriter *w, const void *src, size_t len)
+{
+    if (!w->ok || w->size - w->pos < len)
+    {
+        w->ok = false;
+        return;
+    }
+    memcpy(w->data + w->pos, src, len);
+    w->pos += len;
+}
+
+static void chip64StatePutInt(Chip64StateWriter *w, uint64_t value, int bytes)
+{
+    uint8_t buf[8];
+    for (int i = 0; i < bytes; i++)
+    {
+        buf[i] = (uint8_t)(value >> (8 * i));
+    }
+    chip64StatePut(w, buf, (size_t)bytes);
+}
+
+static void chip64StatePutZeroRuns(Chip64StateWriter *w, const uint8_t *src, size_t len)
+{
+    size_t i = 0;
+    while (i < len && w->ok)
+    {
+        size_t n = 0;
+        if (src[i] == 0)
+        {
+            // De 8 en 8 mientras se pueda: la memoria libre es casi toda ceros
+            uint64_t word;
+            while (i + n + 8 <= len && n + 8 <= CHIP64_RUN_MAX &&
+                   (memcpy(&word, src + i + n, 8), word == 0))
             {
-                uint8_t rangeReg = (x + 1) % REGISTER_COUNT;
-                if (chip64->V[rangeReg] > 0)
-                {
-                    chip64->V[x] = rand() % (chip64->V[rangeReg] & 0xFFFF);
-                }
-                else
-                {
-                    chip64->V[x] = 0;
-                }
-                if (chip64->config.debugLevel >= DEBUG_OPCODES)
+                n += 8;
+            }
+            while (i + n < len && n < CHIP64_RUN_MAX && src[i + n] == 0)
+            {
+                n++;
+            }
+            chip64StatePutInt(w, 0x80 | (n - 1), 1);
+        }
+        else
+        {
+            // Literales hasta dos ceros seguidos
+            while (i + n < len && n < CHIP64_RUN_MAX &&
+                   !(src[i + n] == 0 && (i + n + 1 == len || src[i + n + 1] == 0)))
+            {
+                n++;
+            }
+            chip64StatePutInt(w, n - 1, 1);
+            chip64StatePut(w, src + i, n);
+        }
+        i += n;
+    }
+}
+
+static void chip64StateGet(Chip64StateReader *r, void *dst, size_t len)
+{
+    if (!r->ok || r->size - r->pos < len)
+    {
+        r->ok = false;
+        memset(dst, 0, len);
+        return;
+    }
+    memcpy(dst, r->data + r->pos, len);
+    r->pos += len;
+}
+
+static uint64_t chip64StateGetInt(Chip64StateReader *r, int bytes)
+{
+    uint8_t buf[8];
+    uint64_t value = 0;
+    chip64StateGet(r, buf, (size_t)bytes);
+    for (int i = 0; i < bytes; i++)
+    {
+        value |= (uint64_t)buf[i] << (8 * i);
+    }
+    return value;
+}
+
+// Decodificar len bytes comprimidos en dst. Con dst NULL solo se comprueba
+// que los datos son válidos y se avanza el lector
+static void chip64StateGetZeroRuns(Chip64StateReader *r, uint8_t *dst, size_t len)
+{
+    size_t i = 0;
+    while (i < len && r->ok)
+    {
+        uint8_t control = (uint8_t)chip64StateGetInt(r, 1);
+        size_t n = (size_t)(control & 0x7F) + 1;
+        if (n > len - i)
+        {
+            r->ok = false;
+            break;
+        }
+        if (dst == NULL)
+        {
+            // Solo comprobar: saltar los literales
+            if (!(control & 0x80))
+            {
+                if (r->size - r->pos < n)
                 {
-                    printf("RNDR V%X (max=V%X=%llu, result=%llu)\n",
-                           x, rangeReg,
-                           (unsigned long long)chip64->V[rangeReg],
-                           (unsigned long long)chip64->V[x]);
+                    r->ok = false;
+                    break;
                 }
+                r->pos += n;
             }
-            break;
+        }
+        else if (control & 0x80)
+        {
+            memset(dst + i, 0, n);
+        }
+        else
+        {
+            chip64StateGet(r, dst + i, n);
+        }
+        i += n;
+    }
+}
 
-        case 0x9E: // EX9E: SKP Vx - Saltar si tecla presionada
-                if (chip64->key[chip64->V[x] & 0xF] != 0) {
-                    chip64->PC += 2;
-                }
-                if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-                    printf("SKP V%X (key=%llu)\n", x, 
-                           (unsigned long long)(chip64->V[x] & 0xF));
-                }
-                break;
+// Decodificar la memoria directamente sobre el núcleo invalidando solo las
+// entradas de la caché de instrucciones cuyos bytes cambian: al restaurar un
+// estado cercano (rebobinado, run-ahead) casi toda la caché sigue valiendo.
+// Los datos ya se han comprobado con chip64StateGetZeroRuns
+static void chip64StateRestoreMemory(Chip64 *chip64, Chip64StateReader *r)
+{
+    static const uint8_t zeros[CHIP64_RUN_MAX];
+    uint64_t addr = 0;
 
-        case 0xA1:  // EXA1: SKNP Vx - Saltar si tecla NO presionada
-                if (chip64->key[chip64->V[x] & 0xF] == 0) {
-                    chip64->PC += 2;
-                }
-                if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-                    printf("SKNP V%X\n", x);
-                }
-                break;
-        break;
+    while (addr < MEMORY_SIZE)
+    {
+        uint8_t control = (uint8_t)chip64StateGetInt(r, 1);
+        uint32_t n = (uint32_t)(control & 0x7F) + 1;
+        const uint8_t *src = zeros;
+        if (!(control & 0x80))
+        {
+            src = r->data + r->pos;
+            r->pos += n;
         }
 
-    case 0xF000:
-        switch (kk) {
-            
-            case 0x01:  // F001 (FX01): DRAW16 - Dibujar sprite 16×16 (CHIP-16)
-                xPos = chip64->V[2] % dispWidth;
-                yPos = chip64->V[3] % dispHeight;
-                chip64->V[REG_VF] = 0;
-                
-                for (int row = 0; row < 16; row++) {
-                    spriteData = (chip64->memory[chip64->I + row * 2] << 8) |
-                                 chip64->memory[chip64->I + row * 2 + 1];
-                    
-                    for (int col = 0; col < 16; col++) {
-                        if ((spriteData & (0x8000 >> col)) != 0) {
-                            pixelX = (xPos + col) % dispWidth;
-                            pixelY = (yPos + row) % dispHeight;
-                            pixelPos = pixelX + (pixelY * DISPLAY_WIDTH);
-                            
-                            if (chip64->gfx[pixelPos] == 1) {
-                                chip64->V[REG_VF] = 1;
-                            }
-                            
-                            chip64->gfx[pixelPos] ^= 1;
-                        }
-                    }
-                }
-                
-                chip64->drawFlag = true;
-                if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-                    printf("DRAW16 at (%llu,%llu)\n", 
-                           (unsigned long long)xPos, (unsigned long long)yPos);
-                }
-                break;
-            
-            case 0x02:  // F002 (FX02): HLINE - Línea horizontal (CHIP-16)
-                xPos = chip64->V[2] % dispWidth;
-                yPos = chip64->V[3] % dispHeight;
-                length = chip64->V[4];
-                pattern = chip64->V[5];
-                
-                if (length == 0 || length > dispWidth - xPos) {
-                    length = dispWidth - xPos;
-                }
-                
-                chip64->V[REG_VF] = 0;
-                basePos = xPos + (yPos * DISPLAY_WIDTH);
-                
-                for (uint64_t i = 0; i < length; i++) {
-                    if ((pattern & (0x8000 >> (i % 16))) != 0) {
-                        if (chip64->gfx[basePos + i] == 1) {
-                            chip64->V[REG_VF] = 1;
-                        }
-                        chip64->gfx[basePos + i] ^= 1;
-                    }
-                }
-                
-                chip64->drawFlag = true;
-                if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-                    printf("HLINE (%llu,%llu) len=%llu\n", 
-                           (unsigned long long)xPos, (unsigned long long)yPos, 
-                           (unsigned long long)length);
-                }
-                break;
-            
-            case 0x03:  // F003 (FX03): VLINE - Línea vertical (CHIP-16)
-                xPos = chip64->V[2] % dispWidth;
-                yPos = chip64->V[3] % dispHeight;
-                height = chip64->V[4];
-                pattern = chip64->V[5];
-                
-                if (height == 0 || height > dispHeight - yPos) {
-                    height = dispHeight - yPos;
-                }
-                
-                chip64->V[REG_VF] = 0;
-                
-                for (uint64_t i = 0; i < height; i++) {
-                    if ((pattern & (0x8000 >> (i % 16))) != 0) {
-                        pixelPos = xPos + ((yPos + i) % dispHeight) * DISPLAY_WIDTH;
-                        
-                        if (chip64->gfx[pixelPos] == 1) {
-                            chip64->V[REG_VF] = 1;
-                        }
-                        chip64->gfx[pixelPos] ^= 1;
-                    }
-                }
-                
-                chip64->drawFlag = true;
-                if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-                    printf("VLINE (%llu,%llu) height=%llu\n", 
-                           (unsigned long long)xPos, (unsigned long long)yPos, 
-                           (unsigned long long)height);
-                }
-                break;
-            
-            case 0x04:  // F004 (FX04): DRAW32 - Dibujar sprite 32×32 (CHIP-64) 
-                xPos = chip64->V[2] % dispWidth;
-                yPos = chip64->V[3] % dispHeight;
-                chip64->V[REG_VF] = 0;
-                
-                // Sprite 32×32 = 32 filas × 4 bytes por fila = 128 bytes
-                for (int row = 0; row < 32; row++) {
-                    // Leer 4 bytes (32 bits) por fila
-                    uint32_t spriteRow = 
-                        ((uint32_t)chip64->memory[chip64->I + row * 4] << 24) |
-                        ((uint32_t)chip64->memory[chip64->I + row * 4 + 1] << 16) |
-                        ((uint32_t)chip64->memory[chip64->I + row * 4 + 2] << 8) |
-                        ((uint32_t)chip64->memory[chip64->I + row * 4 + 3]);
-                    
-                    for (int col = 0; col < 32; col++) {
-                        if ((spriteRow & (0x80000000 >> col)) != 0) {
-                            pixelX = (xPos + col) % dispWidth;
-                            pixelY = (yPos + row) % dispHeight;
-                            pixelPos = pixelX + (pixelY * DISPLAY_WIDTH);
-                            
-                            if (chip64->gfx[pixelPos] == 1) {
-                                chip64->V[REG_VF] = 1;
-                            }
-                            
-                            chip64->gfx[pixelPos] ^= 1;
-                        }
-                    }
-                }
-                
-                chip64->drawFlag = true;
-                if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-                    printf("DRAW32 at (%llu,%llu) - 32×32 sprite [CHIP-64]\n", 
-                           (unsigned long long)xPos, (unsigned long long)yPos);
-                }
-                break;
-            
-                        
-            case 0x07:  // FX07: LD Vx, DT
-                chip64->V[x] = chip64->delayTimer;
-                if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-                    printf("LD V%X, DT (=%d)\n", x, chip64->delayTimer);
-                }
-                break;
-            
-            case 0x0A:  // FX0A: LD Vx, K - Esperar tecla
-                keyPressed = false;
-                for (int i = 0; i < KEY_COUNT; i++) {
-                    if (chip64->key[i]) {
-                        chip64->V[x] = i;
-                        keyPressed = true;
-                        break;
-                    }
-                }
-                
-                if (!keyPressed) {
-                    chip64->PC -= 2;  // Repetir instrucción
-                }
-                if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-                    printf("LD V%X, K %s\n", x, keyPressed ? "(pressed)" : "(waiting)");
-                }
-                break;
-            
-            case 0x15:  // FX15: LD DT, Vx
-                chip64->delayTimer = chip64->V[x] & 0xFF;
-                if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-                    printf("LD DT, V%X (=%d)\n", x, chip64->delayTimer);
-                }
-                break;
-            
-            case 0x18:  // FX18: LD ST, Vx
-                chip64->soundTimer = chip64->V[x] & 0xFF;
-                if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-                    printf("LD ST, V%X (=%d)\n", x, chip64->soundTimer);
-                }
-                break;
-            
-            case 0x1E:  // FX1E: ADD I, Vx
-                chip64->I += chip64->V[x];
-                if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-                    printf("ADD I, V%X (I=0x%04llX)\n", x, (unsigned long long)chip64->I);
-                }
-                break;
-            
-            case 0x29:  // FX29: LD F, Vx - Cargar sprite de fuente
-                {
-                    uint8_t digit = chip64->V[x] & 0x0F;
-                    chip64->I = digit * 5;
-                    if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-                        printf("LD F, V%X (char='%X', I=0x%04llX)\n", 
-                               x, digit, (unsigned long long)chip64->I);
-                    }
-                }
-                break;
-            
-            case 0x33:  // FX33: LD B, Vx - Almacenar BCD
-                if (chip64->mode == MODE_8BIT) {
-                    uint8_t val = chip64->V[x] & 0xFF;
-                    chip64->memory[chip64->I] = val / 100;
-                    chip64->memory[chip64->I + 1] = (val / 10) % 10;
-                    chip64->memory[chip64->I + 2] = val % 10;
-                } else if (chip64->mode == MODE_16BIT) {
-                    uint16_t val = chip64->V[x] & 0xFFFF;
-                    chip64->memory[chip64->I] = val / 10000;
-                    chip64->memory[chip64->I + 1] = (val / 1000) % 10;
-                    chip64->memory[chip64->I + 2] = (val / 100) % 10;
-                    chip64->memory[chip64->I + 3] = (val / 10) % 10;
-                    chip64->memory[chip64->I + 4] = val % 10;
-                } else {  // MODE_64BIT - 20 dígitos
-                    uint64_t val = chip64->V[x];
-                    for (int i = 19; i >= 0; i--) {
-                        chip64->memory[chip64->I + i] = val % 10;
-                        val /= 10;
-                    }
-                }
-                if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-                    printf("LD B, V%X (BCD at I=0x%04llX)\n", x, (unsigned long long)chip64->I);
-                }
-                break;
-            
-            case 0x55:  // FX55: LD [I], Vx - Guardar registros
-                if (chip64->mode == MODE_8BIT) {
-                    for (int i = 0; i <= x; i++) {
-                        chip64->memory[chip64->I + i] = chip64->V[i] & 0xFF;
-                    }
-                } else if (chip64->mode == MODE_16BIT) {
-                    for (int i = 0; i <= x; i++) {
-                        chip64->memory[chip64->I + (i * 2)] = (chip64->V[i] >> 8) & 0xFF;
-                        chip64->memory[chip64->I + (i * 2) + 1] = chip64->V[i] & 0xFF;
-                    }
-                    chip64->I += (x + 1) * 2;
-                } else {  // MODE_64BIT
-                    for (int i = 0; i <= x; i++) {
-                        for (int j = 0; j < 8; j++) {
-                            chip64->memory[chip64->I + (i * 8) + j] = 
-                                (chip64->V[i] >> (56 - j * 8)) & 0xFF;
-                        }
-                    }
-                    chip64->I += (x + 1) * 8;
-                }
-                if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-                    printf("LD [I], V%X (saved V0-V%X)\n", x, x);
-                }
-                break;
-            
-            case 0x65:  // FX65: LD Vx, [I] - Cargar registros
-                if (chip64->mode == MODE_8BIT) {
-                    for (int i = 0; i <= x; i++) {
-                        chip64->V[i] = chip64->memory[chip64->I + i];
-                    }
-                } else if (chip64->mode == MODE_16BIT) {
-                    for (int i = 0; i <= x; i++) {
-                        chip64->V[i] = (chip64->memory[chip64->I + (i * 2)] << 8) |
-                                       chip64->memory[chip64->I + (i * 2) + 1];
-                    }
-                    chip64->I += (x + 1) * 2;
-                } else {  // MODE_64BIT
-                    for (int i = 0; i <= x; i++) {
-                        chip64->V[i] = 0;
-                        for (int j = 0; j < 8; j++) {
-                            chip64->V[i] = (chip64->V[i] << 8) | 
-                                           chip64->memory[chip64->I + (i * 8) + j];
-                        }
-                    }
-                    chip64->I += (x + 1) * 8;
-                }
-                if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-                    printf("LD V%X, [I] (loaded V0-V%X)\n", x, x);
-                }
-                break;
+        // Casi todas las rachas siguen igual
+        if (memcmp(chip64->memory + addr, src, n) == 0)
+        {
+            addr += n;
+            continue;
         }
-        break;
-    
-    
-    default:
-        if (chip64->config.debugLevel >= DEBUG_OPCODES) {
-            printf("OPCODE DESCONOCIDO: 0x%04X en PC=0x%04X\n", 
-                   chip64->opcode, chip64->PC - 2);
+
+        // Tramo [first, last] de bytes distintos dentro de la racha
+        uint8_t *dst = chip64->memory + addr;
+        uint32_t first = 0;
+        while (first < n && dst[first] == src[first])
+        {
+            first++;
         }
-        break;
-}
\ No newline at end of file
+        if (first < n)
+        {
+            uint32_t last = n - 1;
+            while (dst[last] == src[last])
+            {
+                last--;
+            }
+            memcpy(dst + first, src + first, last - first + 1);
+            chip64InvalidateCode(chip64, addr + first, last - first + 1);
+        }
+        addr += n;
+    }
+}
+
+size_t chip64SaveState(const Chip64 *chip64, uint8_t *buffer, size_t size)
+{
+    Chip64StateWriter w = {buffer, size, 0, true};
+
+    chip64StatePut(&w, CHIP64_STATE_MAGIC, 4);
+    chip64StatePutInt(&w, CHIP64_STATE_VERSION, 1);
+
+    chip64StatePutInt(&w, chip64->opcode, 2);
+    for (int i = 0; i < REGISTER_COUNT; i++)
+    {
+        chip64StatePutInt(&w, chip64->V[i], 8);
+    }
+    chip64StatePutInt(&w, chip64->I, 8);
+    chip64StatePutInt(&w, chip64->PC, 2);
+    chip64StatePutInt(&w, chip64->SP, 2);
+    for (int i = 0; i < STACK_SIZE; i++)
+    {
+        chip64StatePutInt(&w, chip64->stack[i], 2);
+    }
+    chip64StatePutInt(&w, chip64->delayTimer, 1);
+    chip64StatePutInt(&w, chip64->soundTimer, 1);
+    chip64StatePut(&w, chip64->key, KEY_COUNT);
+    chip64StatePutInt(&w, chip64->drawFlag, 1);
+    chip64StatePutInt(&w, chip64->dirtyRows, 8);
+    chip64StatePutInt(&w, chip64->waitingKey, 1);
+    chip64StatePutInt(&w, chip64->runEvent, 1);
+    chip64StatePutInt(&w, chip64->rngState, 4);
+    chip64StatePutInt(&w, chip64->mode, 1);
+    chip64StatePutInt(&w, chip64->config.highResMode, 1);
+    chip64StatePutInt(&w, chip64->config.colorMode, 1);
+    for (int i = 0; i < MAX_COLORS; i++)
+    {
+        chip64StatePutInt(&w, chip64->palette[i], 2);
+    }
+    chip64StatePutInt(&w, chip64->colorIndex, 1);
+    chip64StatePutInt(&w, chip64->effects.count, 1);
+    chip64StatePutInt(&w, chip64->effects.frames, 4);
+    for (int i = 0; i < chip64->effects.count; i++)
+    {
+        chip64StatePutInt(&w, chip64->effects.stages[i].effect, 1);
+        chip64StatePutInt(&w, chip64->effects.stages[i].timer, 2);
+    }
+
+    chip64StatePutZeroRuns(&w, chip64->memory, MEMORY_SIZE);
+
+    // Filas de pantalla en little-endian, igual en cualquier anfitrión
+    uint8_t rows[DISPLAY_HEIGHT * DISPLAY_WIDTH / 8];
+    uint8_t *out = rows;
+    for (int y = 0; y < DISPLAY_HEIGHT; y++)
+    {
+        for (int wd = 0; wd < DISPLAY_WIDTH / 64; wd++)
+        {
+            for (int b = 0; b < 8; b++)
+            {
+                *out++ = (uint8_t)(chip64->gfxRows[y][wd] >> (8 * b));
+            }
+        }
+    }
+    chip64StatePutZeroRuns(&w, rows, sizeof(rows));
+
+    return w.ok ? w.pos : 0;
+}
+
+bool chip64LoadState(Chip64 *chip64, const uint8_t *buffer, size_t size)
+{
+    Chip64StateReader r = {buffer, size, 0, true};
+    char magic[4];
+
+    chip64StateGet(&r, magic, 4);
+    if (!r.ok || memcmp(magic, CHIP64_STATE_MAGIC, 4) != 0)
+    {
+        fprintf(stderr, "Error: El estado guardado no es de CHIP-64\n");
+        return false;
+    }
+    unsigned version = (unsigned)chip64StateGetInt(&r, 1);
+    if (version != CHIP64_STATE_VERSION)
+    {
+        fprintf(stderr, "Error: Versión de estado guardado no soportada: %u\n", version);
+        return false;
+    }
+
+    // Primera pasada: los registros se leen en variables locales y la memoria
+    // solo se comprueba, para no dejar el núcleo a medias si los datos están
+    // truncados o no son válidos
+    uint16_t opcode = (uint16_t)chip64StateGetInt(&r, 2);
+    uint64_t V[REGISTER_COUNT];
+    for (int i = 0; i < REGISTER_COUNT; i++)
+    {
+        V[i] = chip64StateGetInt(&r, 8);
+    }
+    uint64_t I = chip64StateGetInt(&r, 8);
+    uint32_t PC = (uint32_t)chip64StateGetInt(&r, 2);
+    uint16_t SP = (uint16_t)chip64StateGetInt(&r, 2);
+    uint16_t stack[STACK_SIZE];
+    for (int i = 0; i < STACK_SIZE; i++)
+    {
+        stack[i] = (uint16_t)chip64StateGetInt(&r, 2);
+    }
+    uint8_t delayTimer = (uint8_t)chip64StateGetInt(&r, 1);
+    uint8_t soundTimer = (uint8_t)chip64StateGetInt(&r, 1);
+    uint8_t key[KEY_COUNT];
+    chip64StateGet(&r, key, KEY_COUNT);
+    bool drawFlag = chip64StateGetInt(&r, 1) != 0;
+    uint64_t dirtyRows = chip64StateGetInt(&r, 8);
+    bool waitingKey = chip64StateGetInt(&r, 1) != 0;
+    Chip64RunResult runEvent = (Chip64RunResult)chip64StateGetInt(&r, 1);
+    uint32_t rngState = (uint32_t)chip64StateGetInt(&r, 4);
+    unsigned mode = (unsigned)chip64StateGetInt(&r, 1);
+    bool highResMode = chip64StateGetInt(&r, 1) != 0;
+    bool colorMode = chip64StateGetInt(&r, 1) != 0;
+    Color16 palette[MAX_COLORS];
+    for (int i = 0; i < MAX_COLORS; i++)
+    {
+        palette[i] = (Color16)chip64StateGetInt(&r, 2);
+    }
+    uint8_t colorIndex = (uint8_t)chip64StateGetInt(&r, 1);
+    Chip64EffectPipeline effects;
+    memset(&effects, 0, sizeof(effects));
+    effects.count = (uint8_t)chip64StateGetInt(&r, 1);
+    effects.frames = (uint32_t)chip64StateGetInt(&r, 4);
+    if (effects.count > MAX_EFFECT_STAGES)
+    {
+        r.ok = false;
+    }
+    for (int i = 0; i < effects.count && r.ok; i++)
+    {
+        unsigned effect = (unsigned)chip64StateGetInt(&r, 1);
+        uint16_t timer = (uint16_t)chip64StateGetInt(&r, 2);
+        if (effect > EFFECT_SCANLINES || timer >= chip64EffectPeriod((GraphicsEffects)effect))
+        {
+            r.ok = false;
+        }
+        effects.stages[i].effect = (GraphicsEffects)effect;
+        effects.stages[i].timer = timer;
+    }
+
+    Chip64StateReader memory = r;
+    chip64StateGetZeroRuns(&r, NULL, MEMORY_SIZE);
+
+    uint8_t rows[DISPLAY_HEIGHT * DISPLAY_WIDTH / 8];
+    chip64StateGetZeroRuns(&r, rows, sizeof(rows));
+
+    if (!r.ok || SP > STACK_SIZE || PC >= MEMORY_SIZE || mode > MODE_64BIT ||
+        rngState == 0 || colorIndex >= COLOR_PALETTE_SIZE)
+    {
+        fprintf(stderr, "Error: Estado guardado truncado o corrupto\n");
+        return false;
+    }
+
+    // Segunda pasada: copiar el estado de la máquina; config y estadísticas
+    // se conservan
+    chip64->opcode = opcode;
+    chip64StateRestoreMemory(chip64, &memory);
+    memcpy(chip64->V, V, sizeof(chip64->V));
+    chip64->I = I;
+    chip64->PC = (uint16_t)PC;
+    const uint8_t *in = rows;
+    for (int y = 0; y < DISPLAY_HEIGHT; y++)
+    {
+        for (int wd = 0; wd < DISPLAY_WIDTH / 64; wd++)
+        {
+            chip64->gfxRows[y][wd] = 0;
+            for (int b = 0; b < 8; b++)
+            {
+                chip64->gfxRows[y][wd] |= (uint64_t)*in++ << (8 * b);
+            }
+        }
+    }
+    chip64->delayTimer = delayTimer;
+    chip64->soundTimer = soundTimer;
+    memcpy(chip64->stack, stack, sizeof(chip64->stack));
+    chip64->SP = SP;
+    memcpy(chip64->key, key, KEY_COUNT);
+    chip64->drawFlag = drawFlag;
+    chip64->dirtyRows = dirtyRows;
+    chip64->waitingKey = waitingKey;
+    chip64->runEvent = runEvent;
+    chip64->runCycles = 0;
+    chip64->rngState = rngState;
+    memcpy(chip64->palette, palette, sizeof(chip64->palette));
+    chip64->colorIndex = colorIndex;
+    chip64->effects = effects;
+
+    // El modo y la resolución eligen el núcleo especializado
+    chip64->mode = (EmuMode)mode;
+    chip64->config.highResMode = highResMode;
+    chip64->config.colorMode = colorMode;
+    chip64SelectCore(chip64);
+
+    return true;
+}
+
+bool chip64SaveStateFile(const Chip64 *chip64, const char *filename)
+{
+    // Con 64 KB de memoria el estado no cabe cómodamente en la pila
+    uint8_t *buffer = malloc(CHIP64_STATE_MAX_SIZE);
+    if (!buffer)
+    {
+        fprintf(stderr, "Error: Sin memoria para guardar el estado\n");
+        return false;
+    }
+    size_t size = chip64SaveState(chip64, buffer, CHIP64_STATE_MAX_SIZE);
+
+    FILE *file = fopen(filename, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "Error: No se pudo crear el archivo %s\n", filename);
+        free(buffer);
+        return false;
+    }
+    bool ok = fwrite(buffer, 1, size, file) == size;
+    free(buffer);
+    if (fclose(file) != 0)
+    {
+        ok = false;
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "Error: No se pudo escribir el estado en %s\n", filename);
+    }
+    return ok;
+}
+
+bool chip64LoadStateFile(Chip64 *chip64, const char *filename)
+{
+    FILE *file = fopen(filename, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "Error: No se pudo abrir el archivo %s\n", filename);
+        return false;
+    }
+
+    // Un byte más que el máximo para detectar archivos demasiado grandes
+    uint8_t *buffer = malloc(CHIP64_STATE_MAX_SIZE + 1);
+    if (!buffer)
+    {
+        fprintf(stderr, "Error: Sin memoria para cargar el estado\n");
+        fclose(file);
+        return false;
+    }
+    size_t size = fread(buffer, 1, CHIP64_STATE_MAX_SIZE + 1, file);
+    fclose(file);
+
+    bool ok = false;
+    if (size > CHIP64_STATE_MAX_SIZE)
+    {
+        fprintf(stderr, "Error: %s no es un estado guardado de CHIP-64\n", filename);
+    }
+    else
+    {
+        ok = chip64LoadState(chip64, buffer, size);
+    }
+    free(buffer);
+    return ok;
+}
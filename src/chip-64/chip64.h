@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include "config64.h"
 
 // Definición del conjunto de fuentes en formato de sprites hexadecimales
@@ -26,7 +27,64 @@ static const uint8_t chip64_fontset[FONTSET_SIZE] = {
 };
 
 
+typedef struct Chip64 Chip64;
+
+/**
+ * @brief Motivo por el que chip64Run devuelve el control al anfitrión
+ */
+typedef enum {
+    CHIP64_RUN_BUDGET,            // Se ejecutaron maxCycles instrucciones sin eventos
+    CHIP64_RUN_DRAW,              // La pantalla cambió
+    CHIP64_RUN_KEY_WAIT,          // FX0A esperando una tecla (el PC sigue apuntando a FX0A)
+    CHIP64_RUN_TIMER_WRITE,       // Escritura en el delay o sound timer (FX15, FX18)
+    CHIP64_RUN_UNKNOWN_OPCODE     // Opcode 0NNN no soportado
+} Chip64RunResult;
+
+typedef struct Chip64Instr Chip64Instr;
+
+// Manejador que ejecuta una instrucción ya decodificada
+typedef void (*Chip64Handler)(Chip64* chip64, const Chip64Instr* ins);
+
+// Núcleo de ejecución especializado para un modo (ver chip64SetMode)
+typedef void (*Chip64CycleFn)(Chip64* chip64);
+typedef Chip64RunResult (*Chip64RunFn)(Chip64* chip64, uint32_t maxCycles);
+
+// Instrucción predecodificada: manejador + campos del opcode
+struct Chip64Instr {
+    Chip64Handler handler;        // Función que ejecuta la instrucción (NULL = entrada no válida)
+    uint16_t opcode;              // Opcode original
+    uint16_t nnn;                 // Dirección de 12 bits
+    uint8_t x;                    // Segundo nibble (registro X)
+    uint8_t y;                    // Tercer nibble (registro Y)
+    uint8_t n;                    // Cuarto nibble
+    uint8_t kk;                   // Byte bajo
+};
+
+// Contadores de la caché de instrucciones predecodificadas
+typedef struct {
+    uint64_t hits;                // Instrucciones servidas desde la caché
+    uint64_t misses;              // Instrucciones decodificadas y guardadas en la caché
+    uint64_t invalidations;       // Entradas invalidadas por escrituras en memoria
+} Chip64CacheStats;
+
+// Etapa del pipeline de efectos gráficos
+typedef struct {
+    GraphicsEffects effect;       // Tipo de etapa
+    uint16_t timer;               // Frames dentro del ciclo del efecto
+} Chip64EffectStage;
+
+// Pipeline de efectos: las etapas se aplican en orden y se fusionan en una
+// sola pasada sobre gfx2Buffer. El coste solo se mide para la pasada entera:
+// fusionada, el trabajo por píxel de una etapa no se puede separar del resto
 typedef struct {
+    Chip64EffectStage stages[MAX_EFFECT_STAGES];
+    uint8_t count;                // Etapas activas
+    uint32_t frames;              // Frames procesados
+    uint64_t composeLastNs;       // Coste de la pasada fusionada en el último frame (ns)
+    uint64_t composeTotalNs;      // Coste acumulado de la pasada fusionada (ns)
+} Chip64EffectPipeline;
+
+struct Chip64 {
     uint16_t opcode;              // Opcode actual
     uint16_t SP;                  // Stack Pointer
     uint16_t PC;                  // Program Counter
@@ -37,8 +95,8 @@ typedef struct {
 
     uint64_t I;                   // Registro índice
 
-    uint8_t gfx[DISPLAY_WIDTH * DISPLAY_HEIGHT];         // Framebuffer principal
-    uint8_t gfx2Buffer[DISPLAY_WIDTH * DISPLAY_HEIGHT];  // Buffer para efectos
+    uint64_t gfxRows[DISPLAY_HEIGHT][DISPLAY_WIDTH / 64]; // Framebuffer principal empaquetado (bit 63 de [0] = columna 0)
+    uint8_t gfx2Buffer[DISPLAY_WIDTH * DISPLAY_HEIGHT];  // Salida de los efectos: intensidad 0-255 por píxel
     Color16 palette[MAX_COLORS];
 
     uint8_t delayTimer;           // Timer de retardo
@@ -47,13 +105,39 @@ typedef struct {
     
     uint8_t key[KEY_COUNT];       // Estado del teclado
     bool drawFlag;                // Bandera para indicar si hay que actualizar la pantalla
+    uint64_t dirtyRows;           // Filas modificadas desde el último render (bit y = fila y); lo limpia el renderizador
+    bool waitingKey;              // Detenido en FX0A hasta que se pulse una tecla
     Config64 config;                // Configuración del emulador
     EmuMode mode; 
 
-    GraphicsEffects currentEffect; // Efecto gráfico actual
-    uint8_t effectTimer; // Temporizador para efectos gráficos
+    Chip64EffectPipeline effects; // Efectos gráficos activos
     uint8_t colorIndex; // Índice del color actual en el ciclo de colores
-} Chip64;
+
+    // Caché de instrucciones predecodificadas, una entrada por dirección par
+    // (32768 entradas: la estructura ocupa ~600 KB, reservarla en heap o estática)
+    Chip64Instr icache[MEMORY_SIZE / 2];
+    Chip64CacheStats cacheStats;  // Estadísticas de la caché
+
+    // Núcleo del modo y resolución activos. Cambiar mode o config.highResMode
+    // solo a través de chip64SetMode/chip64SetHighResMode para mantenerlo al día
+    Chip64CycleFn cycleFn;
+    Chip64RunFn runFn;
+
+    // Estado de chip64Run
+    Chip64RunResult runEvent;     // Evento que detiene chip64Run (CHIP64_RUN_BUDGET = ninguno)
+    uint32_t runCycles;           // Instrucciones ejecutadas en la última llamada a chip64Run
+
+    uint32_t rngState;            // Estado del generador de CXKK, E003 y E004 (xorshift32, nunca 0)
+};
+
+/**
+ * @brief Tamaño máximo de un estado guardado
+ *
+ * Cabecera, registros y paleta más la memoria y la pantalla en el peor caso
+ * de la compresión (un byte de control por cada 128 literales).
+ */
+#define CHIP64_STATE_MAX_SIZE (512 + MEMORY_SIZE + MEMORY_SIZE / 128 + \
+                               DISPLAY_WIDTH * DISPLAY_HEIGHT / 8 + DISPLAY_WIDTH * DISPLAY_HEIGHT / 8 / 128)
 
 
 
@@ -85,6 +169,9 @@ bool chip64LoadROM(Chip64* chip64, const char* filename);
 /**
  * @brief Ejecuta un ciclo de instrucción (fetch-decode-execute)
  * 
+ * Delega en el núcleo especializado del modo activo (8, 16 o 64 bits, con
+ * la resolución ya resuelta), que no comprueba el modo en cada instrucción.
+ * 
  * Todas las instrucciones están adaptadas para:
  * - Trabajar con registros de 64 bits (con máscaras según modo)
  * - Acceder a 64KB de memoria
@@ -96,10 +183,101 @@ bool chip64LoadROM(Chip64* chip64, const char* filename);
  */
 void chip64Cycle(Chip64* chip64);
 
+/**
+ * @brief Ejecuta instrucciones hasta agotar el presupuesto o hasta un evento
+ * 
+ * El bucle interno usa el núcleo especializado del modo activo, de modo que el
+ * anfitrión hace una llamada por lote en vez de una por instrucción. Se detiene
+ * tras la instrucción que:
+ * - Modifica la pantalla (CHIP64_RUN_DRAW)
+ * - Espera una tecla en FX0A (CHIP64_RUN_KEY_WAIT)
+ * - Escribe el delay o sound timer (CHIP64_RUN_TIMER_WRITE)
+ * - Es un opcode desconocido (CHIP64_RUN_UNKNOWN_OPCODE)
+ * 
+ * Mientras waitingKey esté activo (FX0A sin tecla) vuelve sin ejecutar nada
+ * y con CHIP64_RUN_KEY_WAIT; chip64SetKey lo desactiva al pulsar una tecla.
+ * 
+ * @param chip64 Puntero a la estructura del emulador
+ * @param maxCycles Máximo de instrucciones a ejecutar
+ * @return Motivo de la parada; chip64->runCycles guarda las instrucciones ejecutadas
+ */
+Chip64RunResult chip64Run(Chip64* chip64, uint32_t maxCycles);
+
+/**
+ * @brief Invalida toda la caché de instrucciones predecodificadas
+ * 
+ * Las escrituras hechas por el propio núcleo (FX33, FX55, B001) ya invalidan
+ * las entradas afectadas. Esta función es necesaria solo cuando la memoria se
+ * modifica desde fuera (carga de ROM, restauración de estado...).
+ * 
+ * @param chip64 Puntero a la estructura del emulador
+ */
+void chip64FlushCache(Chip64* chip64);
+
+/**
+ * @brief Siembra el generador pseudoaleatorio de CXKK, E003 y E004
+ * 
+ * chip64Init lo siembra con la hora. El generador forma parte del estado
+ * guardado, así que un estado restaurado produce los mismos números.
+ * 
+ * @param chip64 Puntero a la estructura del emulador
+ * @param seed Semilla
+ */
+void chip64Seed(Chip64* chip64, uint32_t seed);
+
+/**
+ * @brief Guarda el estado de la máquina en un buffer
+ * 
+ * Formato binario versionado: registros, pila, temporizadores, modo, paleta
+ * y efectos, más la memoria y la pantalla comprimidas por rachas de ceros.
+ * No incluye Config salvo highResMode y colorMode. Es lo bastante rápido
+ * para llamarlo en cada frame.
+ * 
+ * @param chip64 Puntero a la estructura del emulador
+ * @param buffer Buffer de destino (CHIP64_STATE_MAX_SIZE bytes bastan siempre)
+ * @param size Tamaño del buffer
+ * @return Bytes escritos, o 0 si no caben
+ */
+size_t chip64SaveState(const Chip64* chip64, uint8_t* buffer, size_t size);
+
+/**
+ * @brief Restaura un estado guardado con chip64SaveState
+ * 
+ * Selecciona el núcleo del modo guardado e invalida las entradas de la caché
+ * de instrucciones cuya memoria cambia.
+ * Si los datos no son válidos el emulador no cambia. No usa memoria
+ * estática: se puede llamar a la vez desde varios hilos con núcleos distintos.
+ * 
+ * @param chip64 Puntero a la estructura del emulador
+ * @param buffer Estado guardado
+ * @param size Tamaño del estado
+ * @return true si se restauró, false si el estado no es válido
+ */
+bool chip64LoadState(Chip64* chip64, const uint8_t* buffer, size_t size);
+
+/**
+ * @brief Guarda el estado de la máquina en un archivo (ver chip64SaveState)
+ * 
+ * @param chip64 Puntero a la estructura del emulador
+ * @param filename Ruta del archivo
+ * @return true si se escribió completo
+ */
+bool chip64SaveStateFile(const Chip64* chip64, const char* filename);
+
+/**
+ * @brief Restaura un estado guardado en un archivo (ver chip64LoadState)
+ * 
+ * @param chip64 Puntero a la estructura del emulador
+ * @param filename Ruta del archivo
+ * @return true si se restauró
+ */
+bool chip64LoadStateFile(Chip64* chip64, const char* filename);
+
 /**
  * @brief Actualiza los temporizadores (delay y sound)
  * 
- * Debe llamarse a 60Hz para mantener el timing correcto.
+ * Debe llamarse a 60Hz para mantener el timing correcto. No emite sonido:
+ * como en chip-8 y chip-16, el frontend suena mientras soundTimer > 0.
  * 
  * @param chip64 Puntero a la estructura del emulador
  */
@@ -125,11 +303,25 @@ void chip64SetKey(Chip64* chip64, uint8_t key, uint8_t value);
  * - MODE_16BIT: Display 64×32, registros enmascaran a 16 bits
  * - MODE_64BIT: Display 128×64, registros usan 64 bits completos
  * 
+ * Selecciona el núcleo especializado del modo y vacía la caché de
+ * instrucciones si la variante cambia.
+ * 
  * @param chip64 Puntero a la estructura del emulador
  * @param mode Modo a establecer
  */
 void chip64SetMode(Chip64* chip64, EmuMode mode);
 
+/**
+ * @brief Activa/desactiva la alta resolución (128×64) en modo 64-bit
+ * 
+ * En los modos de 8 y 16 bits el display es siempre 64×32 y el valor solo
+ * se guarda en la configuración.
+ * 
+ * @param chip64 Puntero a la estructura del emulador
+ * @param enable true = 128×64, false = 64×32
+ */
+void chip64SetHighResMode(Chip64* chip64, bool enable);
+
 /**
  * @brief Activa/desactiva modo de color
  * 
@@ -147,35 +339,96 @@ void chip64SetColorMode(Chip64* chip64, bool enable);
 void chip64SetPalette(Chip64* chip64, const Color16* newPalette);
 
 /**
- * @brief Establece el efecto gráfico activo
+ * @brief Establece un único efecto gráfico
  * 
- * Los efectos se procesan en el buffer secundario (gfx2Buffer).
- * Esto permite mantener el framebuffer primario intacto.
+ * Vacía el pipeline de efectos y, salvo con EFFECT_NONE, deja solo la etapa
+ * indicada. Para combinar varios efectos, añadir las demás con chip64AddEffect.
  * 
  * Efectos disponibles:
  * - EFFECT_NONE: Sin efectos
- * - EFFECT_COLOR_CYCLE: Cicla a través de COLOR_PALETTE_RGBA
- * - EFFECT_FADE: Fade in/out (futuro)
- * - EFFECT_SHAKE: Screen shake (futuro)
+ * - EFFECT_COLOR_CYCLE: Cicla a través de COLOR_PALETTE (solo paleta)
+ * - EFFECT_FADE: Fundido a negro y vuelta cada 2 × FADE_FRAMES frames
+ * - EFFECT_SHAKE: Temblor de ±SHAKE_AMPLITUDE píxeles
+ * - EFFECT_SCANLINES: Filas impares atenuadas a SCANLINE_LEVEL
  * 
  * @param chip64 Puntero a la estructura del emulador
  * @param effect Tipo de efecto a activar
  */
 void chip64SetEffect(Chip64* chip64, GraphicsEffects effect);
 
+/**
+ * @brief Añade una etapa al final del pipeline de efectos
+ * 
+ * Las etapas se ejecutan en el orden en que se añaden. Un mismo efecto no
+ * puede aparecer dos veces.
+ * 
+ * @param chip64 Puntero a la estructura del emulador
+ * @param effect Efecto a añadir (distinto de EFFECT_NONE)
+ * @return true si se añadió; false si ya estaba, es EFFECT_NONE o el
+ *         pipeline tiene MAX_EFFECT_STAGES etapas
+ */
+bool chip64AddEffect(Chip64* chip64, GraphicsEffects effect);
+
 /**
  * @brief Procesa los efectos gráficos activos
  * 
- * Esta función:
- * 1. Copia gfx → gfx2Buffer
- * 2. Aplica el efecto actual sobre gfx2Buffer
- * 3. El renderizador luego usa gfx2Buffer para mostrar
+ * Avanza cada etapa un frame y, si alguna modifica píxeles, compone la imagen
+ * en gfx2Buffer en una sola pasada. Cada etapa solo calcula parámetros por
+ * fila (fila de origen, desplazamiento horizontal, intensidad); la pasada
+ * fusionada los aplica todos a la vez.
+ * 
+ * Los efectos de paleta (EFFECT_COLOR_CYCLE) no tocan el framebuffer: el
+ * renderizador aplica el color al expandir gfxRows.
  * 
- * Debe llamarse antes de renderizar si hay efectos activos.
+ * El coste de la pasada fusionada en el frame queda en effects.composeLastNs.
+ * No hay coste por etapa: cada una solo prepara parámetros por fila y todo el
+ * trabajo por píxel ocurre en la pasada común. Para ver lo que añade una
+ * etapa hay que comparar composeLastNs con y sin ella.
+ * 
+ * Debe llamarse una vez por frame antes de renderizar.
  * 
  * @param chip64 Puntero a la estructura del emulador
+ * @return true si gfx2Buffer contiene la imagen a mostrar (intensidad 0-255
+ *         por píxel, en la zona visible); false si el renderizador debe leer
+ *         gfxRows (chip64GetFramebuffer)
+ */
+bool chip64ProcessEffects(Chip64* chip64);
+
+/**
+ * @brief Nombre legible de un efecto gráfico
+ * 
+ * @param effect Efecto
+ * @return Cadena estática con el nombre
  */
-void chip64ProcessEffects(Chip64* chip64);
+const char* chip64EffectName(GraphicsEffects effect);
+/**
+ * @brief Devuelve un píxel del framebuffer empaquetado
+ * 
+ * Vista de compatibilidad para los consumidores que trabajaban con el antiguo
+ * gfx[] de un byte por píxel.
+ * 
+ * @param chip64 Puntero a la estructura del emulador
+ * @param x Columna (0-127)
+ * @param y Fila (0-63)
+ * @return 1 si el píxel está encendido, 0 si no
+ */
+static inline uint8_t chip64GetPixel(const Chip64* chip64, int x, int y)
+{
+    return (chip64->gfxRows[y][x >> 6] >> (63 - (x & 63))) & 1;
+}
+
+/**
+ * @brief Expande el framebuffer a un byte por píxel
+ * 
+ * Escribe DISPLAY_WIDTH × DISPLAY_HEIGHT bytes con índice x + y * DISPLAY_WIDTH,
+ * el formato del antiguo gfx[]. En los modos de 64×32 solo la esquina superior
+ * izquierda contiene datos.
+ * 
+ * @param chip64 Puntero a la estructura del emulador
+ * @param out Buffer de destino (DISPLAY_WIDTH * DISPLAY_HEIGHT bytes)
+ */
+void chip64GetFramebuffer(const Chip64* chip64, uint8_t* out);
+
 /**
  * @brief Obtiene información de estado del emulador
  * 
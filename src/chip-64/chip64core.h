@@ -0,0 +1,688 @@
+// Plantilla del núcleo de ejecución CHIP-64
+//
+// NO es una cabecera normal: chip64.c la incluye una vez por cada variante
+// (8-bit, 16-bit, 64-bit a 64×32 y 64-bit a 128×64) tras definir:
+//
+//   CORE_SUFFIX   Sufijo de los nombres generados (opMul8, chip64Cycle64Hi...)
+//   CORE_BITS     Ancho de los registros en bits (8, 16 o 64)
+//   CORE_UINT     Tipo entero del ancho del modo
+//   CORE_MASK     Máscara del modo (0xFF, 0xFFFF o 0xFFFFFFFFFFFFFFFF)
+//   CORE_WIDTH    Ancho efectivo del display
+//   CORE_HEIGHT   Alto efectivo del display
+//
+// Solo se generan los manejadores que dependen del modo, el decodificador, el
+// ciclo y el bucle de chip64Run; el resto de manejadores se comparten entre
+// variantes. Como todos los parámetros son constantes, el bucle caliente no
+// contiene comprobaciones de modo ni aritmética de 128 bits en los modos de 8
+// y 16 bits.
+
+#define CORE_CAT_(name, suffix) name##suffix
+#define CORE_CAT(name, suffix) CORE_CAT_(name, suffix)
+#define CORE_FN(name) CORE_CAT(name, CORE_SUFFIX)
+
+#define CORE_BYTES (CORE_BITS / 8)                               // Bytes por registro en memoria
+#define CORE_BCD_DIGITS (CORE_BITS == 8 ? 3 : CORE_BITS == 16 ? 5 : 20) // Dígitos de FX33
+
+// Fila de pantalla empaquetada del ancho del modo, con la columna 0 en el bit
+// alto: en 64×32 es la primera palabra de gfxRows[y]; en 128×64, las dos
+#if CORE_WIDTH == 64
+#define CORE_ROW uint64_t
+#else
+#define CORE_ROW __uint128_t
+#endif
+
+static inline CORE_ROW CORE_FN(loadRow)(const Chip64 *chip64, uint64_t y)
+{
+#if CORE_WIDTH == 64
+    return chip64->gfxRows[y][0];
+#else
+    return ((__uint128_t)chip64->gfxRows[y][0] << 64) | chip64->gfxRows[y][1];
+#endif
+}
+
+// Guardar una fila y marcarla como modificada para el renderizador
+static inline void CORE_FN(storeRow)(Chip64 *chip64, uint64_t y, CORE_ROW row)
+{
+    chip64->dirtyRows |= 1ULL << y;
+#if CORE_WIDTH == 64
+    chip64->gfxRows[y][0] = row;
+#else
+    chip64->gfxRows[y][0] = (uint64_t)(row >> 64);
+    chip64->gfxRows[y][1] = (uint64_t)row;
+#endif
+}
+
+// XOR de una fila de sprite de `bits` columnas (bits bajos de data) en la
+// columna xPos de la fila y. El wrap horizontal es una rotación de la fila.
+// Devuelve true si algún píxel encendido se apagó (colisión)
+static inline bool CORE_FN(blitRow)(Chip64 *chip64, uint64_t xPos, uint64_t y,
+                                    uint64_t data, int bits)
+{
+    CORE_ROW sprite = (CORE_ROW)data << (CORE_WIDTH - bits);
+    sprite = (sprite >> xPos) | (sprite << ((CORE_WIDTH - xPos) % CORE_WIDTH));
+
+    CORE_ROW row = CORE_FN(loadRow)(chip64, y);
+    CORE_FN(storeRow)(chip64, y, row ^ sprite);
+    return (row & sprite) != 0;
+}
+
+// 4XKK: Saltar siguiente instrucción si VX != KK
+static void CORE_FN(opSneVxByte)(Chip64 *chip64, const Chip64Instr *ins)
+{
+    if ((chip64->V[ins->x] & CORE_MASK) != ins->kk)
+    {
+        chip64->PC += 2;
+    }
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("SNE V%X, 0x%02X\n", ins->x, ins->kk);
+    }
+}
+
+// 5XY1: MUL Vx, Vy - Multiplicación
+static void CORE_FN(opMul)(Chip64 *chip64, const Chip64Instr *ins)
+{
+#if CORE_BITS == 64
+    __uint128_t result = (__uint128_t)chip64->V[ins->x] * (__uint128_t)chip64->V[ins->y];
+    chip64->V[ins->x] = (uint64_t)result;
+    chip64->V[REG_VF] = (result > CORE_MASK) ? 1 : 0;
+#else
+    // Desbordamiento = el producto no cabe en 64 bits o supera la máscara
+    uint64_t result;
+    bool overflow = __builtin_mul_overflow(chip64->V[ins->x], chip64->V[ins->y], &result);
+    chip64->V[ins->x] = result & CORE_MASK;
+    chip64->V[REG_VF] = (overflow || result > CORE_MASK) ? 1 : 0;
+#endif
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("MUL V%X, V%X (overflow=%d)\n", ins->x, ins->y, (int)chip64->V[REG_VF]);
+    }
+}
+
+// 5XY2: DIV Vx, Vy - División
+static void CORE_FN(opDiv)(Chip64 *chip64, const Chip64Instr *ins)
+{
+    if (chip64->V[ins->y] != 0)
+    {
+        chip64->V[REG_VF] = chip64->V[ins->x] % chip64->V[ins->y]; // Resto
+        chip64->V[ins->x] = chip64->V[ins->x] / chip64->V[ins->y]; // Cociente
+    }
+    else
+    {
+        chip64->V[ins->x] = CORE_MASK; // División por cero - ERROR
+        chip64->V[REG_VF] = 0;
+    }
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("DIV V%X, V%X (resto=V%X)\n", ins->x, ins->y, REG_VF);
+    }
+}
+
+// 5XY3: VADD Vx, Vy - Suma vectorial 2D
+static void CORE_FN(opVadd)(Chip64 *chip64, const Chip64Instr *ins)
+{
+    uint8_t nextX = (ins->x + 1) % REGISTER_COUNT;
+    uint8_t nextY = (ins->y + 1) % REGISTER_COUNT;
+    chip64->V[ins->x] = (chip64->V[ins->x] + chip64->V[ins->y]) & CORE_MASK;
+    chip64->V[nextX] = (chip64->V[nextX] + chip64->V[nextY]) & CORE_MASK;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("VADD V%X, V%X (2D vector)\n", ins->x, ins->y);
+    }
+}
+
+// 5XY4: DOT Vx, Vy - Producto escalar 2D
+static void CORE_FN(opDot)(Chip64 *chip64, const Chip64Instr *ins)
+{
+    uint8_t nextX = (ins->x + 1) % REGISTER_COUNT;
+    uint8_t nextY = (ins->y + 1) % REGISTER_COUNT;
+#if CORE_BITS == 64
+    __uint128_t product = (__uint128_t)chip64->V[ins->x] * (__uint128_t)chip64->V[ins->y] +
+                          (__uint128_t)chip64->V[nextX] * (__uint128_t)chip64->V[nextY];
+    chip64->V[ins->x] = (uint64_t)product;
+    chip64->V[REG_VF] = (uint64_t)(product >> 64);
+#else
+    uint64_t hi1, hi2;
+    uint64_t lo1 = mulWide(chip64->V[ins->x], chip64->V[ins->y], &hi1);
+    uint64_t lo2 = mulWide(chip64->V[nextX], chip64->V[nextY], &hi2);
+    uint64_t lo = lo1 + lo2;
+    uint64_t hi = hi1 + hi2 + (lo < lo1);
+    chip64->V[ins->x] = lo & CORE_MASK;
+    chip64->V[REG_VF] = hi & CORE_MASK;
+#endif
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("DOT V%X, V%X (2D scalar product)\n", ins->x, ins->y);
+    }
+}
+
+// 7XKK: ADD Vx, KK --> VX = VX + KK
+static void CORE_FN(opAddVxByte)(Chip64 *chip64, const Chip64Instr *ins)
+{
+    chip64->V[ins->x] = (chip64->V[ins->x] + ins->kk) & CORE_MASK;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("ADD V%X, 0x%02X\n", ins->x, ins->kk);
+    }
+}
+
+// 8XY4: ADD Vx, Vy --> VX = VX + VY, VF = carry
+static void CORE_FN(opAddVxVy)(Chip64 *chip64, const Chip64Instr *ins)
+{
+    // Acarreo = la suma desborda 64 bits o supera la máscara del modo
+    uint64_t result = chip64->V[ins->x] + chip64->V[ins->y];
+    chip64->V[REG_VF] = (result < chip64->V[ins->x] || result > CORE_MASK) ? 1 : 0;
+    chip64->V[ins->x] = result & CORE_MASK;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("ADD V%X, V%X (carry=%d)\n", ins->x, ins->y, (int)chip64->V[REG_VF]);
+    }
+}
+
+// 8XY5: SUB Vx, Vy --> VX = VX - VY, VF = NOT borrow
+static void CORE_FN(opSub)(Chip64 *chip64, const Chip64Instr *ins)
+{
+    chip64->V[REG_VF] = (chip64->V[ins->x] >= chip64->V[ins->y]) ? 1 : 0;
+    chip64->V[ins->x] = (chip64->V[ins->x] - chip64->V[ins->y]) & CORE_MASK;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("SUB V%X, V%X (NOT borrow=%d)\n", ins->x, ins->y, (int)chip64->V[REG_VF]);
+    }
+}
+
+// 8XY7: SUBN Vx, Vy --> VX = VY - VX, VF = NOT borrow
+static void CORE_FN(opSubn)(Chip64 *chip64, const Chip64Instr *ins)
+{
+    chip64->V[REG_VF] = (chip64->V[ins->y] >= chip64->V[ins->x]) ? 1 : 0;
+    chip64->V[ins->x] = (chip64->V[ins->y] - chip64->V[ins->x]) & CORE_MASK;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("SUBN V%X, V%X (NOT borrow=%d)\n", ins->x, ins->y, (int)chip64->V[REG_VF]);
+    }
+}
+
+// 8XYE: SHL Vx {, Vy} --> VX = VX << 1, VF = MSB before shift
+static void CORE_FN(opShl)(Chip64 *chip64, const Chip64Instr *ins)
+{
+    chip64->V[REG_VF] = (chip64->V[ins->x] >> (CORE_BITS - 1)) & 0x1;
+    chip64->V[ins->x] = (chip64->V[ins->x] << 1) & CORE_MASK;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("SHL V%X (MSB=%d)\n", ins->x, (int)chip64->V[REG_VF]);
+    }
+}
+
+// 9XY1: ROR Vx {, Vy} --> Rotar VX a la derecha
+static void CORE_FN(opRor)(Chip64 *chip64, const Chip64Instr *ins)
+{
+    uint64_t value = chip64->V[ins->x];
+    uint8_t shift = chip64->V[ins->y] & 0x3F;
+    chip64->V[ins->x] = ((value >> shift) | (value << (CORE_BITS - shift))) & CORE_MASK;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("ROR V%X, V%X (%d bits)\n", ins->x, ins->y, shift);
+    }
+}
+
+// 9XY2: ROL Vx {, Vy} --> Rotar VX a la izquierda
+static void CORE_FN(opRol)(Chip64 *chip64, const Chip64Instr *ins)
+{
+    uint64_t value = chip64->V[ins->x];
+    uint8_t shift = chip64->V[ins->y] & 0x3F;
+    chip64->V[ins->x] = ((value << shift) | (value >> (CORE_BITS - shift))) & CORE_MASK;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("ROL V%X, V%X (%d bits)\n", ins->x, ins->y, shift);
+    }
+}
+
+// 9XY3: POPCNT Vx --> Contar bits activos en VX
+static void CORE_FN(opPopcnt)(Chip64 *chip64, const Chip64Instr *ins)
+{
+    uint64_t count = __builtin_popcountll(chip64->V[ins->x] & CORE_MASK);
+    chip64->V[ins->x] = count;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("POPCNT V%X = %llu\n", ins->x, (unsigned long long)count);
+    }
+}
+
+// B002: MEMSRCH - Buscar valor en memoria
+static void CORE_FN(opMemsrch)(Chip64 *chip64, const Chip64Instr *ins)
+{
+    uint64_t value = chip64->V[ins->x];
+    uint64_t memValue;
+    bool found = false;
+
+    for (int i = 0; i < 256 && (chip64->I + i + CORE_BYTES - 1) < MEMORY_SIZE;
+         i += CORE_BYTES) {
+        memValue = 0;
+        for (int j = 0; j < CORE_BYTES; j++) {
+            memValue = (memValue << 8) | chip64->memory[chip64->I + i + j];
+        }
+
+        if (memValue == value) {
+            chip64->V[REG_VF] = i / CORE_BYTES;
+            found = true;
+            break;
+        }
+    }
+
+    if (!found) {
+        chip64->V[REG_VF] = CORE_MASK;
+    }
+    if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+        printf("MEMSRCH V%X (found=%d)\n", ins->x, found);
+    }
+}
+
+// DXYN: DRW Vx, Vy, nibble --> Dibujar sprite en posición VX, VY con N bytes
+static void CORE_FN(opDrw)(Chip64 *chip64, const Chip64Instr *ins)
+{
+    uint64_t xPos = chip64->V[ins->x] % CORE_WIDTH;
+    uint64_t yPos = chip64->V[ins->y] % CORE_HEIGHT;
+    uint64_t height = ins->n;
+    bool collision = false;
+
+    for (uint16_t row = 0; row < height; row++) {
+        collision |= CORE_FN(blitRow)(chip64, xPos, (yPos + row) % CORE_HEIGHT,
+                                      chip64->memory[chip64->I + row], 8);
+    }
+    chip64->V[REG_VF] = collision;
+
+    chip64->drawFlag = true;
+    chip64->runEvent = CHIP64_RUN_DRAW;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+        printf("DRW V%X, V%X, %d (8×%d sprite)\n", ins->x, ins->y, ins->n, ins->n);
+    }
+}
+
+// FX01: DRAW16 - Dibujar sprite 16×16 (CHIP-16)
+static void CORE_FN(opDraw16)(Chip64 *chip64, const Chip64Instr *ins)
+{
+    (void)ins;
+    uint64_t xPos = chip64->V[2] % CORE_WIDTH;
+    uint64_t yPos = chip64->V[3] % CORE_HEIGHT;
+    uint64_t spriteData;
+    bool collision = false;
+
+    for (int row = 0; row < 16; row++) {
+        spriteData = (chip64->memory[chip64->I + row * 2] << 8) |
+                     chip64->memory[chip64->I + row * 2 + 1];
+        collision |= CORE_FN(blitRow)(chip64, xPos, (yPos + row) % CORE_HEIGHT, spriteData, 16);
+    }
+    chip64->V[REG_VF] = collision;
+
+    chip64->drawFlag = true;
+    chip64->runEvent = CHIP64_RUN_DRAW;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+        printf("DRAW16 at (%llu,%llu)\n",
+               (unsigned long long)xPos, (unsigned long long)yPos);
+    }
+}
+
+// FX02: HLINE - Línea horizontal (CHIP-16)
+static void CORE_FN(opHline)(Chip64 *chip64, const Chip64Instr *ins)
+{
+    (void)ins;
+    uint64_t xPos = chip64->V[2] % CORE_WIDTH;
+    uint64_t yPos = chip64->V[3] % CORE_HEIGHT;
+    uint64_t length = chip64->V[4];
+    uint64_t pattern = chip64->V[5];
+    CORE_ROW line = 0;
+    CORE_ROW mask;
+
+    if (length == 0 || length > CORE_WIDTH - xPos) {
+        length = CORE_WIDTH - xPos;
+    }
+
+    // Patrón de 16 bits repetido en toda la fila y desplazado hasta xPos; la
+    // línea no hace wrap, así que basta con recortarla a length columnas
+    for (int i = 0; i < CORE_WIDTH; i += 16) {
+        line = (line << 16) | (pattern & 0xFFFF);
+    }
+    line >>= xPos;
+    mask = (length == CORE_WIDTH) ? ~(CORE_ROW)0
+                                  : (((CORE_ROW)1 << length) - 1) << (CORE_WIDTH - xPos - length);
+    line &= mask;
+
+    CORE_ROW row = CORE_FN(loadRow)(chip64, yPos);
+    CORE_FN(storeRow)(chip64, yPos, row ^ line);
+    chip64->V[REG_VF] = (row & line) != 0;
+
+    chip64->drawFlag = true;
+    chip64->runEvent = CHIP64_RUN_DRAW;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+        printf("HLINE (%llu,%llu) len=%llu\n",
+               (unsigned long long)xPos, (unsigned long long)yPos,
+               (unsigned long long)length);
+    }
+}
+
+// FX03: VLINE - Línea vertical (CHIP-16)
+static void CORE_FN(opVline)(Chip64 *chip64, const Chip64Instr *ins)
+{
+    (void)ins;
+    uint64_t xPos = chip64->V[2] % CORE_WIDTH;
+    uint64_t yPos = chip64->V[3] % CORE_HEIGHT;
+    uint64_t height = chip64->V[4];
+    uint64_t pattern = chip64->V[5];
+    bool collision = false;
+
+    if (height == 0 || height > CORE_HEIGHT - yPos) {
+        height = CORE_HEIGHT - yPos;
+    }
+
+    for (uint64_t i = 0; i < height; i++) {
+        if ((pattern & (0x8000 >> (i % 16))) != 0) {
+            collision |= CORE_FN(blitRow)(chip64, xPos, (yPos + i) % CORE_HEIGHT, 1, 1);
+        }
+    }
+    chip64->V[REG_VF] = collision;
+
+    chip64->drawFlag = true;
+    chip64->runEvent = CHIP64_RUN_DRAW;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+        printf("VLINE (%llu,%llu) height=%llu\n",
+               (unsigned long long)xPos, (unsigned long long)yPos,
+               (unsigned long long)height);
+    }
+}
+
+// FX04: DRAW32 - Dibujar sprite 32×32 (CHIP-64)
+static void CORE_FN(opDraw32)(Chip64 *chip64, const Chip64Instr *ins)
+{
+    (void)ins;
+    uint64_t xPos = chip64->V[2] % CORE_WIDTH;
+    uint64_t yPos = chip64->V[3] % CORE_HEIGHT;
+    bool collision = false;
+
+    // Sprite 32×32 = 32 filas × 4 bytes por fila = 128 bytes
+    for (int row = 0; row < 32; row++) {
+        // Leer 4 bytes (32 bits) por fila
+        uint32_t spriteRow =
+            ((uint32_t)chip64->memory[chip64->I + row * 4] << 24) |
+            ((uint32_t)chip64->memory[chip64->I + row * 4 + 1] << 16) |
+            ((uint32_t)chip64->memory[chip64->I + row * 4 + 2] << 8) |
+            ((uint32_t)chip64->memory[chip64->I + row * 4 + 3]);
+
+        collision |= CORE_FN(blitRow)(chip64, xPos, (yPos + row) % CORE_HEIGHT, spriteRow, 32);
+    }
+    chip64->V[REG_VF] = collision;
+
+    chip64->drawFlag = true;
+    chip64->runEvent = CHIP64_RUN_DRAW;
+    if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+        printf("DRAW32 at (%llu,%llu) - 32×32 sprite [CHIP-64]\n",
+               (unsigned long long)xPos, (unsigned long long)yPos);
+    }
+}
+
+// FX33: LD B, Vx - Almacenar BCD (3, 5 o 20 dígitos según el modo)
+static void CORE_FN(opLdBVx)(Chip64 *chip64, const Chip64Instr *ins)
+{
+    CORE_UINT val = chip64->V[ins->x] & CORE_MASK;
+    for (int i = CORE_BCD_DIGITS - 1; i >= 0; i--) {
+        chip64->memory[chip64->I + i] = val % 10;
+        val /= 10;
+    }
+    chip64InvalidateCode(chip64, chip64->I, CORE_BCD_DIGITS);
+    if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+        printf("LD B, V%X (BCD at I=0x%04llX)\n", ins->x, (unsigned long long)chip64->I);
+    }
+}
+
+// FX55: LD [I], Vx - Guardar registros (big-endian, CORE_BYTES por registro)
+static void CORE_FN(opLdIVx)(Chip64 *chip64, const Chip64Instr *ins)
+{
+    for (int i = 0; i <= ins->x; i++) {
+        for (int j = 0; j < CORE_BYTES; j++) {
+            chip64->memory[chip64->I + (i * CORE_BYTES) + j] =
+                (chip64->V[i] >> ((CORE_BYTES - 1 - j) * 8)) & 0xFF;
+        }
+    }
+    chip64InvalidateCode(chip64, chip64->I, (ins->x + 1) * CORE_BYTES);
+    if (CORE_BYTES > 1) {
+        chip64->I += (ins->x + 1) * CORE_BYTES;
+    }
+    if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+        printf("LD [I], V%X (saved V0-V%X)\n", ins->x, ins->x);
+    }
+}
+
+// FX65: LD Vx, [I] - Cargar registros (big-endian, CORE_BYTES por registro)
+static void CORE_FN(opLdVxI)(Chip64 *chip64, const Chip64Instr *ins)
+{
+    for (int i = 0; i <= ins->x; i++) {
+        uint64_t value = 0;
+        for (int j = 0; j < CORE_BYTES; j++) {
+            value = (value << 8) | chip64->memory[chip64->I + (i * CORE_BYTES) + j];
+        }
+        chip64->V[i] = value;
+    }
+    if (CORE_BYTES > 1) {
+        chip64->I += (ins->x + 1) * CORE_BYTES;
+    }
+    if (chip64->config.debugLevel >= DEBUG_OPCODES) {
+        printf("LD V%X, [I] (loaded V0-V%X)\n", ins->x, ins->x);
+    }
+}
+
+/**
+ * @brief Decodifica un opcode para esta variante del núcleo
+ *
+ * Cada dirección par de memoria tiene una entrada en chip64->icache con la
+ * instrucción ya decodificada. La entrada solo se invalida cuando una
+ * escritura en memoria (FX33, FX55, B001) la alcanza o al cambiar de
+ * variante, así que una ROM que no se modifica a sí misma nunca decodifica
+ * dos veces la misma instrucción.
+ */
+static void CORE_FN(chip64Decode)(uint16_t opcode, Chip64Instr *ins)
+{
+    uint8_t n = opcode & 0x000F;
+    uint8_t kk = opcode & 0x00FF;
+    Chip64Handler handler = opNop;
+
+    switch (opcode & 0xF000)
+    {
+    case 0x0000:
+        switch (kk)
+        {
+        case 0xE0: handler = opCls; break;
+        case 0xEE: handler = opRet; break;
+        default:   handler = opUnknown; break;
+        }
+        break;
+
+    case 0x1000: handler = opJp; break;
+    case 0x2000: handler = opCall; break;
+    case 0x3000: handler = opSeVxByte; break;
+    case 0x4000: handler = CORE_FN(opSneVxByte); break;
+
+    case 0x5000:
+        switch (n)
+        {
+        case 0x0: handler = opSeVxVy; break;
+        case 0x1: handler = CORE_FN(opMul); break;
+        case 0x2: handler = CORE_FN(opDiv); break;
+        case 0x3: handler = CORE_FN(opVadd); break;
+        case 0x4: handler = CORE_FN(opDot); break;
+        }
+        break;
+
+    case 0x6000: handler = opLdVxByte; break;
+    case 0x7000: handler = CORE_FN(opAddVxByte); break;
+
+    case 0x8000:
+        switch (n)
+        {
+        case 0x0: handler = opLdVxVy; break;
+        case 0x1: handler = opOr; break;
+        case 0x2: handler = opAnd; break;
+        case 0x3: handler = opXor; break;
+        case 0x4: handler = CORE_FN(opAddVxVy); break;
+        case 0x5: handler = CORE_FN(opSub); break;
+        case 0x6: handler = opShr; break;
+        case 0x7: handler = CORE_FN(opSubn); break;
+        case 0xE: handler = CORE_FN(opShl); break;
+        }
+        break;
+
+    case 0x9000:
+        switch (n)
+        {
+        case 0x0: handler = opSneVxVy; break;
+        case 0x1: handler = CORE_FN(opRor); break;
+        case 0x2: handler = CORE_FN(opRol); break;
+        case 0x3: handler = CORE_FN(opPopcnt); break;
+        }
+        break;
+
+    case 0xA000: handler = opLdI; break;
+
+    case 0xB000:
+        switch (n)
+        {
+        case 0x0: handler = opJpV0; break;
+        case 0x1: handler = opMemcpy; break;
+        case 0x2: handler = CORE_FN(opMemsrch); break;
+        }
+        break;
+
+    case 0xC000: handler = opRnd; break;
+    case 0xD000: handler = CORE_FN(opDrw); break;
+
+    case 0xE000:
+        switch (kk)
+        {
+        case 0x01: handler = opCallp; break;
+        case 0x02: handler = opRetv; break;
+        case 0x03: handler = opRnd16; break;
+        case 0x04: handler = opRndr; break;
+        case 0x9E: handler = opSkp; break;
+        case 0xA1: handler = opSknp; break;
+        }
+        break;
+
+    case 0xF000:
+        switch (kk)
+        {
+        case 0x01: handler = CORE_FN(opDraw16); break;
+        case 0x02: handler = CORE_FN(opHline); break;
+        case 0x03: handler = CORE_FN(opVline); break;
+        case 0x04: handler = CORE_FN(opDraw32); break;
+        case 0x07: handler = opLdVxDt; break;
+        case 0x0A: handler = opLdVxK; break;
+        case 0x15: handler = opLdDtVx; break;
+        case 0x18: handler = opLdStVx; break;
+        case 0x1E: handler = opAddIVx; break;
+        case 0x29: handler = opLdFVx; break;
+        case 0x33: handler = CORE_FN(opLdBVx); break;
+        case 0x55: handler = CORE_FN(opLdIVx); break;
+        case 0x65: handler = CORE_FN(opLdVxI); break;
+        }
+        break;
+    }
+
+    ins->handler = handler;
+    ins->opcode = opcode;
+    ins->x = (opcode & 0x0F00) >> 8;
+    ins->y = (opcode & 0x00F0) >> 4;
+    ins->n = n;
+    ins->kk = kk;
+    ins->nnn = opcode & 0x0FFF;
+}
+
+// Ejecutar una instrucción con esta variante del núcleo
+static inline void CORE_FN(chip64Step)(Chip64 *chip64)
+{
+    Chip64Instr decoded;
+    const Chip64Instr *ins;
+    uint16_t pc = chip64->PC;
+
+    if ((pc & 1) == 0)
+    {
+        // Dirección par: servir la instrucción desde la caché predecodificada
+        Chip64Instr *entry = &chip64->icache[pc >> 1];
+
+        if (entry->handler != NULL)
+        {
+            chip64->cacheStats.hits++;
+        }
+        else
+        {
+            CORE_FN(chip64Decode)((chip64->memory[pc] << 8) | chip64->memory[pc + 1], entry);
+            chip64->cacheStats.misses++;
+        }
+        ins = entry;
+    }
+    else
+    {
+        // Dirección impar: decodificar sin pasar por la caché
+        CORE_FN(chip64Decode)((chip64->memory[pc] << 8) | chip64->memory[pc + 1], &decoded);
+        ins = &decoded;
+    }
+
+    chip64->opcode = ins->opcode;
+
+    // Incrementar PC antes de ejecutar
+    chip64->PC += 2;
+
+    // Depuración si está habilitada
+    if (chip64->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("Ejecutando opcode: 0x%04X en PC=0x%04X\n", chip64->opcode, chip64->PC - 2);
+    }
+
+    ins->handler(chip64, ins);
+}
+
+// Ejecutar un ciclo de emulación con esta variante del núcleo
+static void CORE_FN(chip64Cycle)(Chip64 *chip64)
+{
+    CORE_FN(chip64Step)(chip64);
+}
+
+// Ejecutar hasta maxCycles instrucciones o hasta que un manejador señale un
+// evento; el paso se inserta en el bucle, sin llamada indirecta por ciclo
+static Chip64RunResult CORE_FN(chip64Run)(Chip64 *chip64, uint32_t maxCycles)
+{
+    uint32_t cycles = 0;
+
+    // Detenido en FX0A: no hay nada que ejecutar hasta que llegue una tecla
+    if (chip64->waitingKey)
+    {
+        chip64->runCycles = 0;
+        chip64->runEvent = CHIP64_RUN_KEY_WAIT;
+        return CHIP64_RUN_KEY_WAIT;
+    }
+
+    chip64->runEvent = CHIP64_RUN_BUDGET;
+    while (cycles < maxCycles)
+    {
+        CORE_FN(chip64Step)(chip64);
+        cycles++;
+
+        if (chip64->runEvent != CHIP64_RUN_BUDGET)
+        {
+            break;
+        }
+    }
+
+    chip64->runCycles = cycles;
+    return chip64->runEvent;
+}
+
+#undef CORE_ROW
+#undef CORE_BCD_DIGITS
+#undef CORE_BYTES
+#undef CORE_FN
+#undef CORE_CAT
+#undef CORE_CAT_
+
+#undef CORE_SUFFIX
+#undef CORE_BITS
+#undef CORE_UINT
+#undef CORE_MASK
+#undef CORE_WIDTH
+#undef CORE_HEIGHT
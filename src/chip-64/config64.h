@@ -30,7 +30,7 @@
 #define DEFAULT_PIXEL_COLOR 0x00FF00FF  // Magenta
 
 // -- Tiempos y velocidad --
-#define DEFAULT_SPEED 5  // Retardo en milisegundos entre instrucciones
+#define DEFAULT_SPEED 700  // Instrucciones por segundo (config.clockSpeed)
 #define TIMER_FREQ 60    // Frecuencia de actualización de timers (60Hz)
 
 // -- Sprites --
@@ -54,11 +54,18 @@ typedef enum {
 } EmuMode;
 
 // -- Efectos gráficos --
+// Cada valor (salvo EFFECT_NONE) es una etapa que puede combinarse con las
+// demás en el pipeline de efectos (chip64AddEffect)
 typedef enum{
     EFFECT_NONE = 0,
-    EFFECT_COLOR_CYCLE = 1
+    EFFECT_COLOR_CYCLE = 1, // Cicla el color de los píxeles (solo paleta)
+    EFFECT_FADE = 2,        // Fundido a negro y vuelta
+    EFFECT_SHAKE = 3,       // Temblor de pantalla
+    EFFECT_SCANLINES = 4    // Atenúa las filas impares, como un monitor CRT
 } GraphicsEffects;
 
+#define MAX_EFFECT_STAGES 4  // Etapas simultáneas en el pipeline de efectos
+
 
 // Formato RGB565: 5 bits Rojo, 6 bits Verde, 5 bits Azul
 // Compatible con displays TFT como ILI9341
@@ -101,10 +108,20 @@ static const uint32_t COLOR_PALETTE[COLOR_PALETTE_SIZE] = {
 // Frames para cambiar de color (a 60 Hz)
 #define COLOR_CYCLE_FRAMES 10
 
+// Frames de cada mitad del fundido (a negro y de vuelta)
+#define FADE_FRAMES 60
+
+// Desplazamiento máximo del temblor en píxeles y frames de su secuencia
+#define SHAKE_AMPLITUDE 2
+#define SHAKE_FRAMES 8
+
+// Intensidad de las filas impares con scanlines (sobre 255)
+#define SCANLINE_LEVEL 160
+
 // Configuración global
 typedef struct {
     DebugLevel debugLevel;   // Nivel de depuración activo
-    int clockSpeed;          // Velocidad del reloj (delay entre instrucciones)
+    int clockSpeed;          // Velocidad del reloj (instrucciones por segundo)
     bool enableSound;        // ¿Sonido habilitado?
     uint32_t pixelColor;     // Color de píxeles activos
     bool colorMode;       // Modo de color habilitado // true = 16 colores, false = monocromo
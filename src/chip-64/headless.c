@@ -0,0 +1,218 @@
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "chip64.h"
+
+// Ejecutor sin SDL: carga una ROM, la ejecuta a máxima velocidad durante N
+// ciclos o N frames e informa de instrucciones por segundo, frames por segundo
+// y un hash del framebuffer final. Pensado para medir el rendimiento en CI y
+// para servidores sin pantalla.
+
+#define HEADLESS_CYCLES_PER_FRAME 12  // ~700 instrucciones/s a 60 Hz, como main.c
+#define HEADLESS_DEFAULT_FRAMES 600   // 10 segundos de emulación
+#define HEADLESS_DEFAULT_SEED 1       // Semilla fija: el hash final es reproducible
+
+static void usage(const char* prog) {
+    printf("Uso: %s <archivo-rom> [opciones]\n", prog);
+    printf("  -c <n>     Ejecutar n ciclos\n");
+    printf("  -f <n>     Ejecutar n frames (por defecto %d)\n", HEADLESS_DEFAULT_FRAMES);
+    printf("  -r <n>     Instrucciones por frame (por defecto %d)\n", HEADLESS_CYCLES_PER_FRAME);
+    printf("  -m <bits>  Modo inicial: 8, 16 o 64 (128x64) (por defecto 8)\n");
+    printf("  -s <n>     Semilla de CXKK (por defecto %d)\n", HEADLESS_DEFAULT_SEED);
+    printf("  -p <pbm>   Guardar el framebuffer final como PBM\n");
+    printf("  -e <efecto> Añadir una etapa de efectos: color, fade, shake o scan (repetible)\n");
+}
+
+// Nombre de efecto de la línea de comandos → GraphicsEffects (EFFECT_NONE si no existe)
+static GraphicsEffects parseEffect(const char* name) {
+    if (strcmp(name, "color") == 0) return EFFECT_COLOR_CYCLE;
+    if (strcmp(name, "fade") == 0) return EFFECT_FADE;
+    if (strcmp(name, "shake") == 0) return EFFECT_SHAKE;
+    if (strcmp(name, "scan") == 0) return EFFECT_SCANLINES;
+    return EFFECT_NONE;
+}
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Hash FNV-1a de 64 bits de la pantalla (framebuffer completo de 128x64)
+static uint64_t hashFramebuffer(const Chip64* chip64) {
+    static uint8_t pixels[DISPLAY_WIDTH * DISPLAY_HEIGHT];
+    uint64_t hash = 0xCBF29CE484222325ULL;
+
+    // Sobre la vista de un byte por píxel: el valor no depende del empaquetado
+    chip64GetFramebuffer(chip64, pixels);
+    for (int i = 0; i < DISPLAY_WIDTH * DISPLAY_HEIGHT; i++) {
+        hash ^= pixels[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+// Guardar la zona visible de la pantalla como PBM binario (P4): 1 = píxel
+// con color distinto de 0. El framebuffer siempre tiene DISPLAY_WIDTH de ancho
+static bool writePBM(Chip64* chip64, const char* filename) {
+    FILE* file = fopen(filename, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "Error: No se pudo crear el archivo %s\n", filename);
+        return false;
+    }
+
+    int width = chip64GetDisplayWidth(chip64);
+    int height = chip64GetDisplayHeight(chip64);
+
+    fprintf(file, "P4\n%d %d\n", width, height);
+    for (int y = 0; y < height; y++) {
+        uint8_t row[(DISPLAY_WIDTH + 7) / 8] = {0};
+        for (int x = 0; x < width; x++) {
+            if (chip64GetPixel(chip64, x, y)) {
+                row[x >> 3] |= 0x80 >> (x & 7);
+            }
+        }
+        fwrite(row, 1, (width + 7) / 8, file);
+    }
+
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const char* romPath = argv[1];
+    const char* pbmPath = NULL;
+    uint64_t maxCycles = 0;
+    uint64_t maxFrames = HEADLESS_DEFAULT_FRAMES;
+    uint32_t cyclesPerFrame = HEADLESS_CYCLES_PER_FRAME;
+    unsigned int seed = HEADLESS_DEFAULT_SEED;
+    EmuMode mode = MODE_8BIT;
+    GraphicsEffects effects[MAX_EFFECT_STAGES];
+    int effectCount = 0;
+
+    for (int i = 2; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "-c") == 0 && hasValue) {
+            maxCycles = strtoull(argv[++i], NULL, 10);
+            maxFrames = 0;
+        } else if (strcmp(argv[i], "-f") == 0 && hasValue) {
+            maxFrames = strtoull(argv[++i], NULL, 10);
+            maxCycles = 0;
+        } else if (strcmp(argv[i], "-r") == 0 && hasValue) {
+            cyclesPerFrame = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-m") == 0 && hasValue) {
+            int bits = atoi(argv[++i]);
+            if (bits != 8 && bits != 16 && bits != 64) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            mode = bits == 8 ? MODE_8BIT : bits == 16 ? MODE_16BIT : MODE_64BIT;
+        } else if (strcmp(argv[i], "-s") == 0 && hasValue) {
+            seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-p") == 0 && hasValue) {
+            pbmPath = argv[++i];
+        } else if (strcmp(argv[i], "-e") == 0 && hasValue && effectCount < MAX_EFFECT_STAGES) {
+            effects[effectCount] = parseEffect(argv[++i]);
+            if (effects[effectCount] == EFFECT_NONE) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            effectCount++;
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (cyclesPerFrame == 0) {
+        fprintf(stderr, "Error: Se necesita al menos una instrucción por frame\n");
+        return EXIT_FAILURE;
+    }
+
+    // La estructura incluye la caché de instrucciones (~600 KB): fuera de la pila
+    static Chip64 chip64;
+    chip64Init(&chip64);
+    chip64Seed(&chip64, seed);  // chip64Init siembra con la hora
+    chip64SetMode(&chip64, mode);
+    if (!chip64LoadROM(&chip64, romPath)) {
+        return EXIT_FAILURE;
+    }
+    for (int i = 0; i < effectCount; i++) {
+        chip64AddEffect(&chip64, effects[i]);
+    }
+
+    // Con -c se ejecutan los frames necesarios para cubrir los ciclos pedidos
+    if (maxCycles > 0) {
+        maxFrames = (maxCycles + cyclesPerFrame - 1) / cyclesPerFrame;
+    }
+
+    uint64_t executed = 0;
+    uint64_t frames = 0;
+    double start = nowSeconds();
+
+    while (frames < maxFrames) {
+        uint32_t budget = cyclesPerFrame;
+        if (maxCycles > 0 && maxCycles - frames * cyclesPerFrame < budget) {
+            budget = (uint32_t)(maxCycles - frames * cyclesPerFrame);
+        }
+
+        // Sin teclado nadie despierta a FX0A: el frame termina ahí
+        while (budget > 0) {
+            Chip64RunResult result = chip64Run(&chip64, budget);
+            executed += chip64.runCycles;
+            budget -= chip64.runCycles;
+            if (result == CHIP64_RUN_KEY_WAIT) {
+                break;
+            }
+        }
+
+        chip64UpdateTimers(&chip64);
+        // Los efectos se procesan una vez por frame, como haría el renderizador
+        if (effectCount > 0) {
+            chip64ProcessEffects(&chip64);
+        }
+        frames++;
+    }
+
+    double elapsed = nowSeconds() - start;
+    if (elapsed <= 0) {
+        elapsed = 1e-9;
+    }
+
+    printf("ROM:            %s\n", romPath);
+    printf("Pantalla:       %dx%d\n", chip64GetDisplayWidth(&chip64), chip64GetDisplayHeight(&chip64));
+    printf("Frames:         %llu\n", (unsigned long long)frames);
+    printf("Instrucciones:  %llu\n", (unsigned long long)executed);
+    printf("Tiempo:         %.3f s\n", elapsed);
+    printf("IPS:            %.0f\n", executed / elapsed);
+    printf("FPS:            %.1f\n", frames / elapsed);
+    printf("Hash pantalla:  %016llx\n", (unsigned long long)hashFramebuffer(&chip64));
+    if (chip64.waitingKey) {
+        printf("Estado:         esperando tecla (FX0A)\n");
+    }
+
+    // Etapas activas y coste medio por frame de la pasada fusionada (el de
+    // cada etapa no se puede separar)
+    const Chip64EffectPipeline* fx = &chip64.effects;
+    if (fx->frames > 0) {
+        printf("Efectos:       ");
+        for (int i = 0; i < fx->count; i++) {
+            printf(" %s", chip64EffectName(fx->stages[i].effect));
+        }
+        printf("\n");
+        printf("Efectos (pasada) %.0f ns/frame\n", (double)fx->composeTotalNs / fx->frames);
+    }
+
+    if (pbmPath != NULL && !writePBM(&chip64, pbmPath)) {
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
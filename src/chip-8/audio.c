@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <string.h>
+#include "audio.h"
+
+// Corrección polyBLEP de un flanco de subida en t = 0 (t y dt en periodos)
+static double audioPolyBlep(double t, double dt) {
+    if (t < dt) {
+        t /= dt;
+        return t + t - t * t - 1.0;
+    }
+    if (t > 1.0 - dt) {
+        t = (t - 1.0) / dt;
+        return t * t + t + t + 1.0;
+    }
+    return 0.0;
+}
+
+// Rellenar un buffer de audio (hilo de audio de SDL)
+static void audioCallback(void* userdata, Uint8* stream, int len) {
+    Audio* audio = userdata;
+    Sint16* out = (Sint16*)stream;
+    int count = len / (int)sizeof(Sint16);
+    double target = SDL_AtomicGet(&audio->playing) ? 1.0 : 0.0;
+    
+    // Silencio: nada que calcular
+    if (target == 0.0 && audio->gain == 0.0) {
+        memset(stream, 0, len);
+        return;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        // Onda cuadrada con los dos flancos suavizados
+        double t = audio->phase;
+        double value = t < 0.5 ? 1.0 : -1.0;
+        value += audioPolyBlep(t, audio->step);
+        t += 0.5;
+        if (t >= 1.0) {
+            t -= 1.0;
+        }
+        value -= audioPolyBlep(t, audio->step);
+        
+        // Rampa de volumen hacia el estado pedido
+        if (audio->gain < target) {
+            audio->gain += 1.0 / AUDIO_RAMP_SAMPLES;
+            if (audio->gain > target) {
+                audio->gain = target;
+            }
+        } else if (audio->gain > target) {
+            audio->gain -= 1.0 / AUDIO_RAMP_SAMPLES;
+            if (audio->gain < target) {
+                audio->gain = target;
+            }
+        }
+        
+        out[i] = (Sint16)(value * audio->gain * AUDIO_VOLUME * 32767.0);
+        
+        audio->phase += audio->step;
+        if (audio->phase >= 1.0) {
+            audio->phase -= 1.0;
+        }
+    }
+    
+    // Al terminar de bajar se reinicia la fase: el siguiente pitido empieza igual
+    if (audio->gain == 0.0) {
+        audio->phase = 0.0;
+    }
+}
+
+bool audioInit(Audio* audio, int samples) {
+    SDL_AtomicSet(&audio->playing, 0);
+    audio->phase = 0.0;
+    audio->gain = 0.0;
+    audio->step = AUDIO_TONE_FREQ / AUDIO_SAMPLE_RATE;
+    audio->device = 0;
+    
+    SDL_AudioSpec want;
+    SDL_AudioSpec have;
+    memset(&want, 0, sizeof(want));
+    want.freq = AUDIO_SAMPLE_RATE;
+    want.format = AUDIO_S16SYS;
+    want.channels = 1;
+    want.samples = (Uint16)samples;
+    want.callback = audioCallback;
+    want.userdata = audio;
+    
+    // Se acepta la frecuencia que ofrezca el dispositivo
+    audio->device = SDL_OpenAudioDevice(NULL, 0, &want, &have, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+    if (audio->device == 0) {
+        fprintf(stderr, "Aviso: no se pudo abrir el audio: %s\n", SDL_GetError());
+        return false;
+    }
+    audio->step = AUDIO_TONE_FREQ / have.freq;
+    
+    // El dispositivo queda siempre en marcha; el tono lo controla playing
+    SDL_PauseAudioDevice(audio->device, 0);
+    return true;
+}
+
+void audioSetTone(Audio* audio, bool on) {
+    SDL_AtomicSet(&audio->playing, on ? 1 : 0);
+}
+
+void audioCleanup(Audio* audio) {
+    if (audio->device != 0) {
+        SDL_CloseAudioDevice(audio->device);
+        audio->device = 0;
+    }
+}
@@ -0,0 +1,94 @@
+#include "blit.h"
+
+#if !defined(BLIT_SCALAR) && defined(__AVX2__)
+#include <immintrin.h>
+#define BLIT_AVX2
+#elif !defined(BLIT_SCALAR) && defined(__SSE2__)
+#include <emmintrin.h>
+#define BLIT_SSE2
+#endif
+
+// Máscaras de los 8 píxeles de cada byte empaquetado (bit 7 = primer píxel):
+// 0xFFFFFFFF si está encendido, 0 si no. 8 KB, independiente del color
+static uint32_t blitMaskLUT[256][8];
+
+void blitInit(void)
+{
+    for (int value = 0; value < 256; value++)
+    {
+        for (int bit = 0; bit < 8; bit++)
+        {
+            blitMaskLUT[value][bit] = (value & (0x80 >> bit)) ? 0xFFFFFFFFu : 0;
+        }
+    }
+}
+
+void blitBytesToRGBA(uint32_t *dst, const uint8_t *src, size_t count, uint32_t color)
+{
+    size_t i = 0;
+
+#if defined(BLIT_AVX2)
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i rgba = _mm256_set1_epi32((int)color);
+    for (; i + 8 <= count; i += 8)
+    {
+        // 8 bytes → 8 enteros de 32 bits → máscara de los que valen 1
+        __m256i px = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(src + i)));
+        __m256i mask = _mm256_cmpeq_epi32(px, one);
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_and_si256(mask, rgba));
+    }
+#elif defined(BLIT_SSE2)
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i rgba = _mm_set1_epi32((int)color);
+    for (; i + 16 <= count; i += 16)
+    {
+        // Máscara de 8 bits por píxel, ensanchada a 16 y luego a 32 bits
+        __m128i mask = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(src + i)), one);
+        __m128i lo = _mm_unpacklo_epi8(mask, mask);
+        __m128i hi = _mm_unpackhi_epi8(mask, mask);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_and_si128(_mm_unpacklo_epi16(lo, lo), rgba));
+        _mm_storeu_si128((__m128i *)(dst + i + 4), _mm_and_si128(_mm_unpackhi_epi16(lo, lo), rgba));
+        _mm_storeu_si128((__m128i *)(dst + i + 8), _mm_and_si128(_mm_unpacklo_epi16(hi, hi), rgba));
+        _mm_storeu_si128((__m128i *)(dst + i + 12), _mm_and_si128(_mm_unpackhi_epi16(hi, hi), rgba));
+    }
+#endif
+
+    // Resto (o todo en la versión escalar): máscara aritmética sin saltos
+    for (; i < count; i++)
+    {
+        dst[i] = color & (0u - (uint32_t)(src[i] == 1));
+    }
+}
+
+void blitBitsToRGBA(uint32_t *dst, const uint64_t *rows, size_t rowCount, uint32_t color)
+{
+#if defined(BLIT_AVX2)
+    const __m256i rgba = _mm256_set1_epi32((int)color);
+#elif defined(BLIT_SSE2)
+    const __m128i rgba = _mm_set1_epi32((int)color);
+#endif
+
+    for (size_t row = 0; row < rowCount; row++)
+    {
+        for (int byte = 0; byte < 8; byte++)
+        {
+            const uint32_t *mask = blitMaskLUT[(rows[row] >> (56 - 8 * byte)) & 0xFF];
+            uint32_t *out = dst + row * 64 + byte * 8;
+
+#if defined(BLIT_AVX2)
+            __m256i m = _mm256_loadu_si256((const __m256i *)mask);
+            _mm256_storeu_si256((__m256i *)out, _mm256_and_si256(m, rgba));
+#elif defined(BLIT_SSE2)
+            __m128i m0 = _mm_loadu_si128((const __m128i *)mask);
+            __m128i m1 = _mm_loadu_si128((const __m128i *)(mask + 4));
+            _mm_storeu_si128((__m128i *)out, _mm_and_si128(m0, rgba));
+            _mm_storeu_si128((__m128i *)(out + 4), _mm_and_si128(m1, rgba));
+#else
+            for (int k = 0; k < 8; k++)
+            {
+                out[k] = mask[k] & color;
+            }
+#endif
+        }
+    }
+}
@@ -4,6 +4,10 @@
 #include <time.h>
 #include "chip8.h"
 
+#ifdef CHIP8_DISPATCH_TABLE
+static void chip8BuildDispatchTable(void);
+#endif
+
 // Inicialización del emulador CHIP-8
 void chip8Init(Chip8 *chip8)
 {
@@ -12,13 +16,16 @@ void chip8Init(Chip8 *chip8)
     chip8->config.clockSpeed = DEFAULT_SPEED;
     chip8->config.enableSound = true;
     chip8->config.pixelColor = DEFAULT_PIXEL_COLOR;
+    chip8->config.cycleTimers = false;
 
     // Inicializar registros y memoria
     memset(chip8->memory, 0, MEMORY_SIZE);
     memset(chip8->V, 0, REGISTER_COUNT);
-    memset(chip8->gfx, 0, DISPLAY_WIDTH * DISPLAY_HEIGHT);
+    memset(chip8->gfxRows, 0, sizeof(chip8->gfxRows));
     memset(chip8->key, 0, KEY_COUNT);
     memset(chip8->stack, 0, STACK_SIZE * sizeof(uint16_t));
+    memset(chip8->icache, 0, sizeof(chip8->icache));
+    memset(&chip8->cacheStats, 0, sizeof(chip8->cacheStats));
 
     chip8->opcode = 0;
     chip8->I = 0;
@@ -27,12 +34,24 @@ void chip8Init(Chip8 *chip8)
     chip8->delayTimer = 0;
     chip8->soundTimer = 0;
     chip8->drawFlag = false;
+    chip8->dirtyRows = UINT32_MAX; // El primer render dibuja la pantalla completa
+    chip8->waitingKey = false;
+    chip8->runEvent = CHIP8_RUN_BUDGET;
+    chip8->runCycles = 0;
+    chip8->idleCycles = 0;
+    chip8->timerCountdown = 0;
+    chip8->timerRemainder = 0;
 
     // Cargar fuente en memoria
     memcpy(chip8->memory, chip8_fontset, FONTSET_SIZE);
 
     // Inicializar semilla para números aleatorios
-    srand(time(NULL));
+    chip8Seed(chip8, (uint32_t)time(NULL));
+
+#ifdef CHIP8_DISPATCH_TABLE
+    // Preparar la tabla de despacho del núcleo alternativo
+    chip8BuildDispatchTable();
+#endif
 }
 
 // Cargar ROM desde archivo
@@ -68,11 +87,28 @@ bool chip8LoadROM(Chip8 *chip8, const char *filename)
         return false;
     }
 
+    // La memoria ha cambiado: descartar instrucciones predecodificadas
+    chip8FlushCache(chip8);
+
     return true;
 }
 
+// Expandir el framebuffer empaquetado a un byte por píxel
+void chip8GetFramebuffer(const Chip8 *chip8, uint8_t *out)
+{
+    for (int y = 0; y < DISPLAY_HEIGHT; y++)
+    {
+        uint64_t row = chip8->gfxRows[y];
+        for (int x = 0; x < DISPLAY_WIDTH; x++)
+        {
+            out[x + y * DISPLAY_WIDTH] = (row >> (DISPLAY_WIDTH - 1 - x)) & 1;
+        }
+    }
+}
+
 // Actualizar temporizadores
-void chip8UpdateTimers(Chip8 *chip8)
+// Un tick de 60 Hz de DT y ST
+static void chip8TickTimers(Chip8 *chip8)
 {
     if (chip8->delayTimer > 0)
     {
@@ -81,26 +117,603 @@ void chip8UpdateTimers(Chip8 *chip8)
 
     if (chip8->soundTimer > 0)
     {
-        if (chip8->config.enableSound && chip8->soundTimer == 1)
-        {
-            // Aquí se implementaría la reproducción de sonido
-            printf("BEEP!\n");
-        }
         chip8->soundTimer--;
     }
 }
 
+void chip8UpdateTimers(Chip8 *chip8)
+{
+    // En modo por instrucciones los ticks los genera chip8Run
+    if (!chip8->config.cycleTimers)
+    {
+        chip8TickTimers(chip8);
+    }
+}
+
+// Instrucciones hasta el siguiente tick: clockSpeed / TIMER_FREQ, arrastrando
+// la fracción para que en clockSpeed instrucciones haya exactamente TIMER_FREQ.
+// Como mucho un tick por instrucción, así que el resultado nunca es 0
+static void chip8ScheduleTimerTick(Chip8 *chip8)
+{
+    uint32_t rate = chip8->config.clockSpeed > TIMER_FREQ ? (uint32_t)chip8->config.clockSpeed : TIMER_FREQ;
+    chip8->timerRemainder += rate;
+    chip8->timerCountdown = chip8->timerRemainder / TIMER_FREQ;
+    chip8->timerRemainder %= TIMER_FREQ;
+}
+
+void chip8SetCycleTimers(Chip8 *chip8, bool enable)
+{
+    chip8->config.cycleTimers = enable;
+    chip8->timerCountdown = 0;
+    chip8->timerRemainder = 0;
+    chip8ScheduleTimerTick(chip8);
+}
+
+void chip8AdvanceTimers(Chip8 *chip8, uint32_t cycles)
+{
+    // Sin planificar todavía (chip8Init deja timerCountdown a 0)
+    if (chip8->timerCountdown == 0)
+    {
+        chip8ScheduleTimerTick(chip8);
+    }
+
+    chip8->timerCountdown -= cycles;
+    while (chip8->timerCountdown == 0)
+    {
+        chip8TickTimers(chip8);
+        chip8ScheduleTimerTick(chip8);
+    }
+}
+
+// Invalidar toda la caché de instrucciones
+void chip8FlushCache(Chip8 *chip8)
+{
+    memset(chip8->icache, 0, sizeof(chip8->icache));
+}
+
+// Sembrar el generador pseudoaleatorio (xorshift32, el estado nunca puede ser 0)
+void chip8Seed(Chip8 *chip8, uint32_t seed)
+{
+    chip8->rngState = seed * 2654435761u ^ 0x9E3779B9u;
+    if (chip8->rngState == 0)
+    {
+        chip8->rngState = 1;
+    }
+}
+
+// Siguiente número del generador. Es parte del estado del núcleo (a
+// diferencia de rand()), así que un estado restaurado saca los mismos números
+static uint32_t chip8Random(Chip8 *chip8)
+{
+    uint32_t x = chip8->rngState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    chip8->rngState = x;
+    return x;
+}
+
 // Establecer estado de una tecla
 void chip8SetKey(Chip8 *chip8, uint8_t key, uint8_t value)
 {
     if (key < KEY_COUNT)
     {
         chip8->key[key] = value;
+
+        // Una pulsación despierta a un programa detenido en FX0A
+        if (value != 0)
+        {
+            chip8->waitingKey = false;
+        }
     }
 }
 
-// Ejecutar un ciclo de emulación
-void chip8Cycle(Chip8 *chip8)
+// ============================================================================
+// MANEJADORES DE INSTRUCCIONES
+// ============================================================================
+//
+// Cada instrucción se implementa en un manejador independiente que recibe los
+// operandos ya extraídos del opcode. Los comparten el núcleo basado en switch
+// y el núcleo con tabla de despacho, de modo que ambos producen exactamente
+// el mismo resultado.
+
+// Invalidar las entradas de la caché que cubren [addr, addr + len).
+// Solo se anula el manejador: el resto de campos sigue siendo válido para una
+// instrucción que se esté ejecutando desde la entrada que sobrescribe.
+static inline void chip8InvalidateCode(Chip8 *chip8, uint32_t addr, uint32_t len)
+{
+    uint32_t end = addr + len;
+    if (end > MEMORY_SIZE)
+    {
+        end = MEMORY_SIZE;
+    }
+
+    for (uint32_t a = addr & ~1u; a < end; a += 2)
+    {
+        Chip8Instr *entry = &chip8->icache[a >> 1];
+        if (entry->handler != NULL)
+        {
+            entry->handler = NULL;
+            chip8->cacheStats.invalidations++;
+        }
+    }
+}
+
+// 0NNN: Opcode desconocido
+static void opUnknown(Chip8 *chip8, const Chip8Instr *ins)
+{
+    (void)ins;
+    chip8->runEvent = CHIP8_RUN_UNKNOWN_OPCODE;
+    if (chip8->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("Opcode desconocido: 0x%04X\n", chip8->opcode);
+    }
+}
+
+// 00E0: Limpiar pantalla
+static void opCls(Chip8 *chip8, const Chip8Instr *ins)
+{
+    (void)ins;
+    memset(chip8->gfxRows, 0, sizeof(chip8->gfxRows));
+    chip8->dirtyRows = UINT32_MAX;
+    chip8->drawFlag = true;
+    chip8->runEvent = CHIP8_RUN_DRAW;
+}
+
+// 00EE: Retornar de subrutina
+static void opRet(Chip8 *chip8, const Chip8Instr *ins)
+{
+    (void)ins;
+    chip8->SP--;
+    chip8->PC = chip8->stack[chip8->SP];
+}
+
+// 1NNN: Saltar a dirección NNN
+static void opJp(Chip8 *chip8, const Chip8Instr *ins)
+{
+    chip8->PC = ins->nnn;
+}
+
+// 2NNN: Llamar subrutina en NNN
+static void opCall(Chip8 *chip8, const Chip8Instr *ins)
+{
+    chip8->stack[chip8->SP] = chip8->PC;
+    chip8->SP++;
+    chip8->PC = ins->nnn;
+}
+
+// 3XKK: Saltar siguiente instrucción si VX == KK
+static void opSeVxByte(Chip8 *chip8, const Chip8Instr *ins)
+{
+    if (chip8->V[ins->x] == ins->kk)
+    {
+        chip8->PC += 2;
+    }
+}
+
+// 4XKK: Saltar siguiente instrucción si VX != KK
+static void opSneVxByte(Chip8 *chip8, const Chip8Instr *ins)
+{
+    if (chip8->V[ins->x] != ins->kk)
+    {
+        chip8->PC += 2;
+    }
+}
+
+// 5XY0: Saltar siguiente instrucción si VX == VY
+static void opSeVxVy(Chip8 *chip8, const Chip8Instr *ins)
+{
+    if (chip8->V[ins->x] == chip8->V[ins->y])
+    {
+        chip8->PC += 2;
+    }
+}
+
+// 6XKK: Establecer VX = KK
+static void opLdVxByte(Chip8 *chip8, const Chip8Instr *ins)
+{
+    chip8->V[ins->x] = ins->kk;
+}
+
+// 7XKK: Establecer VX = VX + KK
+static void opAddVxByte(Chip8 *chip8, const Chip8Instr *ins)
+{
+    chip8->V[ins->x] += ins->kk;
+}
+
+// 8XY0: Establecer VX = VY
+static void opLdVxVy(Chip8 *chip8, const Chip8Instr *ins)
+{
+    chip8->V[ins->x] = chip8->V[ins->y];
+}
+
+// 8XY1: Establecer VX = VX OR VY
+static void opOr(Chip8 *chip8, const Chip8Instr *ins)
+{
+    chip8->V[ins->x] |= chip8->V[ins->y];
+}
+
+// 8XY2: Establecer VX = VX AND VY
+static void opAnd(Chip8 *chip8, const Chip8Instr *ins)
+{
+    chip8->V[ins->x] &= chip8->V[ins->y];
+}
+
+// 8XY3: Establecer VX = VX XOR VY
+static void opXor(Chip8 *chip8, const Chip8Instr *ins)
+{
+    chip8->V[ins->x] ^= chip8->V[ins->y];
+}
+
+// 8XY4: Establecer VX = VX + VY, VF = carry
+static void opAddVxVy(Chip8 *chip8, const Chip8Instr *ins)
+{
+    int sum = chip8->V[ins->x] + chip8->V[ins->y];
+    chip8->V[0xF] = (sum > 255) ? 1 : 0;
+    chip8->V[ins->x] = sum & 0xFF;
+}
+
+// 8XY5: Establecer VX = VX - VY, VF = not borrow
+static void opSub(Chip8 *chip8, const Chip8Instr *ins)
+{
+    chip8->V[0xF] = (chip8->V[ins->x] > chip8->V[ins->y]) ? 1 : 0;
+    chip8->V[ins->x] -= chip8->V[ins->y];
+}
+
+// 8XY6: Desplazar VX a la derecha, VF = bit menos significativo
+static void opShr(Chip8 *chip8, const Chip8Instr *ins)
+{
+    chip8->V[0xF] = chip8->V[ins->x] & 0x1;
+    chip8->V[ins->x] >>= 1;
+}
+
+// 8XY7: Establecer VX = VY - VX, VF = not borrow
+static void opSubn(Chip8 *chip8, const Chip8Instr *ins)
+{
+    chip8->V[0xF] = (chip8->V[ins->y] > chip8->V[ins->x]) ? 1 : 0;
+    chip8->V[ins->x] = chip8->V[ins->y] - chip8->V[ins->x];
+}
+
+// 8XYE: Desplazar VX a la izquierda, VF = bit más significativo
+static void opShl(Chip8 *chip8, const Chip8Instr *ins)
+{
+    chip8->V[0xF] = (chip8->V[ins->x] & 0x80) >> 7;
+    chip8->V[ins->x] <<= 1;
+}
+
+// 9XY0: Saltar siguiente instrucción si VX != VY
+static void opSneVxVy(Chip8 *chip8, const Chip8Instr *ins)
+{
+    if (chip8->V[ins->x] != chip8->V[ins->y])
+    {
+        chip8->PC += 2;
+    }
+}
+
+// ANNN: Establecer I = NNN
+static void opLdI(Chip8 *chip8, const Chip8Instr *ins)
+{
+    chip8->I = ins->nnn;
+}
+
+// BNNN: Saltar a dirección NNN + V0
+static void opJpV0(Chip8 *chip8, const Chip8Instr *ins)
+{
+    chip8->PC = ins->nnn + chip8->V[0];
+}
+
+// CXKK: Establecer VX = random byte AND KK
+static void opRnd(Chip8 *chip8, const Chip8Instr *ins)
+{
+    chip8->V[ins->x] = (chip8Random(chip8) >> 24) & ins->kk;
+}
+
+// DXYN: Dibujar sprite en posición VX, VY con N bytes
+// Cada fila del sprite se coloca en la columna 0 de una palabra y se rota
+// hasta VX (el wrap horizontal sale gratis); la colisión es un AND por fila
+static void opDrw(Chip8 *chip8, const Chip8Instr *ins)
+{
+    unsigned int xPos = chip8->V[ins->x] % DISPLAY_WIDTH;
+    unsigned int yPos = chip8->V[ins->y] % DISPLAY_HEIGHT;
+    uint64_t collision = 0;
+
+    for (int row = 0; row < ins->n; row++)
+    {
+        uint64_t spriteRow = (uint64_t)chip8->memory[chip8->I + row] << (DISPLAY_WIDTH - 8);
+        spriteRow = (spriteRow >> xPos) | (spriteRow << ((DISPLAY_WIDTH - xPos) % DISPLAY_WIDTH));
+
+        // Wrap vertical
+        unsigned int y = (yPos + row) % DISPLAY_HEIGHT;
+        collision |= chip8->gfxRows[y] & spriteRow;
+        chip8->gfxRows[y] ^= spriteRow;
+        chip8->dirtyRows |= 1u << y;
+    }
+
+    chip8->V[0xF] = collision != 0; // Flag de colisión
+    chip8->drawFlag = true;
+    chip8->runEvent = CHIP8_RUN_DRAW;
+}
+
+// EX9E: Saltar siguiente instrucción si tecla VX está presionada
+static void opSkp(Chip8 *chip8, const Chip8Instr *ins)
+{
+    if (chip8->key[chip8->V[ins->x]] != 0)
+    {
+        chip8->PC += 2;
+    }
+}
+
+// EXA1: Saltar siguiente instrucción si tecla VX no está presionada
+static void opSknp(Chip8 *chip8, const Chip8Instr *ins)
+{
+    if (chip8->key[chip8->V[ins->x]] == 0)
+    {
+        chip8->PC += 2;
+    }
+}
+
+// FX07: Establecer VX = valor del delay timer
+static void opLdVxDt(Chip8 *chip8, const Chip8Instr *ins)
+{
+    chip8->V[ins->x] = chip8->delayTimer;
+}
+
+// FX0A: Esperar presión de tecla, almacenar en VX
+static void opLdVxK(Chip8 *chip8, const Chip8Instr *ins)
+{
+    bool keyPressed = false;
+
+    for (int i = 0; i < KEY_COUNT; i++)
+    {
+        if (chip8->key[i])
+        {
+            chip8->V[ins->x] = i;
+            keyPressed = true;
+            break;
+        }
+    }
+
+    // Si no se presionó tecla, repetir instrucción y detener chip8Run hasta
+    // que chip8SetKey registre una pulsación
+    chip8->waitingKey = !keyPressed;
+    if (!keyPressed)
+    {
+        chip8->PC -= 2;
+        chip8->runEvent = CHIP8_RUN_KEY_WAIT;
+    }
+}
+
+// FX15: Establecer delay timer = VX
+static void opLdDtVx(Chip8 *chip8, const Chip8Instr *ins)
+{
+    chip8->delayTimer = chip8->V[ins->x];
+    chip8->runEvent = CHIP8_RUN_TIMER_WRITE;
+}
+
+// FX18: Establecer sound timer = VX
+static void opLdStVx(Chip8 *chip8, const Chip8Instr *ins)
+{
+    chip8->soundTimer = chip8->V[ins->x];
+    chip8->runEvent = CHIP8_RUN_TIMER_WRITE;
+}
+
+// FX1E: Establecer I = I + VX
+static void opAddIVx(Chip8 *chip8, const Chip8Instr *ins)
+{
+    chip8->I += chip8->V[ins->x];
+}
+
+// FX29: Establecer I = dirección del carácter en VX
+static void opLdFVx(Chip8 *chip8, const Chip8Instr *ins)
+{
+    chip8->I = chip8->V[ins->x] * 5; // Cada carácter ocupa 5 bytes
+}
+
+// FX33: Almacenar representación BCD de VX en I, I+1, I+2
+static void opLdBVx(Chip8 *chip8, const Chip8Instr *ins)
+{
+    uint8_t value = chip8->V[ins->x];
+    chip8->memory[chip8->I] = value / 100;
+    chip8->memory[chip8->I + 1] = (value / 10) % 10;
+    chip8->memory[chip8->I + 2] = value % 10;
+
+    chip8InvalidateCode(chip8, chip8->I, 3);
+}
+
+// FX55: Almacenar V0 a VX en memoria desde I
+static void opLdIVx(Chip8 *chip8, const Chip8Instr *ins)
+{
+    for (int i = 0; i <= ins->x; i++)
+    {
+        chip8->memory[chip8->I + i] = chip8->V[i];
+    }
+
+    chip8InvalidateCode(chip8, chip8->I, ins->x + 1);
+}
+
+// FX65: Cargar V0 a VX desde memoria desde I
+static void opLdVxI(Chip8 *chip8, const Chip8Instr *ins)
+{
+    for (int i = 0; i <= ins->x; i++)
+    {
+        chip8->V[i] = chip8->memory[chip8->I + i];
+    }
+}
+
+// Extraer los campos de un opcode
+static inline void chip8ExtractFields(uint16_t opcode, Chip8Instr *ins)
+{
+    ins->opcode = opcode;
+    ins->x = (opcode & 0x0F00) >> 8;
+    ins->y = (opcode & 0x00F0) >> 4;
+    ins->n = opcode & 0x000F;
+    ins->kk = opcode & 0x00FF;
+    ins->nnn = opcode & 0x0FFF;
+}
+
+#ifdef CHIP8_DISPATCH_TABLE
+// ============================================================================
+// NÚCLEO CON TABLA DE DESPACHO
+// ============================================================================
+//
+// Una entrada por cada uno de los 65536 opcodes posibles, con el manejador y
+// los operandos ya extraídos. La decodificación se hace una única vez al
+// construir la tabla; en cada ciclo solo queda un acceso indexado por el
+// opcode completo y una llamada indirecta.
+//
+// Además, cada dirección par de memoria tiene una entrada en chip8->icache
+// que guarda la instrucción ya decodificada. Solo se invalida cuando una
+// escritura en memoria (FX33, FX55) la alcanza, así que una ROM que no se
+// modifica a sí misma nunca vuelve a leer ni decodificar la misma instrucción.
+
+static Chip8Instr dispatchTable[0x10000];
+static bool dispatchTableReady = false;
+
+// Opcodes sin efecto (variantes no definidas de 5XY_, 8XY_, 9XY_, EX__, FX__)
+static void opNop(Chip8 *chip8, const Chip8Instr *ins)
+{
+    (void)chip8;
+    (void)ins;
+}
+
+// Decodificar un opcode a su manejador (mismo árbol que el núcleo switch)
+static Chip8Handler chip8DecodeHandler(uint16_t opcode)
+{
+    uint8_t n = opcode & 0x000F;
+    uint8_t kk = opcode & 0x00FF;
+
+    switch (opcode & 0xF000)
+    {
+    case 0x0000:
+        switch (kk)
+        {
+        case 0xE0: return opCls;
+        case 0xEE: return opRet;
+        default:   return opUnknown;
+        }
+
+    case 0x1000: return opJp;
+    case 0x2000: return opCall;
+    case 0x3000: return opSeVxByte;
+    case 0x4000: return opSneVxByte;
+    case 0x5000: return (n == 0) ? opSeVxVy : opNop;
+    case 0x6000: return opLdVxByte;
+    case 0x7000: return opAddVxByte;
+
+    case 0x8000:
+        switch (n)
+        {
+        case 0x0: return opLdVxVy;
+        case 0x1: return opOr;
+        case 0x2: return opAnd;
+        case 0x3: return opXor;
+        case 0x4: return opAddVxVy;
+        case 0x5: return opSub;
+        case 0x6: return opShr;
+        case 0x7: return opSubn;
+        case 0xE: return opShl;
+        default:  return opNop;
+        }
+
+    case 0x9000: return (n == 0) ? opSneVxVy : opNop;
+    case 0xA000: return opLdI;
+    case 0xB000: return opJpV0;
+    case 0xC000: return opRnd;
+    case 0xD000: return opDrw;
+
+    case 0xE000:
+        switch (kk)
+        {
+        case 0x9E: return opSkp;
+        case 0xA1: return opSknp;
+        default:   return opNop;
+        }
+
+    case 0xF000:
+        switch (kk)
+        {
+        case 0x07: return opLdVxDt;
+        case 0x0A: return opLdVxK;
+        case 0x15: return opLdDtVx;
+        case 0x18: return opLdStVx;
+        case 0x1E: return opAddIVx;
+        case 0x29: return opLdFVx;
+        case 0x33: return opLdBVx;
+        case 0x55: return opLdIVx;
+        case 0x65: return opLdVxI;
+        default:   return opNop;
+        }
+    }
+
+    return opUnknown;
+}
+
+// Construir la tabla de despacho (solo la primera vez)
+static void chip8BuildDispatchTable(void)
+{
+    if (dispatchTableReady)
+    {
+        return;
+    }
+
+    for (uint32_t opcode = 0; opcode < 0x10000; opcode++)
+    {
+        chip8ExtractFields(opcode, &dispatchTable[opcode]);
+        dispatchTable[opcode].handler = chip8DecodeHandler(opcode);
+    }
+
+    dispatchTableReady = true;
+}
+
+// Ejecutar una instrucción (se inserta en chip8Cycle y en el bucle de chip8Run)
+static inline void chip8Step(Chip8 *chip8)
+{
+    const Chip8Instr *ins;
+    uint16_t pc = chip8->PC;
+
+    if ((pc & 1) == 0 && pc < MEMORY_SIZE)
+    {
+        // Dirección par: servir la instrucción desde la caché predecodificada
+        Chip8Instr *entry = &chip8->icache[pc >> 1];
+
+        if (entry->handler != NULL)
+        {
+            chip8->cacheStats.hits++;
+        }
+        else
+        {
+            *entry = dispatchTable[(chip8->memory[pc] << 8) | chip8->memory[pc + 1]];
+            chip8->cacheStats.misses++;
+        }
+        ins = entry;
+    }
+    else
+    {
+        // Dirección impar: decodificar directamente desde la tabla
+        ins = &dispatchTable[(chip8->memory[pc] << 8) | chip8->memory[pc + 1]];
+    }
+
+    chip8->opcode = ins->opcode;
+
+    // Incrementar PC antes de ejecutar
+    chip8->PC += 2;
+
+    // Depuración si está habilitada
+    if (chip8->config.debugLevel >= DEBUG_OPCODES)
+    {
+        printf("Ejecutando opcode: 0x%04X en PC=0x%04X\n", chip8->opcode, chip8->PC - 2);
+    }
+
+    ins->handler(chip8, ins);
+}
+
+#else
+// ============================================================================
+// NÚCLEO CON SWITCH (por defecto)
+// ============================================================================
+
+// Ejecutar una instrucción (se inserta en chip8Cycle y en el bucle de chip8Run)
+static inline void chip8Step(Chip8 *chip8)
 {
     // Extraer opcode (2 bytes)
     chip8->opcode = (chip8->memory[chip8->PC] << 8) | chip8->memory[chip8->PC + 1];
@@ -109,11 +722,8 @@ void chip8Cycle(Chip8 *chip8)
     chip8->PC += 2;
 
     // Variables para decodificación del opcode
-    uint8_t x = (chip8->opcode & 0x0F00) >> 8;
-    uint8_t y = (chip8->opcode & 0x00F0) >> 4;
-    uint8_t n = chip8->opcode & 0x000F;
-    uint8_t kk = chip8->opcode & 0x00FF;
-    uint16_t nnn = chip8->opcode & 0x0FFF;
+    Chip8Instr ins;
+    chip8ExtractFields(chip8->opcode, &ins);
 
     // Depuración si está habilitada
     if (chip8->config.debugLevel >= DEBUG_OPCODES)
@@ -125,269 +735,680 @@ void chip8Cycle(Chip8 *chip8)
     switch (chip8->opcode & 0xF000)
     {
     case 0x0000:
-        switch (kk)
+        switch (ins.kk)
         {
-        case 0x00E0: // 00E0: Limpiar pantalla
-            memset(chip8->gfx, 0, DISPLAY_WIDTH * DISPLAY_HEIGHT);
-            chip8->drawFlag = true;
-            break;
+        case 0x00E0: opCls(chip8, &ins); break;
+        case 0x00EE: opRet(chip8, &ins); break;
+        default:     opUnknown(chip8, &ins);
+        }
+        break;
 
-        case 0x00EE: // 00EE: Retornar de subrutina
-            chip8->SP--;
-            chip8->PC = chip8->stack[chip8->SP];
-            break;
+    case 0x1000: opJp(chip8, &ins); break;
+    case 0x2000: opCall(chip8, &ins); break;
+    case 0x3000: opSeVxByte(chip8, &ins); break;
+    case 0x4000: opSneVxByte(chip8, &ins); break;
 
-        default:
-            if (chip8->config.debugLevel >= DEBUG_OPCODES)
-            {
-                printf("Opcode desconocido: 0x%04X\n", chip8->opcode);
-            }
+    case 0x5000:
+        if (ins.n == 0)
+        {
+            opSeVxVy(chip8, &ins);
         }
         break;
 
-    case 0x1000: // 1NNN: Saltar a dirección NNN
-        chip8->PC = nnn;
-        break;
+    case 0x6000: opLdVxByte(chip8, &ins); break;
+    case 0x7000: opAddVxByte(chip8, &ins); break;
 
-    case 0x2000: // 2NNN: Llamar subrutina en NNN
-        chip8->stack[chip8->SP] = chip8->PC;
-        chip8->SP++;
-        chip8->PC = nnn;
+    case 0x8000:
+        switch (ins.n)
+        {
+        case 0x0: opLdVxVy(chip8, &ins); break;
+        case 0x1: opOr(chip8, &ins); break;
+        case 0x2: opAnd(chip8, &ins); break;
+        case 0x3: opXor(chip8, &ins); break;
+        case 0x4: opAddVxVy(chip8, &ins); break;
+        case 0x5: opSub(chip8, &ins); break;
+        case 0x6: opShr(chip8, &ins); break;
+        case 0x7: opSubn(chip8, &ins); break;
+        case 0xE: opShl(chip8, &ins); break;
+        }
         break;
 
-    case 0x3000: // 3XKK: Saltar siguiente instrucción si VX == KK
-        if (chip8->V[x] == kk)
+    case 0x9000:
+        if (ins.n == 0)
         {
-            chip8->PC += 2;
+            opSneVxVy(chip8, &ins);
         }
         break;
 
-    case 0x4000: // 4XKK: Saltar siguiente instrucción si VX != KK
-        if (chip8->V[x] != kk)
+    case 0xA000: opLdI(chip8, &ins); break;
+    case 0xB000: opJpV0(chip8, &ins); break;
+    case 0xC000: opRnd(chip8, &ins); break;
+    case 0xD000: opDrw(chip8, &ins); break;
+
+    case 0xE000:
+        switch (ins.kk)
         {
-            chip8->PC += 2;
+        case 0x9E: opSkp(chip8, &ins); break;
+        case 0xA1: opSknp(chip8, &ins); break;
         }
         break;
 
-    case 0x5000: // 5XY0: Saltar siguiente instrucción si VX == VY
-        if (n == 0 && chip8->V[x] == chip8->V[y])
+    case 0xF000:
+        switch (ins.kk)
         {
-            chip8->PC += 2;
+        case 0x07: opLdVxDt(chip8, &ins); break;
+        case 0x0A: opLdVxK(chip8, &ins); break;
+        case 0x15: opLdDtVx(chip8, &ins); break;
+        case 0x18: opLdStVx(chip8, &ins); break;
+        case 0x1E: opAddIVx(chip8, &ins); break;
+        case 0x29: opLdFVx(chip8, &ins); break;
+        case 0x33: opLdBVx(chip8, &ins); break;
+        case 0x55: opLdIVx(chip8, &ins); break;
+        case 0x65: opLdVxI(chip8, &ins); break;
         }
         break;
 
-    case 0x6000: // 6XKK: Establecer VX = KK
-        chip8->V[x] = kk;
-        break;
+    default:
+        opUnknown(chip8, &ins);
+    }
+}
+#endif // CHIP8_DISPATCH_TABLE
 
-    case 0x7000: // 7XKK: Establecer VX = VX + KK
-        chip8->V[x] += kk;
-        break;
+// ============================================================================
+// API PÚBLICA DE EJECUCIÓN
+// ============================================================================
 
-    case 0x8000:
-        switch (n)
+// Ejecutar un ciclo de emulación
+void chip8Cycle(Chip8 *chip8)
+{
+    chip8Step(chip8);
+}
+
+// Comprobar si el cuerpo [start, jump] de un bucle cerrado por un salto hacia
+// atrás solo contiene instrucciones sin efectos fuera de V e I: saltos
+// condicionales, ALU, ANNN, FX07, FX1E, FX29 y FX65. Sin escrituras en memoria,
+// dibujo, pila, timers, teclado ni CXKK, cada vuelta depende solo de V, I y el
+// delay timer, que únicamente cambia en chip8UpdateTimers.
+static bool chip8IsIdleLoop(const Chip8 *chip8, uint16_t start, uint16_t jump)
+{
+    if ((jump - start) / 2 >= IDLE_LOOP_MAX_LENGTH || (start & 1) != (jump & 1))
+    {
+        return false;
+    }
+
+    for (uint16_t addr = start; addr < jump; addr += 2)
+    {
+        uint16_t op = (chip8->memory[addr] << 8) | chip8->memory[addr + 1];
+        switch (op & 0xF000)
         {
-        case 0x0: // 8XY0: Establecer VX = VY
-            chip8->V[x] = chip8->V[y];
+        case 0x3000:
+        case 0x4000:
+        case 0x6000:
+        case 0x7000:
+        case 0xA000:
             break;
-
-        case 0x1: // 8XY1: Establecer VX = VX OR VY
-            chip8->V[x] |= chip8->V[y];
+        case 0x5000:
+        case 0x9000:
+            if ((op & 0x000F) != 0)
+                return false;
             break;
-
-        case 0x2: // 8XY2: Establecer VX = VX AND VY
-            chip8->V[x] &= chip8->V[y];
+        case 0x8000:
+            if ((op & 0x000F) > 0x7 && (op & 0x000F) != 0xE)
+                return false;
             break;
-
-        case 0x3: // 8XY3: Establecer VX = VX XOR VY
-            chip8->V[x] ^= chip8->V[y];
+        case 0xF000:
+            switch (op & 0x00FF)
+            {
+            case 0x07:
+            case 0x1E:
+            case 0x29:
+            case 0x65:
+                break;
+            default:
+                return false;
+            }
             break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+// Ejecutar instrucciones hasta agotar maxCycles o hasta que un manejador
+// señale un evento (dibujo, espera de tecla, escritura de timer, opcode
+// desconocido). El bucle interno evita una llamada por instrucción desde el
+// anfitrión, que solo tiene que reaccionar al motivo devuelto.
+//
+// También detecta bucles de espera (FX07; 3X00; 1NNN o un salto a sí mismo):
+// si al cerrar dos vueltas seguidas de un bucle puro V e I no han cambiado,
+// el resto del presupuesto se acredita en vueltas completas sin ejecutarlas,
+// ya que nada puede cambiar hasta el siguiente chip8UpdateTimers. El PC y los
+// registros quedan igual que si se hubieran ejecutado.
+static Chip8RunResult chip8RunSlice(Chip8 *chip8, uint32_t maxCycles)
+{
+    uint32_t cycles = 0;
+    bool idleArmed = false;        // Hay un bucle puro en observación
+    uint16_t idleStart = 0;        // Primera instrucción del bucle
+    uint16_t idleJump = 0;         // Dirección del salto que lo cierra
+    uint32_t idleMark = 0;         // Valor de cycles al cerrar la vuelta anterior
+    uint8_t idleV[REGISTER_COUNT]; // V e I al cerrar la vuelta anterior
+    uint16_t idleI = 0;
+
+    // Detenido en FX0A: no hay nada que ejecutar hasta que llegue una tecla
+    if (chip8->waitingKey)
+    {
+        chip8->runCycles = 0;
+        chip8->runEvent = CHIP8_RUN_KEY_WAIT;
+        return CHIP8_RUN_KEY_WAIT;
+    }
 
-        case 0x4: // 8XY4: Establecer VX = VX + VY, VF = carry
+    chip8->runEvent = CHIP8_RUN_BUDGET;
+    while (cycles < maxCycles)
+    {
+        uint16_t pc = chip8->PC;
+
+        // Salir del rango del bucle (por ejemplo, saltándose el 1NNN) lo desarma
+        if (idleArmed && (uint16_t)(pc - idleStart) > (uint16_t)(idleJump - idleStart))
         {
-            int sum = chip8->V[x] + chip8->V[y];
-            chip8->V[0xF] = (sum > 255) ? 1 : 0;
-            chip8->V[x] = sum & 0xFF;
+            idleArmed = false;
         }
-        break;
 
-        case 0x5: // 8XY5: Establecer VX = VX - VY, VF = not borrow
-            chip8->V[0xF] = (chip8->V[x] > chip8->V[y]) ? 1 : 0;
-            chip8->V[x] -= chip8->V[y];
+        chip8Step(chip8);
+        cycles++;
+
+        if (chip8->runEvent != CHIP8_RUN_BUDGET)
+        {
             break;
+        }
 
-        case 0x6: // 8XY6: Desplazar VX a la derecha, VF = bit menos significativo
+        // Salto hacia atrás: posible cierre de un bucle de espera
+        if ((chip8->opcode & 0xF000) == 0x1000 && chip8->PC <= pc)
+        {
+            if (idleArmed && pc == idleJump && chip8->I == idleI &&
+                memcmp(chip8->V, idleV, sizeof(idleV)) == 0)
+            {
+                uint32_t period = cycles - idleMark;
+                uint32_t skipped = (maxCycles - cycles) / period * period;
+                cycles += skipped;
+                chip8->idleCycles += skipped;
+            }
+            else if ((idleArmed && pc == idleJump) ||
+                     (chip8->config.debugLevel < DEBUG_OPCODES &&
+                      chip8IsIdleLoop(chip8, chip8->PC, pc)))
+            {
+                idleArmed = true;
+                idleStart = chip8->PC;
+                idleJump = pc;
+            }
+            else
+            {
+                idleArmed = false;
+                continue;
+            }
+            idleMark = cycles;
+            memcpy(idleV, chip8->V, sizeof(idleV));
+            idleI = chip8->I;
+        }
+    }
 
-            chip8->V[0xF] = chip8->V[x] & 0x1;
-            chip8->V[x] >>= 1;
+    chip8->runCycles = cycles;
+    return chip8->runEvent;
+}
 
-            break;
+// Con config.cycleTimers el presupuesto se trocea en los tramos que separan
+// dos ticks de DT/ST, que se aplican exactamente tras la instrucción que
+// completa cada periodo. Detenido en FX0A el tiempo emulado sigue corriendo:
+// el resto del presupuesto se consume sin ejecutar nada, como un bucle de espera
+Chip8RunResult chip8Run(Chip8 *chip8, uint32_t maxCycles)
+{
+    if (!chip8->config.cycleTimers)
+    {
+        return chip8RunSlice(chip8, maxCycles);
+    }
 
-        case 0x7: // 8XY7: Establecer VX = VY - VX, VF = not borrow
-            chip8->V[0xF] = (chip8->V[y] > chip8->V[x]) ? 1 : 0;
-            chip8->V[x] = chip8->V[y] - chip8->V[x];
-            break;
+    uint32_t done = 0;
+    Chip8RunResult result = CHIP8_RUN_BUDGET;
 
-        case 0xE: // 8XYE: Desplazar VX a la izquierda, VF = bit más significativo
+    chip8AdvanceTimers(chip8, 0);  // Planificar el primer tick si hace falta
 
-            chip8->V[0xF] = (chip8->V[x] & 0x80) >> 7;
-            chip8->V[x] <<= 1;
+    while (done < maxCycles)
+    {
+        uint32_t slice = maxCycles - done;
+        if (slice > chip8->timerCountdown)
+        {
+            slice = chip8->timerCountdown;
+        }
 
-            break;
+        if (chip8->waitingKey)
+        {
+            chip8->idleCycles += slice;
+            chip8->runCycles = slice;
+            result = CHIP8_RUN_KEY_WAIT;
+        }
+        else
+        {
+            result = chip8RunSlice(chip8, slice);
         }
-        break;
 
-    case 0x9000: // 9XY0: Saltar siguiente instrucción si VX != VY
-        if (n == 0 && chip8->V[x] != chip8->V[y])
+        done += chip8->runCycles;
+        chip8AdvanceTimers(chip8, chip8->runCycles);
+
+        if (result != CHIP8_RUN_BUDGET && !chip8->waitingKey)
         {
-            chip8->PC += 2;
+            break;
         }
-        break;
+    }
 
-    case 0xA000: // ANNN: Establecer I = NNN
-        chip8->I = nnn;
-        break;
+    chip8->runCycles = done;
+    chip8->runEvent = result;
+    return result;
+}
 
-    case 0xB000: // BNNN: Saltar a dirección NNN + V0
-        chip8->PC = nnn + chip8->V[0];
-        break;
+// ============================================================================
+// ESTADO GUARDADO
+// ============================================================================
+//
+// Formato (enteros en little-endian):
+//   "C8ST", versión (1 byte)
+//   registros, pila, temporizadores, teclas y estado de ejecución
+//   memoria y pantalla comprimidas por rachas de ceros
+//
+// Las rachas se codifican con un byte de control: 0x00-0x7F = siguen
+// control + 1 bytes literales; 0x80-0xFF = (control & 0x7F) + 1 ceros. Un
+// cero suelto dentro de una racha de literales se deja como literal. Sin
+// comprimir (chip8SaveStateRaw) todo son rachas de 128 literales: el tamaño
+// es siempre el mismo y cada byte del estado ocupa siempre la misma posición.
+//
+// No se guarda Config (es del anfitrión) ni la caché de instrucciones: al
+// restaurar solo se invalidan las entradas de la memoria que cambia.
+
+#define CHIP8_STATE_MAGIC "C8ST"
+#define CHIP8_STATE_VERSION 1
+#define CHIP8_RUN_MAX 128 // Longitud máxima de una racha
+
+typedef struct
+{
+    uint8_t *data;
+    size_t size;
+    size_t pos;
+    bool ok;  // false si el buffer se quedó corto
+    bool raw; // Sin comprimir: solo rachas de literales de longitud máxima
+} Chip8StateWriter;
+
+typedef struct
+{
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+    bool ok; // false si los datos se acabaron o no son válidos
+} Chip8StateReader;
 
-    case 0xC000: // CXKK: Establecer VX = random byte AND KK
-        chip8->V[x] = (rand() % 256) & kk;
-        break;
+static void chip8StatePut(Chip8StateWriter *w, const void *src, size_t len)
+{
+    if (!w->ok || w->size - w->pos < len)
+    {
+        w->ok = false;
+        return;
+    }
+    memcpy(w->data + w->pos, src, len);
+    w->pos += len;
+}
 
-    case 0xD000: // DXYN: Dibujar sprite en posición VX, VY con N bytes
+static void chip8StatePutInt(Chip8StateWriter *w, uint64_t value, int bytes)
+{
+    uint8_t buf[8];
+    for (int i = 0; i < bytes; i++)
     {
-        uint16_t xPos = chip8->V[x] % DISPLAY_WIDTH;
-        uint16_t yPos = chip8->V[y] % DISPLAY_HEIGHT;
-        uint16_t height = n;
+        buf[i] = (uint8_t)(value >> (8 * i));
+    }
+    chip8StatePut(w, buf, (size_t)bytes);
+}
 
-        chip8->V[0xF] = 0; // Reset del flag de colisión
+static void chip8StatePutZeroRuns(Chip8StateWriter *w, const uint8_t *src, size_t len)
+{
+    size_t i = 0;
 
-        for (int row = 0; row < height; row++)
+    if (w->raw)
+    {
+        for (; i < len; i += CHIP8_RUN_MAX)
         {
-            uint8_t spriteData = chip8->memory[chip8->I + row];
-
-            for (int col = 0; col < 8; col++)
-            {
-                if ((spriteData & (0x80 >> col)) != 0)
-                {
-                    // Coordenadas con wrap-around
-                    int pixelX = (xPos + col) % DISPLAY_WIDTH;
-                    int pixelY = (yPos + row) % DISPLAY_HEIGHT;
-                    int pixelPos = pixelX + (pixelY * DISPLAY_WIDTH);
-
-                    // Comprobar colisión
-                    if (chip8->gfx[pixelPos] == 1)
-                    {
-                        chip8->V[0xF] = 1;
-                    }
-
-                    // XOR con el pixel existente
-                    chip8->gfx[pixelPos] ^= 1;
-                }
-            }
+            size_t n = len - i < CHIP8_RUN_MAX ? len - i : CHIP8_RUN_MAX;
+            chip8StatePutInt(w, n - 1, 1);
+            chip8StatePut(w, src + i, n);
         }
-
-        chip8->drawFlag = true;
+        return;
     }
-    break;
 
-    case 0xE000:
-        switch (kk)
+    while (i < len && w->ok)
+    {
+        size_t n = 0;
+        if (src[i] == 0)
         {
-        case 0x9E: // EX9E: Saltar siguiente instrucción si tecla VX está presionada
-            if (chip8->key[chip8->V[x]] != 0)
+            // De 8 en 8 mientras se pueda: la memoria libre es casi toda ceros
+            uint64_t word;
+            while (i + n + 8 <= len && n + 8 <= CHIP8_RUN_MAX &&
+                   (memcpy(&word, src + i + n, 8), word == 0))
             {
-                chip8->PC += 2;
+                n += 8;
             }
-            break;
-
-        case 0xA1: // EXA1: Saltar siguiente instrucción si tecla VX no está presionada
-            if (chip8->key[chip8->V[x]] == 0)
+            while (i + n < len && n < CHIP8_RUN_MAX && src[i + n] == 0)
             {
-                chip8->PC += 2;
+                n++;
             }
-            break;
+            chip8StatePutInt(w, 0x80 | (n - 1), 1);
         }
-        break;
+        else
+        {
+            // Literales hasta dos ceros seguidos
+            while (i + n < len && n < CHIP8_RUN_MAX &&
+                   !(src[i + n] == 0 && (i + n + 1 == len || src[i + n + 1] == 0)))
+            {
+                n++;
+            }
+            chip8StatePutInt(w, n - 1, 1);
+            chip8StatePut(w, src + i, n);
+        }
+        i += n;
+    }
+}
 
-    case 0xF000:
-        switch (kk)
+static void chip8StateGet(Chip8StateReader *r, void *dst, size_t len)
+{
+    if (!r->ok || r->size - r->pos < len)
+    {
+        r->ok = false;
+        memset(dst, 0, len);
+        return;
+    }
+    memcpy(dst, r->data + r->pos, len);
+    r->pos += len;
+}
+
+static uint64_t chip8StateGetInt(Chip8StateReader *r, int bytes)
+{
+    uint8_t buf[8];
+    uint64_t value = 0;
+    chip8StateGet(r, buf, (size_t)bytes);
+    for (int i = 0; i < bytes; i++)
+    {
+        value |= (uint64_t)buf[i] << (8 * i);
+    }
+    return value;
+}
+
+// Decodificar len bytes comprimidos en dst. Con dst NULL solo se comprueba
+// que los datos son válidos y se avanza el lector
+static void chip8StateGetZeroRuns(Chip8StateReader *r, uint8_t *dst, size_t len)
+{
+    size_t i = 0;
+    while (i < len && r->ok)
+    {
+        uint8_t control = (uint8_t)chip8StateGetInt(r, 1);
+        size_t n = (size_t)(control & 0x7F) + 1;
+        if (n > len - i)
         {
-        case 0x07: // FX07: Establecer VX = valor del delay timer
-            chip8->V[x] = chip8->delayTimer;
+            r->ok = false;
             break;
-
-        case 0x0A: // FX0A: Esperar presión de tecla, almacenar en VX
+        }
+        if (dst == NULL)
         {
-            bool keyPressed = false;
-
-            for (int i = 0; i < KEY_COUNT; i++)
+            // Solo comprobar: saltar los literales
+            if (!(control & 0x80))
             {
-                if (chip8->key[i])
+                if (r->size - r->pos < n)
                 {
-                    chip8->V[x] = i;
-                    keyPressed = true;
+                    r->ok = false;
                     break;
                 }
-            }
-
-            // Si no se presionó tecla, repetir instrucción
-            if (!keyPressed)
-            {
-                chip8->PC -= 2;
+                r->pos += n;
             }
         }
-        break;
-
-        case 0x15: // FX15: Establecer delay timer = VX
-            chip8->delayTimer = chip8->V[x];
-            break;
-
-        case 0x18: // FX18: Establecer sound timer = VX
-            chip8->soundTimer = chip8->V[x];
-            break;
+        else if (control & 0x80)
+        {
+            memset(dst + i, 0, n);
+        }
+        else
+        {
+            chip8StateGet(r, dst + i, n);
+        }
+        i += n;
+    }
+}
 
-        case 0x1E: // FX1E: Establecer I = I + VX
-            chip8->I += chip8->V[x];
-            break;
+// Decodificar la memoria directamente sobre el núcleo invalidando solo las
+// entradas de la caché de instrucciones cuyos bytes cambian: al restaurar un
+// estado cercano (rebobinado, run-ahead) casi toda la caché sigue valiendo.
+// Los datos ya se han comprobado con chip8StateGetZeroRuns
+static void chip8StateRestoreMemory(Chip8 *chip8, Chip8StateReader *r)
+{
+    static const uint8_t zeros[CHIP8_RUN_MAX];
+    uint32_t addr = 0;
 
-        case 0x29:                      // FX29: Establecer I = dirección del carácter en VX
-            chip8->I = chip8->V[x] * 5; // Cada carácter ocupa 5 bytes
-            break;
+    while (addr < MEMORY_SIZE)
+    {
+        uint8_t control = (uint8_t)chip8StateGetInt(r, 1);
+        uint32_t n = (uint32_t)(control & 0x7F) + 1;
+        const uint8_t *src = zeros;
+        if (!(control & 0x80))
+        {
+            src = r->data + r->pos;
+            r->pos += n;
+        }
 
-        case 0x33: // FX33: Almacenar representación BCD de VX en I, I+1, I+2
+        // Casi todas las rachas siguen igual
+        if (memcmp(chip8->memory + addr, src, n) == 0)
         {
-            uint8_t value = chip8->V[x];
-            chip8->memory[chip8->I] = value / 100;
-            chip8->memory[chip8->I + 1] = (value / 10) % 10;
-            chip8->memory[chip8->I + 2] = value % 10;
+            addr += n;
+            continue;
         }
-        break;
 
-        case 0x55: // FX55: Almacenar V0 a VX en memoria desde I
-            for (int i = 0; i <= x; i++)
+        // Tramo [first, last] de bytes distintos dentro de la racha
+        uint8_t *dst = chip8->memory + addr;
+        uint32_t first = 0;
+        while (first < n && dst[first] == src[first])
+        {
+            first++;
+        }
+        if (first < n)
+        {
+            uint32_t last = n - 1;
+            while (dst[last] == src[last])
             {
-                chip8->memory[chip8->I + i] = chip8->V[i];
+                last--;
             }
+            memcpy(dst + first, src + first, last - first + 1);
+            chip8InvalidateCode(chip8, addr + first, last - first + 1);
+        }
+        addr += n;
+    }
+}
 
-            break;
+static size_t chip8SaveStateTo(const Chip8 *chip8, uint8_t *buffer, size_t size, bool raw)
+{
+    Chip8StateWriter w = {buffer, size, 0, true, raw};
 
-        case 0x65: // FX65: Cargar V0 a VX desde memoria desde I
-            for (int i = 0; i <= x; i++)
-            {
-                chip8->V[i] = chip8->memory[chip8->I + i];
-            }
+    chip8StatePut(&w, CHIP8_STATE_MAGIC, 4);
+    chip8StatePutInt(&w, CHIP8_STATE_VERSION, 1);
 
-            break;
+    chip8StatePutInt(&w, chip8->opcode, 2);
+    chip8StatePut(&w, chip8->V, REGISTER_COUNT);
+    chip8StatePutInt(&w, chip8->I, 2);
+    chip8StatePutInt(&w, chip8->PC, 2);
+    chip8StatePutInt(&w, chip8->SP, 2);
+    for (int i = 0; i < STACK_SIZE; i++)
+    {
+        chip8StatePutInt(&w, chip8->stack[i], 2);
+    }
+    chip8StatePutInt(&w, chip8->delayTimer, 1);
+    chip8StatePutInt(&w, chip8->soundTimer, 1);
+    chip8StatePut(&w, chip8->key, KEY_COUNT);
+    chip8StatePutInt(&w, chip8->drawFlag, 1);
+    chip8StatePutInt(&w, chip8->dirtyRows, 4);
+    chip8StatePutInt(&w, chip8->waitingKey, 1);
+    chip8StatePutInt(&w, chip8->runEvent, 1);
+    chip8StatePutInt(&w, chip8->idleCycles, 8);
+    chip8StatePutInt(&w, chip8->timerCountdown, 4);
+    chip8StatePutInt(&w, chip8->timerRemainder, 4);
+    chip8StatePutInt(&w, chip8->rngState, 4);
+
+    chip8StatePutZeroRuns(&w, chip8->memory, MEMORY_SIZE);
+
+    // Filas de pantalla en little-endian, igual en cualquier anfitrión
+    uint8_t rows[DISPLAY_HEIGHT * 8];
+    for (int y = 0; y < DISPLAY_HEIGHT; y++)
+    {
+        for (int b = 0; b < 8; b++)
+        {
+            rows[y * 8 + b] = (uint8_t)(chip8->gfxRows[y] >> (8 * b));
         }
-        break;
+    }
+    chip8StatePutZeroRuns(&w, rows, sizeof(rows));
 
-    default:
-        if (chip8->config.debugLevel >= DEBUG_OPCODES)
+    return w.ok ? w.pos : 0;
+}
+
+size_t chip8SaveState(const Chip8 *chip8, uint8_t *buffer, size_t size)
+{
+    return chip8SaveStateTo(chip8, buffer, size, false);
+}
+
+size_t chip8SaveStateRaw(const Chip8 *chip8, uint8_t *buffer, size_t size)
+{
+    return chip8SaveStateTo(chip8, buffer, size, true);
+}
+
+bool chip8LoadState(Chip8 *chip8, const uint8_t *buffer, size_t size)
+{
+    Chip8StateReader r = {buffer, size, 0, true};
+    char magic[4];
+
+    chip8StateGet(&r, magic, 4);
+    if (!r.ok || memcmp(magic, CHIP8_STATE_MAGIC, 4) != 0)
+    {
+        fprintf(stderr, "Error: El estado guardado no es de CHIP-8\n");
+        return false;
+    }
+    unsigned version = (unsigned)chip8StateGetInt(&r, 1);
+    if (version != CHIP8_STATE_VERSION)
+    {
+        fprintf(stderr, "Error: Versión de estado guardado no soportada: %u\n", version);
+        return false;
+    }
+
+    // Primera pasada: los registros se leen en variables locales y la memoria
+    // solo se comprueba, para no dejar el núcleo a medias si los datos están
+    // truncados o no son válidos
+    uint16_t opcode = (uint16_t)chip8StateGetInt(&r, 2);
+    uint8_t V[REGISTER_COUNT];
+    chip8StateGet(&r, V, REGISTER_COUNT);
+    uint16_t I = (uint16_t)chip8StateGetInt(&r, 2);
+    uint16_t PC = (uint16_t)chip8StateGetInt(&r, 2);
+    uint16_t SP = (uint16_t)chip8StateGetInt(&r, 2);
+    uint16_t stack[STACK_SIZE];
+    for (int i = 0; i < STACK_SIZE; i++)
+    {
+        stack[i] = (uint16_t)chip8StateGetInt(&r, 2);
+    }
+    uint8_t delayTimer = (uint8_t)chip8StateGetInt(&r, 1);
+    uint8_t soundTimer = (uint8_t)chip8StateGetInt(&r, 1);
+    uint8_t key[KEY_COUNT];
+    chip8StateGet(&r, key, KEY_COUNT);
+    bool drawFlag = chip8StateGetInt(&r, 1) != 0;
+    uint32_t dirtyRows = (uint32_t)chip8StateGetInt(&r, 4);
+    bool waitingKey = chip8StateGetInt(&r, 1) != 0;
+    Chip8RunResult runEvent = (Chip8RunResult)chip8StateGetInt(&r, 1);
+    uint64_t idleCycles = chip8StateGetInt(&r, 8);
+    uint32_t timerCountdown = (uint32_t)chip8StateGetInt(&r, 4);
+    uint32_t timerRemainder = (uint32_t)chip8StateGetInt(&r, 4);
+    uint32_t rngState = (uint32_t)chip8StateGetInt(&r, 4);
+
+    Chip8StateReader memory = r;
+    chip8StateGetZeroRuns(&r, NULL, MEMORY_SIZE);
+
+    uint8_t rows[DISPLAY_HEIGHT * 8];
+    chip8StateGetZeroRuns(&r, rows, sizeof(rows));
+
+    if (!r.ok || SP > STACK_SIZE || PC >= MEMORY_SIZE || rngState == 0)
+    {
+        fprintf(stderr, "Error: Estado guardado truncado o corrupto\n");
+        return false;
+    }
+
+    // Segunda pasada: copiar el estado de la máquina; config y estadísticas
+    // se conservan
+    chip8->opcode = opcode;
+    chip8StateRestoreMemory(chip8, &memory);
+    memcpy(chip8->V, V, REGISTER_COUNT);
+    chip8->I = I;
+    chip8->PC = PC;
+    for (int y = 0; y < DISPLAY_HEIGHT; y++)
+    {
+        chip8->gfxRows[y] = 0;
+        for (int b = 0; b < 8; b++)
         {
-            printf("Opcode desconocido: 0x%04X\n", chip8->opcode);
+            chip8->gfxRows[y] |= (uint64_t)rows[y * 8 + b] << (8 * b);
         }
     }
-}
\ No newline at end of file
+    chip8->delayTimer = delayTimer;
+    chip8->soundTimer = soundTimer;
+    memcpy(chip8->stack, stack, sizeof(chip8->stack));
+    chip8->SP = SP;
+    memcpy(chip8->key, key, KEY_COUNT);
+    chip8->drawFlag = drawFlag;
+    chip8->dirtyRows = dirtyRows;
+    chip8->waitingKey = waitingKey;
+    chip8->runEvent = runEvent;
+    chip8->runCycles = 0;
+    chip8->idleCycles = idleCycles;
+    chip8->timerCountdown = timerCountdown;
+    chip8->timerRemainder = timerRemainder;
+    chip8->rngState = rngState;
+
+    return true;
+}
+
+bool chip8SaveStateFile(const Chip8 *chip8, const char *filename)
+{
+    uint8_t buffer[CHIP8_STATE_MAX_SIZE];
+    size_t size = chip8SaveState(chip8, buffer, sizeof(buffer));
+
+    FILE *file = fopen(filename, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "Error: No se pudo crear el archivo %s\n", filename);
+        return false;
+    }
+    bool ok = fwrite(buffer, 1, size, file) == size;
+    if (fclose(file) != 0)
+    {
+        ok = false;
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "Error: No se pudo escribir el estado en %s\n", filename);
+    }
+    return ok;
+}
+
+bool chip8LoadStateFile(Chip8 *chip8, const char *filename)
+{
+    FILE *file = fopen(filename, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "Error: No se pudo abrir el archivo %s\n", filename);
+        return false;
+    }
+
+    // Un byte más que el máximo para detectar archivos demasiado grandes
+    uint8_t buffer[CHIP8_STATE_MAX_SIZE + 1];
+    size_t size = fread(buffer, 1, sizeof(buffer), file);
+    fclose(file);
+
+    if (size > CHIP8_STATE_MAX_SIZE)
+    {
+        fprintf(stderr, "Error: %s no es un estado guardado de CHIP-8\n", filename);
+        return false;
+    }
+    return chip8LoadState(chip8, buffer, size);
+}
@@ -3,8 +3,15 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include "config.h"
 
+// El framebuffer empaquetado guarda cada fila en un uint64_t y dirtyRows
+// tiene un bit por fila
+#if DISPLAY_WIDTH != 64 || DISPLAY_HEIGHT != 32
+#error "gfxRows y dirtyRows requieren una pantalla de 64x32"
+#endif
+
 // Definición del conjunto de fuentes en formato de sprites hexadecimales
 static const uint8_t chip8_fontset[FONTSET_SIZE] = {
     0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
@@ -26,21 +33,78 @@ static const uint8_t chip8_fontset[FONTSET_SIZE] = {
 };
 
 
+typedef struct Chip8 Chip8;
+
+// Motivo por el que chip8Run devuelve el control al anfitrión
+typedef enum {
+    CHIP8_RUN_BUDGET,               // Se ejecutaron maxCycles instrucciones sin eventos
+    CHIP8_RUN_DRAW,                 // La pantalla cambió
+    CHIP8_RUN_KEY_WAIT,             // FX0A esperando una tecla (el PC sigue apuntando a FX0A)
+    CHIP8_RUN_TIMER_WRITE,          // Escritura en el delay o sound timer (FX15, FX18)
+    CHIP8_RUN_UNKNOWN_OPCODE        // Opcode 0NNN no soportado
+} Chip8RunResult;
+
+typedef struct Chip8Instr Chip8Instr;
+
+// Manejador que ejecuta una instrucción ya decodificada
+typedef void (*Chip8Handler)(Chip8* chip8, const Chip8Instr* ins);
+
+// Instrucción predecodificada: manejador + campos del opcode
+struct Chip8Instr {
+    Chip8Handler handler;         // Función que ejecuta la instrucción (NULL = entrada no válida)
+    uint16_t opcode;              // Opcode original
+    uint16_t nnn;                 // Dirección de 12 bits
+    uint8_t x;                    // Segundo nibble (registro X)
+    uint8_t y;                    // Tercer nibble (registro Y)
+    uint8_t n;                    // Cuarto nibble
+    uint8_t kk;                   // Byte bajo
+};
+
+// Contadores de la caché de instrucciones predecodificadas
 typedef struct {
+    uint64_t hits;                // Instrucciones servidas desde la caché
+    uint64_t misses;              // Instrucciones decodificadas y guardadas en la caché
+    uint64_t invalidations;       // Entradas invalidadas por escrituras en memoria
+} Chip8CacheStats;
+
+struct Chip8 {
     uint16_t opcode;              // Opcode actual
     uint8_t memory[MEMORY_SIZE];  // Memoria del sistema
     uint8_t V[REGISTER_COUNT];    // Registros V0-VF
     uint16_t I;                   // Registro índice
     uint16_t PC;                  // Program Counter
-    uint8_t gfx[DISPLAY_WIDTH * DISPLAY_HEIGHT];  // Memoria de pantalla
+    uint64_t gfxRows[DISPLAY_HEIGHT]; // Memoria de pantalla: una fila por palabra, bit 63 = columna 0
     uint8_t delayTimer;           // Timer de retardo
     uint8_t soundTimer;           // Timer de sonido
     uint16_t stack[STACK_SIZE];   // Pila para guardar direcciones de retorno
     uint16_t SP;                  // Stack Pointer
     uint8_t key[KEY_COUNT];       // Estado del teclado
     bool drawFlag;                // Bandera para indicar si hay que actualizar la pantalla
+    uint32_t dirtyRows;           // Filas modificadas desde el último render (bit y = fila y)
+    bool waitingKey;              // Detenido en FX0A hasta que se pulse una tecla
     Config config;                // Configuración del emulador
-} Chip8;
+
+    // Caché de instrucciones predecodificadas, una entrada por dirección par
+    Chip8Instr icache[MEMORY_SIZE / 2];
+    Chip8CacheStats cacheStats;   // Estadísticas de la caché
+
+    // Estado de chip8Run
+    Chip8RunResult runEvent;      // Evento que detiene chip8Run (CHIP8_RUN_BUDGET = ninguno)
+    uint32_t runCycles;           // Instrucciones ejecutadas en la última llamada a chip8Run
+    uint64_t idleCycles;          // Instrucciones acreditadas sin ejecutar en bucles de espera
+
+    // Temporizadores por instrucciones (config.cycleTimers)
+    uint32_t timerCountdown;      // Instrucciones hasta el siguiente tick de DT/ST
+    uint32_t timerRemainder;      // Fracción acumulada del periodo (en 1/TIMER_FREQ de instrucción)
+
+    uint32_t rngState;            // Estado del generador de CXKK (xorshift32, nunca 0)
+};
+
+// Tamaño máximo de un estado guardado: cabecera y registros más la memoria y
+// la pantalla en el peor caso de la compresión (un byte de control por cada
+// 128 literales)
+#define CHIP8_STATE_MAX_SIZE (128 + MEMORY_SIZE + MEMORY_SIZE / 128 + \
+                              DISPLAY_HEIGHT * 8 + (DISPLAY_HEIGHT * 8) / 128)
 
 // Funciones principales del emulador
 void chip8Init(Chip8* chip8);
@@ -49,4 +113,57 @@ void chip8Cycle(Chip8* chip8);
 void chip8UpdateTimers(Chip8* chip8);
 void chip8SetKey(Chip8* chip8, uint8_t key, uint8_t value);
 
+// Ejecutar hasta maxCycles instrucciones o hasta el primer evento. Devuelve el
+// motivo de la parada y deja en chip8->runCycles las instrucciones ejecutadas.
+// Con config.cycleTimers también genera los ticks de DT/ST y, detenido en
+// FX0A, consume el presupuesto entero (el tiempo emulado sigue corriendo)
+Chip8RunResult chip8Run(Chip8* chip8, uint32_t maxCycles);
+
+// Temporizadores por instrucciones: DT y ST bajan cada clockSpeed / TIMER_FREQ
+// instrucciones ejecutadas en lugar de en cada chip8UpdateTimers, que pasa a
+// no hacer nada. La ejecución deja de depender del reloj del anfitrión
+void chip8SetCycleTimers(Chip8* chip8, bool enable);
+
+// Avanzar el reloj emulado cycles instrucciones (como mucho timerCountdown, que
+// con 0 queda planificado), aplicando el tick si se completa el periodo. Para
+// ejecutores externos como el JIT
+void chip8AdvanceTimers(Chip8* chip8, uint32_t cycles);
+
+// Vista de compatibilidad del framebuffer: 1 si el píxel (x, y) está encendido
+static inline uint8_t chip8GetPixel(const Chip8* chip8, int x, int y)
+{
+    return (chip8->gfxRows[y] >> (DISPLAY_WIDTH - 1 - x)) & 1;
+}
+
+// Expandir la pantalla a un byte por píxel (DISPLAY_WIDTH * DISPLAY_HEIGHT bytes,
+// índice x + y * DISPLAY_WIDTH), el formato del antiguo gfx[]
+void chip8GetFramebuffer(const Chip8* chip8, uint8_t* out);
+
+// Invalidar toda la caché de instrucciones (tras modificar la memoria desde fuera del núcleo)
+void chip8FlushCache(Chip8* chip8);
+
+// Sembrar el generador pseudoaleatorio de CXKK (chip8Init lo siembra con la hora)
+void chip8Seed(Chip8* chip8, uint32_t seed);
+
+// Guardar el estado de la máquina en buffer (CHIP8_STATE_MAX_SIZE bytes
+// bastan siempre). Devuelve los bytes escritos, o 0 si no caben. No incluye
+// Config: al restaurar se conserva la configuración actual
+size_t chip8SaveState(const Chip8* chip8, uint8_t* buffer, size_t size);
+
+// Como chip8SaveState pero sin comprimir. El resultado, que también lee
+// chip8LoadState, mide siempre lo mismo y cada campo ocupa siempre la misma
+// posición, así que dos estados se pueden comparar byte a byte (rebobinado)
+size_t chip8SaveStateRaw(const Chip8* chip8, uint8_t* buffer, size_t size);
+
+// Restaurar un estado guardado con chip8SaveState. Invalida las entradas de
+// la caché de instrucciones cuya memoria cambia; con el JIT hay que llamar
+// además a chip8JitFlush. Si los datos no son válidos devuelve false y el
+// núcleo no cambia. No usa memoria estática: se puede llamar a la vez desde
+// varios hilos con núcleos distintos
+bool chip8LoadState(Chip8* chip8, const uint8_t* buffer, size_t size);
+
+// Variantes en archivo de chip8SaveState y chip8LoadState
+bool chip8SaveStateFile(const Chip8* chip8, const char* filename);
+bool chip8LoadStateFile(Chip8* chip8, const char* filename);
+
 #endif // CHIP8_H
\ No newline at end of file
@@ -20,8 +20,9 @@
 #define DEFAULT_PIXEL_COLOR 0x00FF00FF  // Magenta
 
 // Configuraciones de emulación
-#define DEFAULT_SPEED 5  // Retardo en milisegundos entre instrucciones
+#define DEFAULT_SPEED 700  // Instrucciones por segundo (config.clockSpeed)
 #define TIMER_FREQ 60    // Frecuencia de actualización de timers (60Hz)
+#define IDLE_LOOP_MAX_LENGTH 16  // Instrucciones máximas de un bucle de espera detectable
 
 
 // Niveles de depuración
@@ -34,9 +35,10 @@ typedef enum {
 // Configuración global
 typedef struct {
     DebugLevel debugLevel;
-    int clockSpeed;
+    int clockSpeed;          // Instrucciones por segundo
     bool enableSound;
     uint32_t pixelColor;
+    bool cycleTimers;        // DT/ST cuentan instrucciones, no llamadas a chip8UpdateTimers
 } Config;
 
 #endif // CONFIG_H
\ No newline at end of file
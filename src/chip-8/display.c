@@ -1,12 +1,18 @@
 #include <stdio.h>
 #include <string.h>
 #include "display.h"
+#include "blit.h"
 
 // Inicializar el subsistema de visualización
 bool displayInit(Display* display, const char* title) {
     // Copiar título de la ventana
     strncpy(display->windowTitle, title, 255);
     display->windowTitle[255] = '\0';
+    display->lastColor = 0;
+    display->fullRefresh = true;
+    
+    // Tabla del kernel de expansión de píxeles
+    blitInit();
     
     // Crear ventana SDL
     display->window = SDL_CreateWindow(
@@ -62,12 +68,41 @@ bool displayInit(Display* display, const char* title) {
     return true;
 }
 
-// Renderizar el estado actual del emulador
-void displayRender(Display* display, Chip8* chip8, const char* colorArg) {
-    if (!chip8->drawFlag) {
-        return;  // No hay necesidad de actualizar la pantalla
+// Subir a la textura de streaming las filas marcadas en dirty. Se bloquea el
+// bloque entre la primera y la última fila modificadas y se expande cada fila
+// en su memoria respetando el pitch, sin buffer intermedio. Si el bloqueo falla
+// se usa un buffer temporal y SDL_UpdateTexture con el mismo rectángulo
+static void displayUpload(SDL_Texture* texture, const uint64_t* rows, uint32_t dirty, uint32_t color) {
+    if (dirty == 0) {
+        return;
     }
     
+    int first = __builtin_ctz(dirty);
+    int count = DISPLAY_HEIGHT - __builtin_clz(dirty) - first;
+    SDL_Rect rect = {0, first, DISPLAY_WIDTH, count};
+    void* locked;
+    int pitch;
+    
+    if (SDL_LockTexture(texture, &rect, &locked, &pitch) == 0) {
+        if (pitch == DISPLAY_WIDTH * (int)sizeof(uint32_t)) {
+            blitBitsToRGBA(locked, &rows[first], count, color);
+        } else {
+            for (int y = 0; y < count; y++) {
+                blitBitsToRGBA((uint32_t*)((uint8_t*)locked + y * pitch), &rows[first + y], 1, color);
+            }
+        }
+        SDL_UnlockTexture(texture);
+        return;
+    }
+    
+    uint32_t pixels[DISPLAY_WIDTH * DISPLAY_HEIGHT];
+    blitBitsToRGBA(pixels, &rows[first], count, color);
+    SDL_UpdateTexture(texture, &rect, pixels, DISPLAY_WIDTH * sizeof(uint32_t));
+}
+
+// Mostrar un frame publicado por el hilo de emulación. SDL_RenderPresent
+// espera al vsync: aquí solo se bloquea el hilo de presentación
+void displayRender(Display* display, const Frame* frame, const char* colorArg) {
     // Determinar el color del pixel
     uint32_t pixelColor;
     if (colorArg != NULL) {
@@ -75,33 +110,24 @@ void displayRender(Display* display, Chip8* chip8, const char* colorArg) {
         pixelColor = strtoul(colorArg, NULL, 16);
     } else {
         // Usar color predeterminado
-        pixelColor = chip8->config.pixelColor;
+        pixelColor = frame->pixelColor;
     }
     
-    // Crear buffer de pixels para la textura
-    uint32_t pixels[DISPLAY_WIDTH * DISPLAY_HEIGHT];
-    memset(pixels, 0, sizeof(pixels));  // Limpiar buffer con negro
-    
-    // Convertir el estado de gfx[] a pixeles con color
-    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
-        for (int x = 0; x < DISPLAY_WIDTH; x++) {
-            int index = x + (y * DISPLAY_WIDTH);
-            if (chip8->gfx[index] == 1) {
-                pixels[index] = pixelColor;
-            }
-        }
+    // El frame trae las filas cambiadas desde el último que se mostró,
+    // incluidas las de los frames descartados entre medias. Un cambio de
+    // color invalida la textura entera
+    uint32_t dirty = frame->dirtyRows;
+    if (display->fullRefresh || pixelColor != display->lastColor) {
+        dirty = UINT32_MAX;
+        display->lastColor = pixelColor;
+        display->fullRefresh = false;
     }
-    
-    // Actualizar textura con nuevos datos
-    SDL_UpdateTexture(display->texture, NULL, pixels, DISPLAY_WIDTH * sizeof(uint32_t));
+    displayUpload(display->texture, frame->rows, dirty, pixelColor);
     
     // Renderizar
     SDL_RenderClear(display->renderer);
     SDL_RenderCopy(display->renderer, display->texture, NULL, NULL);
     SDL_RenderPresent(display->renderer);
-    
-    // Restablecer flag de dibujo
-    chip8->drawFlag = false;
 }
 
 // Liberar recursos del subsistema de visualización
@@ -3,6 +3,7 @@
 
 #include <SDL2/SDL.h>
 #include "chip8.h"
+#include "frames.h"
 
 // Estructura para gestionar la visualización
 typedef struct {
@@ -10,11 +11,13 @@ typedef struct {
     SDL_Renderer* renderer;
     SDL_Texture* texture;
     char windowTitle[256];
+    uint32_t lastColor;             // Color del último render: si cambia se sube la pantalla entera
+    bool fullRefresh;               // La textura no refleja el último frame (recién creada)
 } Display;
 
 // Funciones de visualización
 bool displayInit(Display* display, const char* title);
-void displayRender(Display* display, Chip8* chip8, const char* colorArg);
+void displayRender(Display* display, const Frame* frame, const char* colorArg);
 void displayCleanup(Display* display);
 
 #endif // DISPLAY_H
\ No newline at end of file
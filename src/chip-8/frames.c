@@ -0,0 +1,48 @@
+#include <string.h>
+#include "frames.h"
+
+#define FRAMES_INDEX 0x3  // Bits del índice del buffer intermedio
+#define FRAMES_FRESH 0x4  // El intermedio contiene un frame que el lector no ha visto
+
+void framesInit(Frames* frames) {
+    memset(frames->buffers, 0, sizeof(frames->buffers));
+    frames->back = 0;
+    SDL_AtomicSet(&frames->middle, 1);
+    frames->front = 2;
+    frames->unseen = 0;
+}
+
+Frame* framesBack(Frames* frames) {
+    return &frames->buffers[frames->back];
+}
+
+void framesPublish(Frames* frames) {
+    Frame* frame = &frames->buffers[frames->back];
+    uint32_t rows = frame->dirtyRows;
+    frame->dirtyRows |= frames->unseen;
+
+    // SDL_AtomicSet es un intercambio con barrera completa: el contenido del
+    // buffer es visible para el lector antes que el nuevo índice
+    int previous = SDL_AtomicSet(&frames->middle, frames->back | FRAMES_FRESH);
+    frames->back = previous & FRAMES_INDEX;
+
+    // Si el lector tomó el frame anterior, solo queda sin ver este; si no, el
+    // anterior se descarta y sus filas siguen pendientes
+    frames->unseen = (previous & FRAMES_FRESH) ? frame->dirtyRows : rows;
+}
+
+const Frame* framesAcquire(Frames* frames) {
+    if ((SDL_AtomicGet(&frames->middle) & FRAMES_FRESH) == 0) {
+        return NULL;
+    }
+
+    // Entre la comprobación y el intercambio el escritor solo puede publicar
+    // otro frame, que también está marcado como nuevo
+    int previous = SDL_AtomicSet(&frames->middle, frames->front);
+    frames->front = previous & FRAMES_INDEX;
+    return &frames->buffers[frames->front];
+}
+
+const Frame* framesFront(const Frames* frames) {
+    return &frames->buffers[frames->front];
+}
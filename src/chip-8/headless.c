@@ -0,0 +1,286 @@
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "chip8.h"
+#include "replay.h"
+#ifdef CHIP8_JIT
+#include "jit.h"
+#endif
+
+// Ejecutor sin SDL: carga una ROM, la ejecuta a máxima velocidad durante N
+// ciclos o N frames e informa de instrucciones por segundo, frames por segundo
+// y un hash del framebuffer final. Pensado para medir el rendimiento en CI y
+// para servidores sin pantalla.
+//
+// Con -i reproduce una partida grabada con el frontend (CHIP8_RECORD): la
+// semilla, la velocidad y los temporizadores salen de la grabación y cada
+// evento de entrada se aplica en el frame y la instrucción en que se grabó.
+
+#define HEADLESS_CYCLES_PER_FRAME 12  // ~700 instrucciones/s a 60 Hz, como main.c
+#define HEADLESS_DEFAULT_FRAMES 600   // 10 segundos de emulación
+#define HEADLESS_DEFAULT_SEED 1       // Semilla fija: el hash final es reproducible
+
+static void usage(const char* prog) {
+    printf("Uso: %s <archivo-rom> [opciones]\n", prog);
+    printf("  -c <n>     Ejecutar n ciclos\n");
+    printf("  -f <n>     Ejecutar n frames (por defecto %d)\n", HEADLESS_DEFAULT_FRAMES);
+    printf("  -r <n>     Instrucciones por frame (por defecto %d)\n", HEADLESS_CYCLES_PER_FRAME);
+    printf("  -s <n>     Semilla de CXKK (por defecto %d)\n", HEADLESS_DEFAULT_SEED);
+    printf("  -p <pbm>   Guardar el framebuffer final como PBM\n");
+    printf("  -t         Temporizadores por instrucciones (un tick cada -r instrucciones)\n");
+    printf("  -i <log>   Reproducir una partida grabada (por defecto hasta su final)\n");
+#ifdef CHIP8_JIT
+    printf("  -j         Usar el recompilador dinámico\n");
+#endif
+}
+
+#ifdef CHIP8_JIT
+// Recompilador (-j). Fuera de la pila y compartido con runTo
+static Chip8Jit jit;
+static bool useJit;
+#endif
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Hash FNV-1a de 64 bits de la pantalla, sobre la vista de un byte por píxel
+// para que el valor no dependa de la representación interna
+static uint64_t hashFramebuffer(const Chip8* chip8) {
+    uint8_t pixels[DISPLAY_WIDTH * DISPLAY_HEIGHT];
+    uint64_t hash = 0xCBF29CE484222325ULL;
+
+    chip8GetFramebuffer(chip8, pixels);
+    for (int i = 0; i < DISPLAY_WIDTH * DISPLAY_HEIGHT; i++) {
+        hash ^= pixels[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+// Avanzar el frame desde la instrucción *position hasta target, como
+// emulationRunTo en main.c. Una espera de tecla (FX0A) descarta el resto del
+// tramo: solo la puede despertar un evento grabado. Devuelve las
+// instrucciones ejecutadas
+static uint64_t runTo(Chip8* chip8, uint32_t* position, uint32_t target) {
+    uint64_t executed = 0;
+
+#ifdef CHIP8_JIT
+    if (useJit) {
+        if (*position < target) {
+            executed = chip8JitExecute(&jit, chip8, target - *position);
+        }
+        *position = target;
+        return executed;
+    }
+#endif
+    while (*position < target) {
+        Chip8RunResult result = chip8Run(chip8, target - *position);
+        executed += chip8->runCycles;
+        *position += chip8->runCycles;
+        if (result == CHIP8_RUN_KEY_WAIT) {
+            break;
+        }
+    }
+    *position = target;
+    return executed;
+}
+
+// Guardar la pantalla como PBM binario (P4): 1 = píxel encendido
+static bool writePBM(const Chip8* chip8, const char* filename) {
+    FILE* file = fopen(filename, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "Error: No se pudo crear el archivo %s\n", filename);
+        return false;
+    }
+
+    // Las filas empaquetadas ya tienen el formato de P4 (columna 0 en el bit alto)
+    fprintf(file, "P4\n%d %d\n", DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        uint8_t row[DISPLAY_WIDTH / 8];
+        for (int i = 0; i < DISPLAY_WIDTH / 8; i++) {
+            row[i] = (uint8_t)(chip8->gfxRows[y] >> (DISPLAY_WIDTH - 8 - 8 * i));
+        }
+        fwrite(row, 1, sizeof(row), file);
+    }
+
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const char* romPath = argv[1];
+    const char* pbmPath = NULL;
+    const char* replayPath = NULL;
+    uint64_t maxCycles = 0;
+    uint64_t maxFrames = HEADLESS_DEFAULT_FRAMES;
+    uint32_t cyclesPerFrame = HEADLESS_CYCLES_PER_FRAME;
+    unsigned int seed = HEADLESS_DEFAULT_SEED;
+    bool wantJit = false;
+    bool cycleTimers = false;
+    bool lengthGiven = false;  // -c o -f: si no, una grabación se reproduce entera
+
+    for (int i = 2; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "-c") == 0 && hasValue) {
+            maxCycles = strtoull(argv[++i], NULL, 10);
+            maxFrames = 0;
+            lengthGiven = true;
+        } else if (strcmp(argv[i], "-f") == 0 && hasValue) {
+            maxFrames = strtoull(argv[++i], NULL, 10);
+            maxCycles = 0;
+            lengthGiven = true;
+        } else if (strcmp(argv[i], "-r") == 0 && hasValue) {
+            cyclesPerFrame = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-s") == 0 && hasValue) {
+            seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-p") == 0 && hasValue) {
+            pbmPath = argv[++i];
+        } else if (strcmp(argv[i], "-i") == 0 && hasValue) {
+            replayPath = argv[++i];
+        } else if (strcmp(argv[i], "-t") == 0) {
+            cycleTimers = true;
+        } else if (strcmp(argv[i], "-j") == 0) {
+            wantJit = true;
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // El presupuesto de cada frame de una grabación lo fija su velocidad
+    if (replayPath != NULL && maxCycles > 0) {
+        fprintf(stderr, "Error: Con -i la duración se indica con -f\n");
+        return EXIT_FAILURE;
+    }
+
+    if (cyclesPerFrame == 0) {
+        fprintf(stderr, "Error: Se necesita al menos una instrucción por frame\n");
+        return EXIT_FAILURE;
+    }
+
+    // La estructura incluye la caché de instrucciones: mejor fuera de la pila
+    static Chip8 chip8;
+    static Replay replay;
+    if (replayPath != NULL) {
+        if (!replayLoad(&replay, replayPath)) {
+            return EXIT_FAILURE;
+        }
+        seed = replay.seed;
+        cycleTimers = replay.cycleTimers;
+        if (!lengthGiven) {
+            maxFrames = replayLength(&replay);
+        }
+    }
+
+    chip8Init(&chip8);
+    chip8Seed(&chip8, seed);  // chip8Init siembra con la hora
+    if (!chip8LoadROM(&chip8, romPath)) {
+        return EXIT_FAILURE;
+    }
+
+    // Un frame = 1/60 s de tiempo emulado: con -t los ticks de DT/ST los genera
+    // el núcleo cada cyclesPerFrame instrucciones en lugar del bucle de frames
+    chip8.config.clockSpeed = (int)(cyclesPerFrame * TIMER_FREQ);
+    if (replayPath != NULL) {
+        chip8.config.clockSpeed = (int)replay.clockSpeed;
+    }
+    if (cycleTimers) {
+        chip8SetCycleTimers(&chip8, true);
+    }
+
+#ifdef CHIP8_JIT
+    useJit = wantJit && chip8JitInit(&jit, getenv("CHIP8_PERF_MAP") != NULL);
+#else
+    if (wantJit) {
+        fprintf(stderr, "Aviso: compilado sin JIT, se usa el intérprete\n");
+    }
+#endif
+
+    // Con -c se ejecutan los frames necesarios para cubrir los ciclos pedidos
+    if (maxCycles > 0) {
+        maxFrames = (maxCycles + cyclesPerFrame - 1) / cyclesPerFrame;
+    }
+
+    uint64_t executed = 0;
+    uint64_t frames = 0;
+    double start = nowSeconds();
+
+    uint32_t cycleRemainder = 0;  // Como en main.c, en 1/TIMER_FREQ de instrucción
+
+    while (frames < maxFrames) {
+        uint32_t budget = cyclesPerFrame;
+        if (replayPath != NULL) {
+            // Mismo reparto que el frontend: clockSpeed / TIMER_FREQ más lo que sobró
+            cycleRemainder += replay.clockSpeed;
+            budget = cycleRemainder / TIMER_FREQ;
+            cycleRemainder %= TIMER_FREQ;
+        } else if (maxCycles > 0 && maxCycles - frames * cyclesPerFrame < budget) {
+            budget = (uint32_t)(maxCycles - frames * cyclesPerFrame);
+        }
+
+        // Aplicar los eventos grabados del frame en su instrucción y ejecutar
+        // el resto del presupuesto
+        uint32_t position = 0;
+        uint32_t nextAt = 0;
+        ReplayEvent event;
+        while (replayNext(&replay, frames, &event)) {
+            uint32_t at = replaySpaceEvent(event.at, event.type, budget, &nextAt);
+            executed += runTo(&chip8, &position, at);
+            replayApply(&replay, &chip8, &event);
+#ifdef CHIP8_JIT
+            // El reinicio borra la memoria: el código generado ya no vale
+            if (event.type == REPLAY_RESET && useJit) {
+                chip8JitFlush(&jit);
+            }
+#endif
+        }
+        executed += runTo(&chip8, &position, budget);
+
+        chip8UpdateTimers(&chip8);  // Sin efecto con -t
+        frames++;
+    }
+
+    double elapsed = nowSeconds() - start;
+    if (elapsed <= 0) {
+        elapsed = 1e-9;
+    }
+
+    printf("ROM:            %s\n", romPath);
+    if (replayPath != NULL) {
+        printf("Grabación:      %s (%zu eventos)\n", replayPath, replay.count);
+    }
+    printf("Frames:         %llu\n", (unsigned long long)frames);
+    printf("Instrucciones:  %llu (%llu acreditadas en bucles de espera)\n",
+           (unsigned long long)executed, (unsigned long long)chip8.idleCycles);
+    printf("Tiempo:         %.3f s\n", elapsed);
+    printf("IPS:            %.0f\n", executed / elapsed);
+    printf("FPS:            %.1f\n", frames / elapsed);
+    printf("Hash pantalla:  %016llx\n", (unsigned long long)hashFramebuffer(&chip8));
+    if (chip8.waitingKey) {
+        printf("Estado:         esperando tecla (FX0A)\n");
+    }
+
+#ifdef CHIP8_JIT
+    if (useJit) {
+        chip8JitShutdown(&jit);
+    }
+#endif
+
+    replayFree(&replay);
+
+    if (pbmPath != NULL && !writePBM(&chip8, pbmPath)) {
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
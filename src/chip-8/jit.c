@@ -0,0 +1,1018 @@
+#define _DEFAULT_SOURCE
+#include "jit.h"
+
+#if defined(CHIP8_JIT) && defined(__x86_64__)
+
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// ============================================================================
+// EMISIÓN DE CÓDIGO x86-64
+// ============================================================================
+//
+// Convenio del código generado (System V):
+//  - rdi apunta a la estructura Chip8 durante todo el bloque
+//  - rax y rcx son temporales
+//  - los registros V usados por el bloque se cargan en hostRegs al entrar y
+//    se vuelcan a chip8->V al salir
+//  - eax devuelve el número de instrucciones CHIP-8 ejecutadas
+
+enum {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15
+};
+
+// Registros anfitriones para los V: primero los volátiles, que no hay que preservar
+static const uint8_t hostRegs[] = {
+    RDX, RSI, R8, R9, R10, R11,     // Volátiles
+    RBX, RBP, R12, R13, R14, R15    // Preservados por el llamado (push/pop)
+};
+#define HOST_REG_COUNT ((int)sizeof(hostRegs))
+#define HOST_VOLATILE_COUNT 6
+
+// Códigos de operación ALU de 8 bits (forma r/m8, r8)
+#define ALU_ADD 0x00
+#define ALU_OR  0x08
+#define ALU_AND 0x20
+#define ALU_SUB 0x28
+#define ALU_XOR 0x30
+#define ALU_CMP 0x38
+
+// Condiciones para SETcc (segundo byte tras 0x0F)
+#define CC_B  0x92                  // Acarreo
+#define CC_E  0x94
+#define CC_NE 0x95
+#define CC_A  0x97                  // Mayor sin signo
+
+#define OFF_OPCODE ((uint32_t)offsetof(Chip8, opcode))
+#define OFF_MEMORY ((uint32_t)offsetof(Chip8, memory))
+#define OFF_V      ((uint32_t)offsetof(Chip8, V))
+#define OFF_I      ((uint32_t)offsetof(Chip8, I))
+#define OFF_PC     ((uint32_t)offsetof(Chip8, PC))
+#define OFF_DT     ((uint32_t)offsetof(Chip8, delayTimer))
+#define OFF_ST     ((uint32_t)offsetof(Chip8, soundTimer))
+#define OFF_STACK  ((uint32_t)offsetof(Chip8, stack))
+#define OFF_SP     ((uint32_t)offsetof(Chip8, SP))
+#define OFF_KEY    ((uint32_t)offsetof(Chip8, key))
+
+// Espacio que se garantiza libre antes de compilar un bloque
+#define JIT_BLOCK_RESERVE 8192
+
+typedef struct {
+    uint8_t* p;                     // Siguiente byte a escribir
+} Emitter;
+
+static void emit8(Emitter* e, uint8_t b)
+{
+    *e->p++ = b;
+}
+
+static void emit16(Emitter* e, uint16_t v)
+{
+    memcpy(e->p, &v, 2);
+    e->p += 2;
+}
+
+static void emit32(Emitter* e, uint32_t v)
+{
+    memcpy(e->p, &v, 4);
+    e->p += 4;
+}
+
+// Prefijo REX sin W. Se emite siempre en accesos de byte para que los
+// registros 4-7 sean spl/bpl/sil/dil en lugar de ah/ch/dh/bh.
+static void emitRex(Emitter* e, int reg, int rm)
+{
+    emit8(e, 0x40 | ((reg >> 3) & 1) << 2 | ((rm >> 3) & 1));
+}
+
+static void emitModRM(Emitter* e, int mod, int reg, int rm)
+{
+    emit8(e, (uint8_t)(mod << 6 | (reg & 7) << 3 | (rm & 7)));
+}
+
+// movzx r32, byte [rdi + off]
+static void emitLoadByte(Emitter* e, int dst, uint32_t off)
+{
+    emitRex(e, dst, RDI);
+    emit8(e, 0x0F);
+    emit8(e, 0xB6);
+    emitModRM(e, 2, dst, RDI);
+    emit32(e, off);
+}
+
+// mov byte [rdi + off], r8
+static void emitStoreByte(Emitter* e, int src, uint32_t off)
+{
+    emitRex(e, src, RDI);
+    emit8(e, 0x88);
+    emitModRM(e, 2, src, RDI);
+    emit32(e, off);
+}
+
+// mov r8, byte [rdi + rax + off]
+static void emitLoadByteIndexed(Emitter* e, int dst, uint32_t off)
+{
+    emitRex(e, dst, RDI);
+    emit8(e, 0x8A);
+    emitModRM(e, 2, dst, 4);
+    emit8(e, (RAX << 3) | RDI);     // SIB: índice rax, escala 1, base rdi
+    emit32(e, off);
+}
+
+// mov dst8, src8
+static void emitMovReg8(Emitter* e, int dst, int src)
+{
+    emitRex(e, src, dst);
+    emit8(e, 0x88);
+    emitModRM(e, 3, src, dst);
+}
+
+// op dst8, src8
+static void emitAluReg8(Emitter* e, uint8_t op, int dst, int src)
+{
+    emitRex(e, src, dst);
+    emit8(e, op);
+    emitModRM(e, 3, src, dst);
+}
+
+// op dst8, imm8 (digit = extensión de opcode del grupo 0x80)
+static void emitAluImm8(Emitter* e, int digit, int dst, uint8_t imm)
+{
+    emitRex(e, 0, dst);
+    emit8(e, 0x80);
+    emitModRM(e, 3, digit, dst);
+    emit8(e, imm);
+}
+
+// mov dst8, imm8
+static void emitMovImm8(Emitter* e, int dst, uint8_t imm)
+{
+    emitRex(e, 0, dst);
+    emit8(e, 0xB0 + (dst & 7));
+    emit8(e, imm);
+}
+
+// setcc dst8
+static void emitSetcc(Emitter* e, uint8_t cc, int dst)
+{
+    emitRex(e, 0, dst);
+    emit8(e, 0x0F);
+    emit8(e, cc);
+    emitModRM(e, 3, 0, dst);
+}
+
+// Desplazamiento de un bit (digit 4 = shl, 5 = shr)
+static void emitShift1(Emitter* e, int digit, int dst)
+{
+    emitRex(e, 0, dst);
+    emit8(e, 0xD0);
+    emitModRM(e, 3, digit, dst);
+}
+
+// shr dst8, imm8
+static void emitShrImm(Emitter* e, int dst, uint8_t imm)
+{
+    emitRex(e, 0, dst);
+    emit8(e, 0xC0);
+    emitModRM(e, 3, 5, dst);
+    emit8(e, imm);
+}
+
+// movzx eax, src8
+static void emitZeroExtendToEax(Emitter* e, int src)
+{
+    emitRex(e, RAX, src);
+    emit8(e, 0x0F);
+    emit8(e, 0xB6);
+    emitModRM(e, 3, RAX, src);
+}
+
+// mov word [rdi + off], imm16
+static void emitStoreWordImm(Emitter* e, uint32_t off, uint16_t imm)
+{
+    emit8(e, 0x66);
+    emit8(e, 0xC7);
+    emitModRM(e, 2, 0, RDI);
+    emit32(e, off);
+    emit16(e, imm);
+}
+
+// mov word [rdi + off], ax
+static void emitStoreWordAx(Emitter* e, uint32_t off)
+{
+    emit8(e, 0x66);
+    emit8(e, 0x89);
+    emitModRM(e, 2, RAX, RDI);
+    emit32(e, off);
+}
+
+// movzx eax, word [rdi + off]
+static void emitLoadWordEax(Emitter* e, uint32_t off)
+{
+    emit8(e, 0x0F);
+    emit8(e, 0xB7);
+    emitModRM(e, 2, RAX, RDI);
+    emit32(e, off);
+}
+
+static void emitPush(Emitter* e, int reg)
+{
+    if (reg >= 8)
+    {
+        emit8(e, 0x41);
+    }
+    emit8(e, 0x50 + (reg & 7));
+}
+
+static void emitPop(Emitter* e, int reg)
+{
+    if (reg >= 8)
+    {
+        emit8(e, 0x41);
+    }
+    emit8(e, 0x58 + (reg & 7));
+}
+
+// PC = pc + 2 + (cl ? 2 : 0), a partir de ecx ya puesto a 0/1
+static void emitSkipPC(Emitter* e, uint16_t pc)
+{
+    // lea eax, [rcx*2 + pc + 2]
+    emit8(e, 0x8D);
+    emit8(e, 0x04);
+    emit8(e, 0x4D);
+    emit32(e, (uint32_t)pc + 2);
+    emitStoreWordAx(e, OFF_PC);
+}
+
+// ============================================================================
+// ANÁLISIS DE BLOQUES
+// ============================================================================
+
+typedef enum {
+    JIT_OP_INTERP,                  // Se ejecuta con chip8Cycle
+    JIT_OP_NATIVE,                  // Se traduce y el bloque continúa
+    JIT_OP_BRANCH                   // Se traduce y cierra el bloque
+} JitOpKind;
+
+#define VBIT(r) ((uint16_t)(1u << (r)))
+
+// Clasificar un opcode y calcular qué registros V usa y cuáles escribe
+static JitOpKind jitClassify(uint16_t opcode, uint16_t* used, uint16_t* written)
+{
+    uint8_t x = (opcode & 0x0F00) >> 8;
+    uint8_t y = (opcode & 0x00F0) >> 4;
+    uint8_t n = opcode & 0x000F;
+    uint8_t kk = opcode & 0x00FF;
+
+    *used = 0;
+    *written = 0;
+
+    switch (opcode & 0xF000)
+    {
+    case 0x0000:
+        if (kk == 0xE0)
+        {
+            return JIT_OP_INTERP;
+        }
+        return (kk == 0xEE) ? JIT_OP_BRANCH : JIT_OP_NATIVE;
+
+    case 0x1000:
+    case 0x2000:
+        return JIT_OP_BRANCH;
+
+    case 0x3000:
+    case 0x4000:
+        *used = VBIT(x);
+        return JIT_OP_BRANCH;
+
+    case 0x5000:
+    case 0x9000:
+        if (n != 0)
+        {
+            return JIT_OP_NATIVE;
+        }
+        *used = VBIT(x) | VBIT(y);
+        return JIT_OP_BRANCH;
+
+    case 0x6000:
+    case 0x7000:
+        *used = *written = VBIT(x);
+        return JIT_OP_NATIVE;
+
+    case 0x8000:
+        switch (n)
+        {
+        case 0x0: case 0x1: case 0x2: case 0x3:
+            *used = VBIT(x) | VBIT(y);
+            *written = VBIT(x);
+            break;
+        case 0x4: case 0x5: case 0x7:
+            *used = VBIT(x) | VBIT(y) | VBIT(0xF);
+            *written = VBIT(x) | VBIT(0xF);
+            break;
+        case 0x6: case 0xE:
+            *used = *written = VBIT(x) | VBIT(0xF);
+            break;
+        }
+        return JIT_OP_NATIVE;
+
+    case 0xA000:
+        return JIT_OP_NATIVE;
+
+    case 0xB000:
+        *used = VBIT(0);
+        return JIT_OP_BRANCH;
+
+    case 0xC000:
+    case 0xD000:
+        return JIT_OP_INTERP;
+
+    case 0xE000:
+        if (kk == 0x9E || kk == 0xA1)
+        {
+            *used = VBIT(x);
+            return JIT_OP_BRANCH;
+        }
+        return JIT_OP_NATIVE;
+
+    case 0xF000:
+        switch (kk)
+        {
+        case 0x07:
+            *used = *written = VBIT(x);
+            break;
+        case 0x15: case 0x18: case 0x1E: case 0x29:
+            *used = VBIT(x);
+            break;
+        case 0x65:
+            *used = *written = (uint16_t)((1u << (x + 1)) - 1);
+            break;
+        case 0x0A: case 0x33: case 0x55:
+            return JIT_OP_INTERP;
+        }
+        return JIT_OP_NATIVE;
+    }
+
+    return JIT_OP_INTERP;
+}
+
+static int popCount16(uint16_t v)
+{
+    int count = 0;
+    while (v)
+    {
+        v &= v - 1;
+        count++;
+    }
+    return count;
+}
+
+// ============================================================================
+// TRADUCCIÓN
+// ============================================================================
+
+// Salida anticipada pendiente de enlazar (FX65 con I fuera de rango)
+typedef struct {
+    uint8_t* jump;                  // rel32 del salto condicional
+    uint16_t pc;                    // Dirección de la instrucción no ejecutada
+    uint16_t lastOpcode;            // Opcode de la instrucción anterior
+    uint8_t executed;               // Instrucciones ejecutadas antes de salir
+} JitSideExit;
+
+// Traducir una instrucción; hostOf[v] es el registro anfitrión de Vv
+static void jitEmitInstr(Emitter* e, const int8_t* hostOf, uint16_t opcode, uint16_t pc,
+                         JitSideExit* exits, int* exitCount, uint8_t executed, uint16_t lastOpcode)
+{
+    uint8_t x = (opcode & 0x0F00) >> 8;
+    uint8_t y = (opcode & 0x00F0) >> 4;
+    uint8_t n = opcode & 0x000F;
+    uint8_t kk = opcode & 0x00FF;
+    uint16_t nnn = opcode & 0x0FFF;
+    int rx = hostOf[x];
+    int ry = hostOf[y];
+    int rf = hostOf[0xF];
+
+    switch (opcode & 0xF000)
+    {
+    case 0x0000:
+        if (kk == 0xEE) // 00EE: SP--, PC = stack[SP]
+        {
+            emit8(e, 0x66);
+            emit8(e, 0xFF);
+            emitModRM(e, 2, 1, RDI); // dec word [rdi + SP]
+            emit32(e, OFF_SP);
+            emitLoadWordEax(e, OFF_SP);
+            emit8(e, 0x0F);
+            emit8(e, 0xB7);
+            emitModRM(e, 2, RAX, 4); // movzx eax, word [rdi + rax*2 + stack]
+            emit8(e, 0x40 | (RAX << 3) | RDI);
+            emit32(e, OFF_STACK);
+            emitStoreWordAx(e, OFF_PC);
+        }
+        break;
+
+    case 0x1000: // 1NNN
+        emitStoreWordImm(e, OFF_PC, nnn);
+        break;
+
+    case 0x2000: // 2NNN: stack[SP] = PC, SP++, PC = NNN
+        emitLoadWordEax(e, OFF_SP);
+        emit8(e, 0x66);
+        emit8(e, 0xC7);
+        emitModRM(e, 2, 0, 4); // mov word [rdi + rax*2 + stack], imm16
+        emit8(e, 0x40 | (RAX << 3) | RDI);
+        emit32(e, OFF_STACK);
+        emit16(e, (uint16_t)(pc + 2));
+        emit8(e, 0xFF);
+        emit8(e, 0xC0); // inc eax: SP + 1 a partir del valor leído, como el intérprete
+        emitStoreWordAx(e, OFF_SP);
+        emitStoreWordImm(e, OFF_PC, nnn);
+        break;
+
+    case 0x3000: // 3XKK / 4XKK
+    case 0x4000:
+        emit8(e, 0x31);
+        emit8(e, 0xC9); // xor ecx, ecx
+        emitAluImm8(e, 7, rx, kk);
+        emitSetcc(e, (opcode & 0xF000) == 0x3000 ? CC_E : CC_NE, RCX);
+        emitSkipPC(e, pc);
+        break;
+
+    case 0x5000: // 5XY0 / 9XY0
+    case 0x9000:
+        if (n == 0)
+        {
+            emit8(e, 0x31);
+            emit8(e, 0xC9);
+            emitAluReg8(e, ALU_CMP, rx, ry);
+            emitSetcc(e, (opcode & 0xF000) == 0x5000 ? CC_E : CC_NE, RCX);
+            emitSkipPC(e, pc);
+        }
+        break;
+
+    case 0x6000: // 6XKK
+        emitMovImm8(e, rx, kk);
+        break;
+
+    case 0x7000: // 7XKK
+        emitAluImm8(e, 0, rx, kk);
+        break;
+
+    case 0x8000:
+        switch (n)
+        {
+        case 0x0:
+            emitMovReg8(e, rx, ry);
+            break;
+        case 0x1:
+            emitAluReg8(e, ALU_OR, rx, ry);
+            break;
+        case 0x2:
+            emitAluReg8(e, ALU_AND, rx, ry);
+            break;
+        case 0x3:
+            emitAluReg8(e, ALU_XOR, rx, ry);
+            break;
+        case 0x4: // VF = acarreo de VX + VY, después VX = suma
+            emitMovReg8(e, RAX, rx);
+            emitAluReg8(e, ALU_ADD, RAX, ry);
+            emitSetcc(e, CC_B, RCX);
+            emitMovReg8(e, rf, RCX);
+            emitMovReg8(e, rx, RAX);
+            break;
+        case 0x5: // VF = VX > VY, después VX -= VY (con VF ya actualizado)
+            emitAluReg8(e, ALU_CMP, rx, ry);
+            emitSetcc(e, CC_A, RAX);
+            emitMovReg8(e, rf, RAX);
+            emitAluReg8(e, ALU_SUB, rx, ry);
+            break;
+        case 0x6:
+            emitMovReg8(e, RAX, rx);
+            emitAluImm8(e, 4, RAX, 1);
+            emitMovReg8(e, rf, RAX);
+            emitShift1(e, 5, rx);
+            break;
+        case 0x7: // VF = VY > VX, después VX = VY - VX
+            emitAluReg8(e, ALU_CMP, ry, rx);
+            emitSetcc(e, CC_A, RAX);
+            emitMovReg8(e, rf, RAX);
+            emitMovReg8(e, RAX, ry);
+            emitAluReg8(e, ALU_SUB, RAX, rx);
+            emitMovReg8(e, rx, RAX);
+            break;
+        case 0xE:
+            emitMovReg8(e, RAX, rx);
+            emitShrImm(e, RAX, 7);
+            emitMovReg8(e, rf, RAX);
+            emitShift1(e, 4, rx);
+            break;
+        }
+        break;
+
+    case 0xA000: // ANNN
+        emitStoreWordImm(e, OFF_I, nnn);
+        break;
+
+    case 0xB000: // BNNN: PC = NNN + V0
+        emitZeroExtendToEax(e, hostOf[0]);
+        emit8(e, 0x05); // add eax, imm32
+        emit32(e, nnn);
+        emitStoreWordAx(e, OFF_PC);
+        break;
+
+    case 0xE000: // EX9E / EXA1
+        if (kk == 0x9E || kk == 0xA1)
+        {
+            emit8(e, 0x31);
+            emit8(e, 0xC9);
+            emitZeroExtendToEax(e, rx);
+            emit8(e, 0x80); // cmp byte [rdi + rax + key], 0
+            emitModRM(e, 2, 7, 4);
+            emit8(e, (RAX << 3) | RDI);
+            emit32(e, OFF_KEY);
+            emit8(e, 0x00);
+            emitSetcc(e, kk == 0x9E ? CC_NE : CC_E, RCX);
+            emitSkipPC(e, pc);
+        }
+        break;
+
+    case 0xF000:
+        switch (kk)
+        {
+        case 0x07:
+            emitLoadByte(e, rx, OFF_DT);
+            break;
+        case 0x15:
+            emitStoreByte(e, rx, OFF_DT);
+            break;
+        case 0x18:
+            emitStoreByte(e, rx, OFF_ST);
+            break;
+        case 0x1E: // I += VX
+            emitZeroExtendToEax(e, rx);
+            emit8(e, 0x66);
+            emit8(e, 0x01);
+            emitModRM(e, 2, RAX, RDI);
+            emit32(e, OFF_I);
+            break;
+        case 0x29: // I = VX * 5
+            emitZeroExtendToEax(e, rx);
+            emit8(e, 0x8D);
+            emit8(e, 0x04);
+            emit8(e, 0x80); // lea eax, [rax + rax*4]
+            emitStoreWordAx(e, OFF_I);
+            break;
+        case 0x65: // V0..VX = memory[I..I+X]; si se sale de la memoria, lo hace el intérprete
+        {
+            JitSideExit* exit = &exits[(*exitCount)++];
+
+            emitLoadWordEax(e, OFF_I);
+            emit8(e, 0x3D); // cmp eax, imm32
+            emit32(e, (uint32_t)(MEMORY_SIZE - 1 - x));
+            emit8(e, 0x0F);
+            emit8(e, 0x87); // ja salida
+            exit->jump = e->p;
+            exit->pc = pc;
+            exit->lastOpcode = lastOpcode;
+            exit->executed = executed;
+            emit32(e, 0);
+
+            for (int i = 0; i <= x; i++)
+            {
+                emitLoadByteIndexed(e, hostOf[i], OFF_MEMORY + (uint32_t)i);
+            }
+            break;
+        }
+        }
+        break;
+    }
+}
+
+// Registrar un bloque (o marca de intérprete) y las direcciones que cubre
+static void jitRegisterBlock(Chip8Jit* jit, uint16_t start, uint16_t end, uint8_t count,
+                             uint8_t state, Chip8JitCode code)
+{
+    Chip8JitBlock* block = &jit->blocks[start];
+
+    block->code = code;
+    block->end = end;
+    block->count = count;
+    block->state = state;
+
+    for (uint32_t a = start; a < end; a++)
+    {
+        jit->codeRef[a]++;
+    }
+}
+
+// Traducir el bloque que empieza en start
+static void jitCompile(Chip8Jit* jit, Chip8* chip8, uint16_t start)
+{
+    uint16_t opcodes[JIT_MAX_BLOCK];
+    int8_t hostOf[REGISTER_COUNT];
+    uint16_t used = 0;
+    uint16_t written = 0;
+    int count = 0;
+    bool branch = false;
+    uint16_t pc = start;
+
+    // Análisis: recorrer el bloque hasta un salto, una instrucción que no se
+    // traduce o hasta quedarse sin registros anfitriones
+    while (count < JIT_MAX_BLOCK && pc < MEMORY_SIZE - 1)
+    {
+        uint16_t opcode = (chip8->memory[pc] << 8) | chip8->memory[pc + 1];
+        uint16_t opUsed, opWritten;
+
+        if (jit->pageWrites[pc >> JIT_PAGE_SHIFT] >= JIT_SMC_LIMIT ||
+            jit->pageWrites[(pc + 1) >> JIT_PAGE_SHIFT] >= JIT_SMC_LIMIT)
+        {
+            break; // Página automodificable: se queda en el intérprete
+        }
+
+        JitOpKind kind = jitClassify(opcode, &opUsed, &opWritten);
+        if (kind == JIT_OP_INTERP || popCount16(used | opUsed) > HOST_REG_COUNT)
+        {
+            break;
+        }
+
+        used |= opUsed;
+        written |= opWritten;
+        opcodes[count++] = opcode;
+        pc += 2;
+
+        if (kind == JIT_OP_BRANCH)
+        {
+            branch = true;
+            break;
+        }
+    }
+
+    if (count == 0)
+    {
+        jitRegisterBlock(jit, start, (uint16_t)(start + 2), 0, JIT_BLOCK_INTERP, NULL);
+        return;
+    }
+
+    if (jit->codeUsed + JIT_BLOCK_RESERVE > JIT_CODE_SIZE)
+    {
+        chip8JitFlush(jit);
+        jit->stats.flushes++;
+    }
+
+    // Asignación de registros
+    int allocated = 0;
+    for (int v = 0; v < REGISTER_COUNT; v++)
+    {
+        hostOf[v] = (used & VBIT(v)) ? (int8_t)hostRegs[allocated++] : -1;
+    }
+
+    Emitter e = { jit->codeBuffer + jit->codeUsed };
+    uint8_t* entry = e.p;
+    JitSideExit exits[JIT_MAX_BLOCK];
+    int exitCount = 0;
+
+    // Prólogo: preservar registros del llamado y cargar los V usados
+    for (int i = HOST_VOLATILE_COUNT; i < allocated; i++)
+    {
+        emitPush(&e, hostRegs[i]);
+    }
+    for (int v = 0; v < REGISTER_COUNT; v++)
+    {
+        if (hostOf[v] >= 0)
+        {
+            emitLoadByte(&e, hostOf[v], OFF_V + (uint32_t)v);
+        }
+    }
+
+    // Cuerpo
+    for (int i = 0; i < count; i++)
+    {
+        jitEmitInstr(&e, hostOf, opcodes[i], (uint16_t)(start + i * 2), exits, &exitCount,
+                     (uint8_t)i, i > 0 ? opcodes[i - 1] : 0);
+    }
+    if (!branch)
+    {
+        emitStoreWordImm(&e, OFF_PC, pc);
+    }
+    emitStoreWordImm(&e, OFF_OPCODE, opcodes[count - 1]);
+    emit8(&e, 0xB8); // mov eax, count
+    emit32(&e, (uint32_t)count);
+
+    // Epílogo común: volcar los V modificados y restaurar registros
+    uint8_t* epilogue = e.p;
+    for (int v = 0; v < REGISTER_COUNT; v++)
+    {
+        if (written & VBIT(v))
+        {
+            emitStoreByte(&e, hostOf[v], OFF_V + (uint32_t)v);
+        }
+    }
+    for (int i = allocated - 1; i >= HOST_VOLATILE_COUNT; i--)
+    {
+        emitPop(&e, hostRegs[i]);
+    }
+    emit8(&e, 0xC3); // ret
+
+    // Salidas anticipadas: dejar PC en la instrucción pendiente
+    for (int i = 0; i < exitCount; i++)
+    {
+        int32_t rel = (int32_t)(e.p - (exits[i].jump + 4));
+        memcpy(exits[i].jump, &rel, 4);
+
+        emitStoreWordImm(&e, OFF_PC, exits[i].pc);
+        if (exits[i].executed > 0)
+        {
+            emitStoreWordImm(&e, OFF_OPCODE, exits[i].lastOpcode);
+        }
+        emit8(&e, 0xB8);
+        emit32(&e, exits[i].executed);
+        emit8(&e, 0xE9); // jmp epílogo
+        emit32(&e, (uint32_t)(int32_t)(epilogue - (e.p + 4)));
+    }
+
+    uint32_t size = (uint32_t)(e.p - entry);
+    jit->codeUsed += size;
+    jit->stats.blocks++;
+
+    Chip8JitCode code;
+    memcpy(&code, &entry, sizeof(code));
+    jitRegisterBlock(jit, start, pc, (uint8_t)count, JIT_BLOCK_READY, code);
+
+    if (jit->perfMap != NULL)
+    {
+        fprintf(jit->perfMap, "%lx %x chip8_block_%03X_%d\n",
+                (unsigned long)(uintptr_t)entry, size, start, count);
+        fflush(jit->perfMap);
+    }
+}
+
+// ============================================================================
+// INVALIDACIÓN
+// ============================================================================
+
+// Descartar el bloque que empieza en start
+static void jitDropBlock(Chip8Jit* jit, uint32_t start)
+{
+    Chip8JitBlock* block = &jit->blocks[start];
+
+    for (uint32_t a = start; a < block->end; a++)
+    {
+        jit->codeRef[a]--;
+    }
+
+    if (block->state == JIT_BLOCK_READY)
+    {
+        jit->stats.invalidations++;
+        if (jit->pageWrites[start >> JIT_PAGE_SHIFT] < UINT16_MAX)
+        {
+            jit->pageWrites[start >> JIT_PAGE_SHIFT]++;
+        }
+    }
+
+    block->state = JIT_BLOCK_NONE;
+    block->code = NULL;
+}
+
+// El intérprete ha escrito en [addr, addr + len): descartar los bloques afectados
+static void jitNotifyWrite(Chip8Jit* jit, uint32_t addr, uint32_t len)
+{
+    uint32_t end = addr + len;
+    if (end > MEMORY_SIZE)
+    {
+        end = MEMORY_SIZE;
+    }
+
+    for (uint32_t a = addr; a < end; a++)
+    {
+        if (jit->codeRef[a] == 0)
+        {
+            continue;
+        }
+
+        // Un bloque cubre como mucho JIT_MAX_BLOCK instrucciones de 2 bytes
+        uint32_t first = (a >= JIT_MAX_BLOCK * 2) ? a - JIT_MAX_BLOCK * 2 + 1 : 0;
+        for (uint32_t s = first; s <= a; s++)
+        {
+            if (jit->blocks[s].state != JIT_BLOCK_NONE && a < jit->blocks[s].end)
+            {
+                jitDropBlock(jit, s);
+            }
+        }
+    }
+}
+
+// Ejecutar una instrucción con el intérprete y seguir sus escrituras en memoria
+static void jitInterpret(Chip8Jit* jit, Chip8* chip8)
+{
+    uint16_t pc = chip8->PC;
+    uint16_t I = chip8->I;
+    uint16_t opcode = 0;
+
+    if (pc < MEMORY_SIZE - 1)
+    {
+        opcode = (chip8->memory[pc] << 8) | chip8->memory[pc + 1];
+    }
+
+    chip8Cycle(chip8);
+    jit->stats.interpInstructions++;
+
+    if ((opcode & 0xF0FF) == 0xF033)
+    {
+        jitNotifyWrite(jit, I, 3);
+    }
+    else if ((opcode & 0xF0FF) == 0xF055)
+    {
+        jitNotifyWrite(jit, I, ((opcode & 0x0F00) >> 8) + 1);
+    }
+}
+
+// ============================================================================
+// API PÚBLICA
+// ============================================================================
+
+bool chip8JitInit(Chip8Jit* jit, bool perfMap)
+{
+    memset(jit, 0, sizeof(*jit));
+
+    void* buffer = mmap(NULL, JIT_CODE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffer == MAP_FAILED)
+    {
+        fprintf(stderr, "JIT: no se pudo reservar memoria ejecutable\n");
+        return false;
+    }
+    jit->codeBuffer = buffer;
+
+    if (perfMap)
+    {
+        char path[64];
+        snprintf(path, sizeof(path), "/tmp/perf-%d.map", (int)getpid());
+        jit->perfMap = fopen(path, "w");
+        if (jit->perfMap == NULL)
+        {
+            fprintf(stderr, "JIT: no se pudo crear %s\n", path);
+        }
+    }
+
+    return true;
+}
+
+static uint32_t jitExecuteSlice(Chip8Jit* jit, Chip8* chip8, uint32_t maxCycles)
+{
+    uint32_t done = 0;
+
+    // Con depuración activa cada instrucción pasa por el intérprete para
+    // conservar la traza completa
+    if (chip8->config.debugLevel >= DEBUG_OPCODES)
+    {
+        for (; done < maxCycles && !chip8->waitingKey; done++)
+        {
+            jitInterpret(jit, chip8);
+        }
+        return done;
+    }
+
+    while (done < maxCycles)
+    {
+        // Detenido en FX0A: el resto del presupuesto no avanzaría nada
+        if (chip8->waitingKey)
+        {
+            break;
+        }
+
+        uint16_t pc = chip8->PC;
+
+        if (pc < MEMORY_SIZE - 1)
+        {
+            Chip8JitBlock* block = &jit->blocks[pc];
+
+            if (block->state == JIT_BLOCK_NONE)
+            {
+                jitCompile(jit, chip8, pc);
+            }
+
+            // El bloque solo se usa si cabe entero en el presupuesto restante
+            if (block->state == JIT_BLOCK_READY && block->count <= maxCycles - done)
+            {
+                uint32_t executed = block->code(chip8);
+                jit->stats.nativeInstructions += executed;
+                done += executed;
+                if (executed > 0)
+                {
+                    continue;
+                }
+            }
+        }
+
+        jitInterpret(jit, chip8);
+        done++;
+    }
+
+    return done;
+}
+
+uint32_t chip8JitExecute(Chip8Jit* jit, Chip8* chip8, uint32_t maxCycles)
+{
+    if (!chip8->config.cycleTimers)
+    {
+        return jitExecuteSlice(jit, chip8, maxCycles);
+    }
+
+    // Temporizadores por instrucciones: tramos que no cruzan un tick, como en
+    // chip8Run. Un bloque solo se usa si cabe en el tramo, así que el tick cae
+    // siempre tras la instrucción exacta. Detenido en FX0A el tiempo emulado
+    // sigue corriendo y se consume el tramo entero
+    uint32_t done = 0;
+    chip8AdvanceTimers(chip8, 0);  // Planificar el primer tick si hace falta
+
+    while (done < maxCycles)
+    {
+        uint32_t slice = maxCycles - done;
+        if (slice > chip8->timerCountdown)
+        {
+            slice = chip8->timerCountdown;
+        }
+
+        uint32_t executed = jitExecuteSlice(jit, chip8, slice);
+        if (chip8->waitingKey)
+        {
+            chip8->idleCycles += slice - executed;
+            executed = slice;
+        }
+
+        done += executed;
+        chip8AdvanceTimers(chip8, executed);
+    }
+
+    return done;
+}
+
+void chip8JitFlush(Chip8Jit* jit)
+{
+    jit->codeUsed = 0;
+    memset(jit->blocks, 0, sizeof(jit->blocks));
+    memset(jit->codeRef, 0, sizeof(jit->codeRef));
+    memset(jit->pageWrites, 0, sizeof(jit->pageWrites));
+}
+
+void chip8JitInvalidate(Chip8Jit* jit, uint32_t addr, uint32_t len)
+{
+    jitNotifyWrite(jit, addr, len);
+}
+
+void chip8JitShutdown(Chip8Jit* jit)
+{
+    if (jit->codeBuffer != NULL)
+    {
+        munmap(jit->codeBuffer, JIT_CODE_SIZE);
+        jit->codeBuffer = NULL;
+    }
+    if (jit->perfMap != NULL)
+    {
+        fclose(jit->perfMap);
+        jit->perfMap = NULL;
+    }
+}
+
+#elif defined(CHIP8_JIT)
+
+// Arquitectura sin generador de código: siempre se usa el intérprete
+
+bool chip8JitInit(Chip8Jit* jit, bool perfMap)
+{
+    (void)jit;
+    (void)perfMap;
+    return false;
+}
+
+uint32_t chip8JitExecute(Chip8Jit* jit, Chip8* chip8, uint32_t maxCycles)
+{
+    (void)jit;
+    for (uint32_t i = 0; i < maxCycles; i++)
+    {
+        chip8Cycle(chip8);
+    }
+    return maxCycles;
+}
+
+void chip8JitFlush(Chip8Jit* jit)
+{
+    (void)jit;
+}
+
+void chip8JitInvalidate(Chip8Jit* jit, uint32_t addr, uint32_t len)
+{
+    (void)jit;
+    (void)addr;
+    (void)len;
+}
+
+void chip8JitShutdown(Chip8Jit* jit)
+{
+    (void)jit;
+}
+
+#endif // CHIP8_JIT
@@ -0,0 +1,80 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "chip8.h"
+
+// Recompilador dinámico (JIT) x86-64 para el núcleo CHIP-8
+//
+// Traduce bloques básicos de la ROM (secuencias que terminan en 1NNN, 2NNN,
+// 00EE, BNNN o en un salto condicional) a código nativo. Dentro de un bloque
+// los registros V usados viven en registros del procesador anfitrión. Las
+// instrucciones con efectos complejos (DXYN, FX0A, CXKK, 00E0, FX33, FX55) y
+// las páginas que se modifican a sí mismas se ejecutan con chip8Cycle.
+//
+// Solo disponible al compilar con CHIP8_JIT (make JIT=1) en x86-64.
+
+#define JIT_MAX_BLOCK 32            // Instrucciones máximas por bloque
+#define JIT_CODE_SIZE (1 << 20)     // Tamaño del buffer de código nativo (1 MB)
+#define JIT_PAGE_SHIFT 8            // Páginas de 256 bytes para detectar código automodificable
+#define JIT_PAGE_COUNT (MEMORY_SIZE >> JIT_PAGE_SHIFT)
+#define JIT_SMC_LIMIT 8             // Invalidaciones tras las que una página se interpreta siempre
+
+// Código nativo de un bloque: devuelve el número de instrucciones ejecutadas
+typedef uint32_t (*Chip8JitCode)(Chip8* chip8);
+
+// Estado de una dirección de inicio de bloque
+typedef enum {
+    JIT_BLOCK_NONE,                 // Sin compilar
+    JIT_BLOCK_READY,                // Bloque nativo disponible
+    JIT_BLOCK_INTERP                // La instrucción se ejecuta con el intérprete
+} Chip8JitBlockState;
+
+// Bloque traducido que empieza en una dirección de la memoria CHIP-8
+typedef struct {
+    Chip8JitCode code;              // Punto de entrada del código nativo
+    uint16_t end;                   // Dirección siguiente al último byte del bloque
+    uint8_t count;                  // Instrucciones CHIP-8 del bloque
+    uint8_t state;                  // Chip8JitBlockState
+} Chip8JitBlock;
+
+// Contadores del JIT
+typedef struct {
+    uint64_t blocks;                // Bloques compilados
+    uint64_t nativeInstructions;    // Instrucciones ejecutadas en código nativo
+    uint64_t interpInstructions;    // Instrucciones ejecutadas con el intérprete
+    uint64_t invalidations;         // Bloques descartados por escrituras en memoria
+    uint64_t flushes;               // Vaciados completos del buffer de código
+} Chip8JitStats;
+
+typedef struct {
+    uint8_t* codeBuffer;            // Memoria ejecutable para el código generado
+    uint32_t codeUsed;              // Bytes ocupados en codeBuffer
+    Chip8JitBlock blocks[MEMORY_SIZE];
+    uint8_t codeRef[MEMORY_SIZE];   // Bloques vivos que cubren cada byte
+    uint16_t pageWrites[JIT_PAGE_COUNT]; // Invalidaciones por página
+    FILE* perfMap;                  // /tmp/perf-<pid>.map (NULL = desactivado)
+    Chip8JitStats stats;
+} Chip8Jit;
+
+// Reservar el buffer de código. Si perfMap es true se escribe /tmp/perf-<pid>.map
+// para que `perf` atribuya el tiempo a cada bloque. Devuelve false si el JIT no
+// está disponible (otra arquitectura o sin memoria ejecutable).
+bool chip8JitInit(Chip8Jit* jit, bool perfMap);
+
+// Ejecutar hasta maxCycles instrucciones; devuelve las ejecutadas
+uint32_t chip8JitExecute(Chip8Jit* jit, Chip8* chip8, uint32_t maxCycles);
+
+// Descartar todo el código generado (tras modificar la memoria desde fuera del núcleo)
+void chip8JitFlush(Chip8Jit* jit);
+
+// Descartar solo los bloques que cubren [addr, addr + len), cuando se sabe
+// qué memoria se ha modificado desde fuera del núcleo
+void chip8JitInvalidate(Chip8Jit* jit, uint32_t addr, uint32_t len);
+
+// Liberar el buffer de código y cerrar el perf map
+void chip8JitShutdown(Chip8Jit* jit);
+
+#endif // JIT_H
@@ -0,0 +1,63 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Historial para rebobinar: un estado guardado por frame en un buffer
+// circular de tamaño fijo
+//
+// Cada REWIND_KEYFRAME_INTERVAL frames se guarda un fotograma clave completo
+// y el resto de frames guardan el XOR de su estado con el del último
+// fotograma clave. Los estados sin comprimir (SaveStateRaw del núcleo) tienen
+// cada campo siempre en la misma posición, así que entre frames cercanos el
+// XOR es casi todo ceros y, comprimido por rachas de ceros, ocupa unas
+// decenas de bytes. Toda la memoria se reserva en rewindInit: guardar un
+// frame y rebobinar no reservan nada. Con el buffer lleno se descartan los
+// frames más antiguos (un fotograma clave junto con sus deltas)
+
+#define REWIND_DEFAULT_MB 16                // Memoria del historial por defecto
+#define REWIND_KEYFRAME_INTERVAL 60         // Frames entre fotogramas clave
+#define REWIND_MAX_FRAMES (60 * 60 * 10)    // Frames como máximo (10 min a 60 fps)
+
+// Frame guardado en el historial
+typedef struct {
+    size_t offset;          // Posición de los datos en pool
+    uint32_t size;          // Bytes comprimidos
+    uint32_t stateSize;     // Bytes del estado sin comprimir
+    uint64_t keySeq;        // Fotograma clave del que es delta (el propio si es clave)
+} RewindEntry;
+
+typedef struct {
+    uint8_t* pool;          // Datos comprimidos de los frames
+    size_t capacity;        // Bytes de pool
+    size_t head;            // Posición del siguiente frame en pool
+    RewindEntry* entries;   // Frames, en orden circular (REWIND_MAX_FRAMES)
+    uint64_t firstSeq;      // Número de secuencia del frame más antiguo
+    uint32_t count;         // Frames guardados
+    uint8_t* keyState;      // Estado sin comprimir del fotograma clave keySeq
+    size_t keySize;
+    uint64_t keySeq;
+    bool keyValid;          // keyState contiene un fotograma clave del historial
+    uint32_t sinceKey;      // Deltas desde el fotograma clave
+    uint8_t* scratch;       // Frame comprimido antes de copiarlo a pool
+    size_t maxStateSize;    // Tamaño máximo de un estado sin comprimir
+} Rewind;
+
+// Reservar un historial de capacity bytes para estados de hasta maxStateSize
+// bytes. Devuelve false si no hay memoria
+bool rewindInit(Rewind* rewind, size_t capacity, size_t maxStateSize);
+void rewindFree(Rewind* rewind);
+
+// Añadir el estado del frame actual (sin comprimir)
+void rewindPush(Rewind* rewind, const uint8_t* state, size_t size);
+
+// Retroceder un frame: descarta el más reciente y escribe en state el
+// anterior (maxStateSize bytes). Devuelve su tamaño, o 0 si no queda historial
+size_t rewindStep(Rewind* rewind, uint8_t* state);
+
+// Vaciar el historial
+void rewindClear(Rewind* rewind);
+
+#endif // REWIND_H
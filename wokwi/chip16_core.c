@@ -22,6 +22,13 @@ const uint8_t CHIP16_FONTSET[FONTSET_SIZE] = {
   0xF0, 0x80, 0xF0, 0x80, 0x80  // F
 };
 
+// Marcar como modificadas count filas a partir de y (con vuelta al borde)
+static inline void chip16_mark_rows(Chip16* chip, unsigned int y, unsigned int count) {
+    uint64_t mask = (count >= CHIP16_HEIGHT) ? 0xFFFFFFFFULL : ((1ULL << count) - 1);
+    mask <<= y;
+    chip->dirtyRows |= (uint32_t)(mask | (mask >> CHIP16_HEIGHT));
+}
+
 //EMULATION INIT
 void chip16_init(Chip16* chip16) {
   memset(chip16, 0, sizeof(Chip16));
@@ -33,6 +40,7 @@ void chip16_init(Chip16* chip16) {
   chip16->config.pixelColor = DEFAULT_PIXEL_COLOR;
   chip16->mode = MODE_8BIT;
   chip16->PC = ROM_LOAD_ADDRESS;
+  chip16->dirtyRows = UINT32_MAX;
   chip16->SP = 0;
   chip16->currentEffect = EFFECT_NONE;
   chip16->colorIndex = 0;
@@ -96,6 +104,11 @@ void chip16_update_timers(Chip16* chip, uint32_t current_time_ms) {
 void chip16_set_key(Chip16* chip, uint8_t key, bool pressed) {
     if (key < KEY_COUNT) {
         chip->key[key] = pressed ? 1 : 0;
+
+        // Una pulsación despierta a un programa detenido en FX0A
+        if (pressed) {
+            chip->waitingKey = false;
+        }
         
         if (chip->config.debugLevel >= DEBUG_VERBOSE) {
             printf("Tecla 0x%X %s\n", key, pressed ? "presionada" : "liberada");
@@ -113,9 +126,8 @@ void chip16_set_effect(Chip16* chip, GraphicsEffect effect) {
     }
 }
 
-void chip16_process_effects(Chip16* chip) {
-    memcpy(chip->gfxEffect, chip->gfx, CHIP16_WIDTH * CHIP16_HEIGHT);
-    
+bool chip16_process_effects(Chip16* chip) {
+    // El ciclo de color solo cambia la paleta: no hace falta copiar gfx
     if (chip->currentEffect == EFFECT_COLOR_CYCLE) {
         chip->effectTimer++;
         if (chip->effectTimer >= COLOR_CYCLE_FRAMES) {
@@ -123,6 +135,7 @@ void chip16_process_effects(Chip16* chip) {
             chip->colorIndex = (chip->colorIndex + 1) % COLOR_PALETTE_SIZE;
         }
     }
+    return false;
 }
 
 //OPCODES
@@ -167,6 +180,7 @@ void chip16_cycle(Chip16* chip) {
             case 0xE0:  // 00E0: CLS - Limpiar pantalla
                 memset(chip->gfx, 0, CHIP16_WIDTH * CHIP16_HEIGHT);
                 memset(chip->gfxEffect, 0, CHIP16_WIDTH * CHIP16_HEIGHT);
+                chip->dirtyRows = UINT32_MAX;
                 chip->drawFlag = true;
                 break;
                 
@@ -465,6 +479,7 @@ void chip16_cycle(Chip16* chip) {
             }
         }
         
+        chip16_mark_rows(chip, yPos, height);
         chip->drawFlag = true;
         break;
     
@@ -561,6 +576,7 @@ void chip16_cycle(Chip16* chip) {
                     }
                 }
                 
+                chip16_mark_rows(chip, yPos, 16);
                 chip->drawFlag = true;
                 break;
             
@@ -603,6 +619,7 @@ void chip16_cycle(Chip16* chip) {
                     }
                 }
                 
+                chip16_mark_rows(chip, yPos, 1);
                 chip->drawFlag = true;
                 break;
             
@@ -629,6 +646,7 @@ void chip16_cycle(Chip16* chip) {
                     }
                 }
                 
+                chip16_mark_rows(chip, yPos, height);
                 chip->drawFlag = true;
                 break;
             
@@ -646,7 +664,9 @@ void chip16_cycle(Chip16* chip) {
                     }
                 }
                 
-                // Si no hay tecla, repetir instrucción
+                // Si no hay tecla, repetir instrucción y quedar detenido
+                // hasta que chip16_set_key registre una pulsación
+                chip->waitingKey = !keyPressed;
                 if (!keyPressed) {
                     chip->PC -= 2;
                 }
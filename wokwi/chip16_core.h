@@ -7,6 +7,11 @@
 #include <stdlib.h>
 #include "chip16_config.h"
 
+// dirtyRows usa un bit por fila
+#if CHIP16_HEIGHT > 32
+#error "dirtyRows requiere CHIP16_HEIGHT <= 32"
+#endif
+
 //HEXADECIMAL FONTSET
 //---------------------
 extern const uint8_t CHIP16_FONTSET[FONTSET_SIZE];
@@ -24,8 +29,9 @@ typedef struct{
   uint8_t memory[MEMORY_SIZE]; //4KB
   // === Display ===
     uint8_t gfx[CHIP16_WIDTH * CHIP16_HEIGHT];        // Framebuffer primario
-    uint8_t gfxEffect[CHIP16_WIDTH * CHIP16_HEIGHT];  // Buffer con efectos
+    uint8_t gfxEffect[CHIP16_WIDTH * CHIP16_HEIGHT];  // Salida de efectos de píxeles
     bool drawFlag;                                     // ¿Necesita redibujar?
+    uint32_t dirtyRows;                                // Bit y = fila y modificada
     
     // === Timers ===
     uint8_t delayTimer;    // Delay Timer(60Hz)
@@ -33,6 +39,7 @@ typedef struct{
     
     // === Input ===
     uint8_t key[KEY_COUNT];  // Hexadecimal Keyset Status
+    bool waitingKey;         // Detenido en FX0A hasta que se pulse una tecla
     
     // === Estado Interno ===
     uint16_t opcode;                // Actual Opcode
@@ -68,7 +75,8 @@ void chip16_set_key(Chip16* chip16, uint8_t key, bool pressed);
 
 //EFFECTS
 void chip16_set_effect(Chip16* chip16, GraphicsEffect effect);
-void chip16_process_effects(Chip16* chip16);
+// Devuelve true si el efecto ha escrito píxeles en gfxEffect; si no, se dibuja gfx
+bool chip16_process_effects(Chip16* chip16);
 
 #ifdef __cplusplus
 }
@@ -65,15 +65,20 @@ void chip16_display_render(Display* display, Chip16* chip) {
     renderCount++;
 
     // Procesar efectos
-    chip16_process_effects(chip);
+    const uint8_t* pixels = chip16_process_effects(chip) ? chip->gfxEffect : chip->gfx;
 
     // Obtener color
     uint16_t pixelColor = chip16_display_get_color(chip);
 
-    // Detectar si toda la pantalla está en negro (CLS)
-    bool allBlack = true;
-    for (int i = 0; i < CHIP16_WIDTH * CHIP16_HEIGHT; i++) {
-        if (chip->gfxEffect[i] != 0) {
+    // Filas tocadas por el núcleo desde el último render
+    uint32_t dirty = chip->dirtyRows;
+    chip->dirtyRows = 0;
+
+    // Detectar si toda la pantalla está en negro (CLS): solo tiene sentido
+    // cuando se ha invalidado la pantalla entera
+    bool allBlack = (dirty == UINT32_MAX);
+    for (int i = 0; allBlack && i < CHIP16_WIDTH * CHIP16_HEIGHT; i++) {
+        if (pixels[i] != 0) {
             allBlack = false;
             break;
         }
@@ -90,19 +95,24 @@ void chip16_display_render(Display* display, Chip16* chip) {
     uint32_t pixelsChanged = 0;
 
     for (int cy = 0; cy < CHIP16_HEIGHT; cy++) {
+        // Las filas sin modificar coinciden con la caché: no hace falta compararlas
+        if ((dirty & (1u << cy)) == 0) {
+            continue;
+        }
+
         for (int cx = 0; cx < CHIP16_WIDTH; cx++) {
             int idx = cx + (cy * CHIP16_WIDTH);
 
             // Solo dibujar si el píxel cambió desde el último frame
-            if (chip->gfxEffect[idx] != display->lastGfx[idx]) {
-                uint16_t color = chip->gfxEffect[idx] ? pixelColor : ILI9341_BLACK;
+            if (pixels[idx] != display->lastGfx[idx]) {
+                uint16_t color = pixels[idx] ? pixelColor : ILI9341_BLACK;
                 uint16_t screenX = cx * PIXEL_SCALE;
                 uint16_t screenY = cy * PIXEL_SCALE;
 
                 tft.fillRect(screenX, screenY, PIXEL_SCALE, PIXEL_SCALE, color);
 
                 // Actualizar cache
-                display->lastGfx[idx] = chip->gfxEffect[idx];
+                display->lastGfx[idx] = pixels[idx];
                 pixelsChanged++;
             }
         }
@@ -263,7 +263,8 @@ void emulation_loop(void) {
     if (cyclesNeeded > 0) {
       if (cyclesNeeded > 20) cyclesNeeded = 20;
 
-      for (uint32_t i = 0; i < cyclesNeeded; i++) {
+      // Detenido en FX0A no se ejecuta nada hasta que se pulse una tecla
+      for (uint32_t i = 0; i < cyclesNeeded && !chip.waitingKey; i++) {
         chip16_cycle(&chip);
       }
 
@@ -278,7 +279,19 @@ void emulation_loop(void) {
     }
 
     // === 5. YIELD ===
-    vTaskDelay(pdMS_TO_TICKS(1));
+    // Detenido en FX0A: dormir hasta el siguiente tick de los timers en lugar
+    // de sondear cada milisegundo (el teclado se vuelve a escanear al despertar)
+    if (chip.waitingKey) {
+      uint64_t sinceTimer = get_time_us() - lastTimerUpdate;
+      uint32_t sleepMs = 1;
+      if (sinceTimer < TIMER_UPDATE_MS * 1000ULL) {
+        sleepMs = (uint32_t)((TIMER_UPDATE_MS * 1000ULL - sinceTimer) / 1000ULL);
+        if (sleepMs == 0) sleepMs = 1;
+      }
+      vTaskDelay(pdMS_TO_TICKS(sleepMs));
+    } else {
+      vTaskDelay(pdMS_TO_TICKS(1));
+    }
     loopCount++;
   }
 }